@@ -97,6 +97,23 @@ public:
    */
   static ETONYEKAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGPresentationInterface *generator);
 
+  /** Parse a range of slides of the input stream content.
+   *
+   * This works like the function above, but only @c slideCount slides,
+   * starting with slide @c firstSlide (counted from 0), are sent to the
+   * generator, together with the master slides they use. The other
+   * slides are skipped without parsing their content, so converting
+   * the first slide takes about the same time for presentations of any
+   * length. This is intended for thumbnails and previews.
+   *
+   * @arg[in] input the input stream
+   * @arg[in] generator a librevenge::RVNGPresentationInterface implementation
+   * @arg[in] firstSlide the index of the first slide to parse
+   * @arg[in] slideCount the number of slides to parse
+   * @returns a value that indicates whether the parsing was successful
+   */
+  static ETONYEKAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGPresentationInterface *generator, unsigned firstSlide, unsigned slideCount);
+
   /** Parse the input stream content.
    *
    * It will make callbacks to the functions provided by a
@@ -120,6 +137,50 @@ public:
    * @returns a value that indicates whether the parsing was successful
    */
   static ETONYEKAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document);
+
+  /** Parse a range of pages of the input stream content.
+   *
+   * This works like the function above, but only the content of
+   * @c pageCount pages, starting with page @c firstPage (counted from
+   * 0), is sent to the generator. Objects placed on other pages are
+   * skipped without parsing them. The body text cannot be cut at page
+   * boundaries, because the text is laid out by the consumer. As every
+   * section starts on a new page, the sections that start after the
+   * range are skipped, while the sections before it are kept. This is
+   * intended for thumbnails and previews.
+   *
+   * @arg[in] input the input stream
+   * @arg[in] generator a librevenge::RVNGTextInterface implementation
+   * @arg[in] firstPage the index of the first page to parse
+   * @arg[in] pageCount the number of pages to parse
+   * @returns a value that indicates whether the parsing was successful
+   */
+  static ETONYEKAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *document, unsigned firstPage, unsigned pageCount);
+
+  /** Get the preview image stored in the document.
+   *
+   * Documents saved by iWork usually contain a small rendering of the
+   * first slide or page. This returns it without parsing the document,
+   * which makes it much cheaper than a conversion. The input must be
+   * the whole package, not just the main file.
+   *
+   * @arg[in] input the input stream
+   * @arg[out] data the image
+   * @arg[out] mimeType the mime type of the image (e.g., image/jpeg)
+   * @returns true if a preview has been found
+   */
+  static ETONYEKAPI bool getPreview(librevenge::RVNGInputStream *input, librevenge::RVNGBinaryData &data, librevenge::RVNGString &mimeType);
+
+  /** Load data that is shared by all parsed documents.
+   *
+   * The data (e.g., the language database) is otherwise loaded during
+   * the first parse that needs it. An application that converts many
+   * documents can call this once at startup to make the time of the
+   * first conversion predictable.
+   *
+   * It is safe to call this function repeatedly and from more threads.
+   */
+  static ETONYEKAPI void warmUp();
 };
 
 } // namespace libetonyek
@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <librevenge/librevenge.h>
+
+#include "IWORKFormula.h"
+
+namespace
+{
+
+using libetonyek::IWORKFormula;
+
+void write(const IWORKFormula &formula, const unsigned hc, IWORKFormula::WriteCache *const cache, librevenge::RVNGPropertyListVector &props)
+{
+  const libetonyek::IWORKTableNameMapPtr_t tableNameMap;
+  formula.write(hc, props, tableNameMap, cache);
+}
+
+bool same(const librevenge::RVNGPropertyListVector &props1, const librevenge::RVNGPropertyListVector &props2)
+{
+  if (props1.count() != props2.count())
+    return false;
+  for (unsigned long i = 0; i != props1.count(); ++i)
+  {
+    if (props1[i].getPropString() != props2[i].getPropString())
+      return false;
+  }
+  return true;
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  const std::string text(reinterpret_cast<const char *>(data), size);
+
+  IWORKFormula::Cache cache;
+  IWORKFormula formula(0x101u);
+  const bool parsed = formula.parse(text);
+  IWORKFormula cached(0x101u);
+  // the cached and the uncached parse must agree, the second time too
+  if ((parsed != cached.parse(text, &cache)) || (parsed != cached.parse(text, &cache)))
+    std::abort();
+  if (!parsed)
+    return 0;
+
+  if (formula.str(0x202u) != cached.str(0x202u))
+    std::abort();
+
+  // writing from a cached template must give the same result
+  IWORKFormula::WriteCache writeCache;
+  for (const unsigned hc : { 0x101u, 0x202u, 0x100u })
+  {
+    librevenge::RVNGPropertyListVector props1;
+    write(formula, hc, nullptr, props1);
+    librevenge::RVNGPropertyListVector props2;
+    write(cached, hc, &writeCache, props2);
+    if (!same(props1, props2))
+      std::abort();
+  }
+
+  return 0;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
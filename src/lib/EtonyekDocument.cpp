@@ -11,6 +11,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <limits>
 #include <memory>
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -22,6 +23,8 @@
 #include "libetonyek_xml.h"
 #include "IWAMessage.h"
 #include "IWASnappyStream.h"
+#include "IWORKLanguageManager.h"
+#include "IWORKMappedPackageStream.h"
 #include "IWORKPresentationRedirector.h"
 #include "IWORKSpreadsheetRedirector.h"
 #include "IWORKSubDirStream.h"
@@ -312,6 +315,65 @@ RVNGInputStreamPtr_t queryTopDirStream(const RVNGInputStreamPtr_t &input)
   return stream;
 }
 
+/// Names of embedded previews, from the best to the worst.
+const char *const PREVIEW_NAMES[] =
+{
+  "preview.jpg", // v6+
+  "QuickLook/Thumbnail.jpg", // v2-5
+  "preview-web.jpg", // v6+
+  "preview-micro.jpg" // v6+
+};
+
+/** Find the best embedded preview of a known type.
+  *
+  * A preview whose type is not recognized is skipped.
+  */
+RVNGInputStreamPtr_t findPreview(const RVNGInputStreamPtr_t &package, std::string &mimeType)
+{
+  for (const char *const name : PREVIEW_NAMES)
+  {
+    if (!package->existsSubStream(name))
+      continue;
+    const RVNGInputStreamPtr_t preview = getSubStream(package, name);
+    if (!preview)
+      continue;
+    mimeType = detectMimetype(preview);
+    if (!mimeType.empty())
+      return preview;
+    ETONYEK_DEBUG_MSG(("findPreview: unknown type of preview %s\n", name));
+  }
+  return RVNGInputStreamPtr_t();
+}
+
+/** Read a zip package from memory instead of through @c input.
+  *
+  * The central directory is then parsed only once and the stored
+  * members, e.g., the .iwa files, are read in place. Any other input
+  * is returned unchanged.
+  */
+RVNGInputStreamPtr_t mapPackage(const RVNGInputStreamPtr_t &input)
+{
+  if (input->seek(0, RVNG_SEEK_SET) != 0)
+    return input;
+  unsigned long numBytesRead = 0;
+  const unsigned char *const signature = input->read(4, numBytesRead);
+  const bool zip = IWORKMappedPackageStream::isZip(signature, numBytesRead);
+  input->seek(0, RVNG_SEEK_SET);
+  if (!zip)
+    return input;
+
+  try
+  {
+    return std::make_shared<IWORKMappedPackageStream>(input);
+  }
+  catch (...)
+  {
+    ETONYEK_DEBUG_MSG(("mapPackage: failed to read the zip package\n"));
+  }
+  input->seek(0, RVNG_SEEK_SET);
+  return input;
+}
+
 bool detect(const RVNGInputStreamPtr_t &input, DetectionInfo &info)
 {
   if (input->isStructured())
@@ -445,20 +507,27 @@ catch (...)
   return CONFIDENCE_NONE;
 }
 
-ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGPresentationInterface *const generator) try
+ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGPresentationInterface *const generator)
+{
+  return parse(input, generator, 0, std::numeric_limits<unsigned>::max());
+}
+
+ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGPresentationInterface *const generator,
+                                       const unsigned firstSlide, const unsigned slideCount) try
 {
   if (!input || !generator)
     return false;
 
   DetectionInfo info(EtonyekDocument::TYPE_KEYNOTE);
 
-  if (!detect(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter()), info))
+  if (!detect(mapPackage(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter())), info))
     return false;
 
   info.m_input->seek(0, librevenge::RVNG_SEEK_SET);
 
   IWORKPresentationRedirector redirector(generator);
   KEYCollector collector(&redirector);
+  collector.setSlideRange(firstSlide, slideCount);
   if (info.m_format == FORMAT_XML1)
   {
     KEY1Dictionary dict;
@@ -493,7 +562,7 @@ ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input,
 
   DetectionInfo info(EtonyekDocument::TYPE_NUMBERS);
 
-  if (!detect(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter()), info))
+  if (!detect(mapPackage(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter())), info))
     return false;
 
   info.m_input->seek(0, librevenge::RVNG_SEEK_SET);
@@ -520,20 +589,27 @@ catch (...)
   return false;
 }
 
-ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document) try
+ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document)
+{
+  return parse(input, document, 0, std::numeric_limits<unsigned>::max());
+}
+
+ETONYEKAPI bool EtonyekDocument::parse(librevenge::RVNGInputStream *const input, librevenge::RVNGTextInterface *const document,
+                                       const unsigned firstPage, const unsigned pageCount) try
 {
   if (!input || !document)
     return false;
 
   DetectionInfo info(EtonyekDocument::TYPE_PAGES);
 
-  if (!detect(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter()), info))
+  if (!detect(mapPackage(RVNGInputStreamPtr_t(input, EtonyekDummyDeleter())), info))
     return false;
 
   info.m_input->seek(0, librevenge::RVNG_SEEK_SET);
 
   IWORKTextRedirector redirector(document);
   PAGCollector collector(&redirector);
+  collector.setPageRange(firstPage, pageCount);
   if (info.m_format == FORMAT_XML2)
   {
     PAG1Dictionary dict;
@@ -554,6 +630,48 @@ catch (...)
   return false;
 }
 
+ETONYEKAPI bool EtonyekDocument::getPreview(librevenge::RVNGInputStream *const input, librevenge::RVNGBinaryData &data, librevenge::RVNGString &mimeType) try
+{
+  if (!input || !input->isStructured())
+    return false;
+
+  const RVNGInputStreamPtr_t package(input, EtonyekDummyDeleter());
+  std::string type;
+  RVNGInputStreamPtr_t preview = findPreview(package, type);
+  if (!preview)
+  {
+    // a zipped package directory
+    const RVNGInputStreamPtr_t dir = queryTopDirStream(package);
+    if (dir)
+      preview = findPreview(dir, type);
+  }
+  if (!preview)
+    return false;
+
+  const unsigned long size = getLength(preview);
+  preview->seek(0, RVNG_SEEK_SET);
+  unsigned long readBytes = 0;
+  const unsigned char *const bytes = preview->read(size, readBytes);
+  if (!bytes || readBytes != size)
+    return false;
+
+  data = librevenge::RVNGBinaryData(bytes, size);
+  mimeType = type.c_str();
+  return true;
+}
+catch (...)
+{
+  return false;
+}
+
+ETONYEKAPI void EtonyekDocument::warmUp() try
+{
+  IWORKLanguageManager::warmUp();
+}
+catch (...)
+{
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -13,6 +13,7 @@
 
 #include "IWAMessage.h"
 #include "IWASnappyStream.h"
+#include "IWORKMemoryStream.h"
 #include "IWORKTypes.h"
 
 #include "IWAParser.h"
@@ -35,7 +36,7 @@ IWAObjectIndex::ObjectRecord::ObjectRecord()
 {
 }
 
-IWAObjectIndex::ObjectRecord::ObjectRecord(const RVNGInputStreamPtr_t &stream, const unsigned type,
+IWAObjectIndex::ObjectRecord::ObjectRecord(const std::shared_ptr<IWORKMemoryStream> &stream, const unsigned type,
                                            const long pos, const unsigned long headerLen, const unsigned long dataLen)
   : m_stream(stream)
   , m_type(type)
@@ -47,7 +48,10 @@ IWAObjectIndex::ObjectRecord::ObjectRecord(const RVNGInputStreamPtr_t &stream, c
 IWAObjectIndex::IWAObjectIndex(const RVNGInputStreamPtr_t &fragments, const RVNGInputStreamPtr_t &package)
   : m_fragments(fragments)
   , m_package(package)
+  , m_mutex()
+  , m_fragmentScanned()
   , m_unparsedFragments()
+  , m_scanningFragments()
   , m_fragmentObjectMap()
   , m_fileMap()
   , m_fileColorMap()
@@ -56,9 +60,10 @@ IWAObjectIndex::IWAObjectIndex(const RVNGInputStreamPtr_t &fragments, const RVNG
 
 void IWAObjectIndex::parse()
 {
+  std::unique_lock<std::mutex> lock(m_mutex);
   m_unparsedFragments[2] = "Index/Metadata.iwa";
   m_fragmentObjectMap[2] = make_pair(2, ObjectRecord());
-  scanFragment(2);
+  scanFragment(2, lock);
   const auto indexIt = m_fragmentObjectMap.find(2);
   if (indexIt == m_fragmentObjectMap.end() || !indexIt->second.second.m_stream)
   {
@@ -98,7 +103,7 @@ void IWAObjectIndex::parse()
         else if (!virtualPath.empty() && m_package->existsSubStream(virtualPath.c_str()))
           path = virtualPath;
         if (!path.empty())
-          m_fileMap[file.uint32(1).get()] = make_pair(path, RVNGInputStreamPtr_t());
+          m_fileMap[file.uint32(1).get()] = make_pair(path, std::shared_ptr<IWORKMemoryStream>());
       }
     }
 
@@ -122,35 +127,26 @@ void IWAObjectIndex::parse()
 
 void IWAObjectIndex::queryObject(const unsigned id, unsigned &type, boost::optional<IWAMessage> &msg) const
 {
-  const auto recIt = m_fragmentObjectMap.find(id);
-  if (recIt == m_fragmentObjectMap.end())
+  ObjectRecord objRecord;
+  if (findObject(id, objRecord))
   {
-    ETONYEK_DEBUG_MSG(("IWAObjectIndex::queryObject: object %u not found\n", id));
-    return;
-  }
-  if (!recIt->second.second.m_stream)
-    const_cast<IWAObjectIndex *>(this)->scanFragment(recIt->second.first);
-  if (recIt->second.second.m_stream)
-  {
-    const ObjectRecord &objRecord = recIt->second.second;
-    msg = IWAMessage(objRecord.m_stream, objRecord.m_dataRange.first, objRecord.m_dataRange.second);
+    msg = IWAMessage(IWORKMemoryStream::makeView(objRecord.m_stream), objRecord.m_dataRange.first, objRecord.m_dataRange.second);
     type = objRecord.m_type;
   }
 }
 
 boost::optional<unsigned> IWAObjectIndex::getObjectType(const unsigned id) const
 {
-  // improve me
-  boost::optional<IWAMessage> msg;
-  unsigned type=0; // for g++-7
-  queryObject(id, type, msg);
-  if (!msg)
+  ObjectRecord objRecord;
+  if (!findObject(id, objRecord))
     return boost::none;
-  return type;
+  return objRecord.m_type;
 }
 
 const RVNGInputStreamPtr_t IWAObjectIndex::queryFile(const unsigned id) const
 {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+
   const auto it = m_fileMap.find(id);
 
   if (it == m_fileMap.end())
@@ -162,33 +158,80 @@ const RVNGInputStreamPtr_t IWAObjectIndex::queryFile(const unsigned id) const
   if (!it->second.second && m_package)
   {
     assert(m_package->existsSubStream(it->second.first.c_str())); // we already checked for its presence
-    it->second.second.reset(m_package->getSubStreamByName(it->second.first.c_str()));
+    const RVNGInputStreamPtr_t stream(m_package->getSubStreamByName(it->second.first.c_str()));
+    if (stream)
+    {
+      it->second.second = std::dynamic_pointer_cast<IWORKMemoryStream>(stream);
+      if (!it->second.second)
+        it->second.second = make_shared<IWORKMemoryStream>(stream);
+    }
   }
 
-  return it->second.second;
+  if (!it->second.second)
+    return RVNGInputStreamPtr_t();
+  // the file can be used by several parsers at once
+  return IWORKMemoryStream::makeView(it->second.second);
 }
 
-void IWAObjectIndex::scanFragment(const unsigned id)
+bool IWAObjectIndex::findObject(const unsigned id, ObjectRecord &record) const
 {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  const auto recIt = m_fragmentObjectMap.find(id);
+  if (recIt == m_fragmentObjectMap.end())
+  {
+    ETONYEK_DEBUG_MSG(("IWAObjectIndex::findObject: object %u not found\n", id));
+    return false;
+  }
+  if (!recIt->second.second.m_stream)
+    scanFragment(recIt->second.first, lock);
+  if (!recIt->second.second.m_stream)
+    return false;
+  record = recIt->second.second;
+  return true;
+}
+
+void IWAObjectIndex::scanFragment(const unsigned id, std::unique_lock<std::mutex> &lock) const
+{
+  while (m_scanningFragments.find(id) != m_scanningFragments.end())
+    m_fragmentScanned.wait(lock);
+
   // scan the fragment file
   const auto fragmentIt = m_unparsedFragments.find(id);
-  if (fragmentIt != m_unparsedFragments.end())
+  if (fragmentIt == m_unparsedFragments.end())
+    return;
+  const RVNGInputStreamPtr_t stream(m_fragments->getSubStreamByName(fragmentIt->second.c_str()));
+  if (!stream)
   {
-    const RVNGInputStreamPtr_t stream(m_fragments->getSubStreamByName(fragmentIt->second.c_str()));
-    if (stream)
-    {
-      const auto fragment = make_shared<IWASnappyStream>(stream);
-      scanFragment(fragmentIt->first, fragment);
-    }
-    else
-    {
-      ETONYEK_DEBUG_MSG(("IWAObjectIndex::scanFragment: file %s does not exist\n", fragmentIt->second.c_str()));
-    }
+    ETONYEK_DEBUG_MSG(("IWAObjectIndex::scanFragment: file %s does not exist\n", fragmentIt->second.c_str()));
     m_unparsedFragments.erase(fragmentIt);
+    return;
+  }
+  m_unparsedFragments.erase(fragmentIt);
+  m_scanningFragments.insert(id);
+
+  lock.unlock();
+  ObjectRecordList_t objects;
+  try
+  {
+    scanFragment(IWASnappyStream::uncompress(stream), objects);
+  }
+  catch (...)
+  {
+    lock.lock();
+    m_scanningFragments.erase(id);
+    m_fragmentScanned.notify_all();
+    throw;
   }
+  lock.lock();
+
+  for (const auto &object : objects)
+    m_fragmentObjectMap[object.first] = make_pair(id, object.second);
+  m_scanningFragments.erase(id);
+  m_fragmentScanned.notify_all();
 }
 
-void IWAObjectIndex::scanFragment(const unsigned id, const RVNGInputStreamPtr_t &stream)
+void IWAObjectIndex::scanFragment(const std::shared_ptr<IWORKMemoryStream> &stream, ObjectRecordList_t &objects)
 try
 {
   while (!stream->isEnd())
@@ -214,7 +257,7 @@ try
     if (header.uint32(1))
     {
       const ObjectRecord rec(stream, get_optional_value_or(type, 0), start, (unsigned long)(headerLen), (unsigned long)(dataLen));
-      m_fragmentObjectMap[header.uint32(1).get()] = make_pair(id, rec);
+      objects.push_back(make_pair(header.uint32(1).get(), rec));
     }
     if (stream->seek(start + long(headerLen) + long(dataLen), librevenge::RVNG_SEEK_SET) != 0)
       break;
@@ -10,7 +10,12 @@
 #ifndef IWAOBJECTINDEX_H_INCLUDED
 #define IWAOBJECTINDEX_H_INCLUDED
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -22,16 +27,23 @@ namespace libetonyek
 {
 
 class IWAMessage;
-
+class IWORKMemoryStream;
+
+/** Index of the objects and files of an IWA document.
+  *
+  * Queries can be made from several threads at once. Every returned
+  * message and file reads from its own stream, sharing the data with
+  * the index.
+  */
 class IWAObjectIndex
 {
 public:
   struct ObjectRecord
   {
     ObjectRecord();
-    ObjectRecord(const RVNGInputStreamPtr_t &stream, unsigned type, long pos, unsigned long headerLen, unsigned long dataLen);
+    ObjectRecord(const std::shared_ptr<IWORKMemoryStream> &stream, unsigned type, long pos, unsigned long headerLen, unsigned long dataLen);
 
-    RVNGInputStreamPtr_t m_stream;
+    std::shared_ptr<IWORKMemoryStream> m_stream;
     unsigned m_type;
     std::pair<long, long> m_headerRange;
     std::pair<long, long> m_dataRange;
@@ -48,8 +60,17 @@ public:
   boost::optional<IWORKColor> queryFileColor(unsigned id) const;
 
 private:
-  void scanFragment(unsigned id);
-  void scanFragment(unsigned id, const RVNGInputStreamPtr_t &stream);
+  typedef std::deque<std::pair<unsigned, ObjectRecord>> ObjectRecordList_t;
+
+  bool findObject(unsigned id, ObjectRecord &record) const;
+
+  /** Scan a fragment file, unless it is already done.
+    *
+    * The fragment is uncompressed and scanned without holding @c lock,
+    * so other threads can continue to query already scanned fragments.
+    */
+  void scanFragment(unsigned id, std::unique_lock<std::mutex> &lock) const;
+  static void scanFragment(const std::shared_ptr<IWORKMemoryStream> &stream, ObjectRecordList_t &objects);
 
   void scanColorFileMap(unsigned id);
   boost::optional<IWORKColor> scanColorFileCorrespondance(unsigned id);
@@ -57,9 +78,16 @@ private:
   const RVNGInputStreamPtr_t m_fragments;
   const RVNGInputStreamPtr_t m_package;
 
+  /// Guards the maps and the access to the package.
+  mutable std::mutex m_mutex;
+  /// Signalled when a fragment has been scanned.
+  mutable std::condition_variable m_fragmentScanned;
+
   mutable std::map<unsigned, std::string> m_unparsedFragments;
+  /// Fragments being scanned by some thread.
+  mutable std::set<unsigned> m_scanningFragments;
   mutable std::map<unsigned, std::pair<unsigned, ObjectRecord>> m_fragmentObjectMap;
-  mutable std::map<unsigned, std::pair<std::string, RVNGInputStreamPtr_t>> m_fileMap;
+  mutable std::map<unsigned, std::pair<std::string, std::shared_ptr<IWORKMemoryStream>>> m_fileMap;
   mutable std::map<unsigned, IWORKColor> m_fileColorMap;
 };
 
@@ -10,11 +10,13 @@
 #include "IWAParser.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <utility>
 
@@ -169,8 +171,33 @@ IWAParser::IWAParser(const RVNGInputStreamPtr_t &fragments, const RVNGInputStrea
   , m_tableNameMap(std::make_shared<IWORKTableNameMap_t>())
   , m_currentText()
   , m_collector(collector)
-  , m_index(fragments, package)
+  , m_index(make_shared<IWAObjectIndex>(fragments, package))
   , m_visited()
+  , m_styles(make_shared<StyleCache>())
+  , m_currentTable()
+  , m_uidFormatMap()
+  , m_tableUUIDs()
+{
+}
+
+IWAParser::IWAParser(const IWAParser &parent, IWORKCollector &collector)
+  : m_formatNameMap(parent.m_formatNameMap)
+  , m_langManager()
+  // the parsers must not add table names to the same map
+  , m_tableNameMap(std::make_shared<IWORKTableNameMap_t>(*parent.m_tableNameMap))
+  , m_currentText()
+  , m_collector(collector)
+  , m_index(parent.m_index)
+  , m_visited()
+  , m_styles(parent.m_styles)
+  , m_currentTable()
+  , m_uidFormatMap(parent.m_uidFormatMap)
+  , m_tableUUIDs()
+{
+}
+
+IWAParser::StyleCache::StyleCache()
+  : m_mutex()
   , m_charStyles()
   , m_dropCapStyles()
   , m_paraStyles()
@@ -180,8 +207,6 @@ IWAParser::IWAParser(const RVNGInputStreamPtr_t &fragments, const RVNGInputStrea
   , m_cellStyles()
   , m_tableStyles()
   , m_listStyles()
-  , m_currentTable()
-  , m_uidFormatMap()
 {
 }
 
@@ -248,17 +273,17 @@ unsigned IWAParser::ObjectMessage::getType() const
 
 void IWAParser::queryObject(const unsigned id, unsigned &type, boost::optional<IWAMessage> &msg) const
 {
-  m_index.queryObject(id, type, msg);
+  m_index->queryObject(id, type, msg);
 }
 
 boost::optional<unsigned> IWAParser::getObjectType(const unsigned id) const
 {
-  return m_index.getObjectType(id);
+  return m_index->getObjectType(id);
 }
 
 const RVNGInputStreamPtr_t IWAParser::queryFile(const unsigned id) const
 {
-  return m_index.queryFile(id);
+  return m_index->queryFile(id);
 }
 
 boost::optional<unsigned> IWAParser::readRef(const IWAMessage &msg, const unsigned field)
@@ -373,6 +398,28 @@ boost::optional<std::string> IWAParser::readUUID(const IWAMessage &msg, const un
   return boost::none;
 }
 
+const std::shared_ptr<const std::string> &IWAParser::readTableUUID(const IWAMessage &msg, const unsigned field)
+{
+  static const std::shared_ptr<const std::string> noTable;
+  const IWAMessageField &mId = msg.message(field);
+  if (!mId) return noTable;
+  auto const &id = get(mId).message(1);
+  if (!id || !get(id).uint32(2) || !get(id).uint32(3) || !get(id).uint32(4) || !get(id).uint32(5))
+  {
+    readUUID(msg, field);
+    return noTable;
+  }
+  const auto key=std::make_pair((uint64_t(get(get(id).uint32(2)))<<32) | get(get(id).uint32(3)),
+                                (uint64_t(get(get(id).uint32(4)))<<32) | get(get(id).uint32(5)));
+  auto it=m_tableUUIDs.find(key);
+  if (it==m_tableUUIDs.end())
+  {
+    const optional<std::string> uuid=readUUID(msg, field);
+    it=m_tableUUIDs.insert(std::make_pair(key, uuid ? std::make_shared<const std::string>(get(uuid)) : noTable)).first;
+  }
+  return it->second;
+}
+
 void IWAParser::readStroke(const IWAMessage &msg, IWORKStroke &stroke)
 {
   const optional<IWORKColor> &color = readColor(msg, 1);
@@ -493,7 +540,7 @@ bool IWAParser::readFill(const IWAMessage &msg, IWORKFill &fill)
       // find also 16 with no file...
       bitmap.m_data = std::make_shared<IWORKData>();
       bitmap.m_data->m_stream = queryFile(get(fileRef));
-      if (!bitmap.m_data->m_stream && !bitmap.m_fillColor) bitmap.m_fillColor = m_index.queryFileColor(get(fileRef));
+      if (!bitmap.m_data->m_stream && !bitmap.m_fillColor) bitmap.m_fillColor = m_index->queryFileColor(get(fileRef));
     }
     fill = bitmap;
     return true;
@@ -605,10 +652,9 @@ bool IWAParser::dispatchShapeWithMessage(const IWAMessage &msg, unsigned type)
     return parseTabularInfo(msg);
   default:
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
-      first=false;
       ETONYEK_DEBUG_MSG(("IWAParser::dispatchShape: find some unknown shapes, type=%d\n", int(type)));
     }
   }
@@ -671,7 +717,7 @@ void IWAParser::updateGeometryUsingTextRef(unsigned id, IWORKGeometry &geometry,
   }
 }
 
-bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const std::function<void(unsigned, IWORKStylePtr_t)> &openPageFunction)
+bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const std::function<bool(unsigned, IWORKStylePtr_t)> &openPageFunction)
 {
   assert(bool(m_currentText));
   const ObjectMessage msg(*this, id);
@@ -692,7 +738,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
     ETONYEK_DEBUG_MSG(("IWAParser::parseText: unexpected object type, type=%d\n", int(msg.getType())));
     return false;
   }
-  std::multimap<unsigned, std::function<void(unsigned, bool &)> > attachments;
+  IWAText::Attachments_t attachments;
   const IWAStringField &text = get(msg).string(3);
   // fixme: in Numbers, if text does not exists, the default text string is still displayed
   if (text || (openPageFunction && get(msg).message(17)))
@@ -704,7 +750,8 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
 
     if (get(msg).message(5))
     {
-      map<unsigned, IWORKStylePtr_t> paras;
+      IWAText::StyleRuns_t paras;
+      paras.reserve(get(msg).message(5).message(1).size());
       IWORKStylePtr_t style = make_shared<IWORKStyle>(IWORKPropertyMap(), none, none);
       for (const auto &it : get(msg).message(5).message(1))
       {
@@ -717,26 +764,28 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
             if (bool(newStyle))
               style = newStyle;
           }
-          paras.insert(paras.end(), make_pair(get(it.uint32(1)), style));
+          paras.push_back(make_pair(get(it.uint32(1)), style));
         }
       }
-      textParser.setParagraphs(paras);
+      textParser.setParagraphs(std::move(paras));
     }
 
     if (get(msg).message(6))
     {
-      map<unsigned, unsigned> levels;
+      IWAText::UIntRuns_t levels;
+      levels.reserve(get(msg).message(6).message(1).size());
       for (const auto &it : get(msg).message(6).message(1))
       {
         if (it.uint32(1) && (get(it.uint32(1)) < length))
-          levels.insert(levels.end(), make_pair(get(it.uint32(1)), get_optional_value_or(it.uint32(2), 0)));
+          levels.push_back(make_pair(get(it.uint32(1)), get_optional_value_or(it.uint32(2), 0)));
       }
-      textParser.setListLevels(levels);
+      textParser.setListLevels(std::move(levels));
     }
 
     if (get(msg).message(7))
     {
-      map<unsigned, IWORKStylePtr_t> lists;
+      IWAText::StyleRuns_t lists;
+      lists.reserve(get(msg).message(7).message(1).size());
       for (const auto &it : get(msg).message(7).message(1))
       {
         if (it.uint32(1) && (get(it.uint32(1)) < length))
@@ -745,15 +794,16 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
           const optional<unsigned> &styleRef = readRef(it, 2);
           if (styleRef)
             style = queryListStyle(get(styleRef));
-          lists.insert(lists.end(), make_pair(get(it.uint32(1)), style));
+          lists.push_back(make_pair(get(it.uint32(1)), style));
         }
       }
-      textParser.setLists(lists);
+      textParser.setLists(std::move(lists));
     }
 
     if (get(msg).message(8))
     {
-      map<unsigned, IWORKStylePtr_t> spans;
+      IWAText::StyleRuns_t spans;
+      spans.reserve(get(msg).message(8).message(1).size());
       for (const auto &it : get(msg).message(8).message(1))
       {
         if (it.uint32(1) && (get(it.uint32(1)) < length))
@@ -762,10 +812,10 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
           const optional<unsigned> &styleRef = readRef(it, 2);
           if (styleRef)
             style = queryCharacterStyle(get(styleRef));
-          spans.insert(spans.end(), make_pair(get(it.uint32(1)), style));
+          spans.push_back(make_pair(get(it.uint32(1)), style));
         }
       }
-      textParser.setSpans(spans);
+      textParser.setSpans(std::move(spans));
     }
     if (get(msg).message(9))
     {
@@ -784,7 +834,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         switch (attachment.getType())
         {
         case IWAObjectType::NoteStart: // the first character of a note seems special, so ...
-          attachments.insert(make_pair(get(it.uint32(1)), [](unsigned, bool &ignore)
+          attachments.push_back(make_pair(get(it.uint32(1)), [](unsigned, bool &ignore)
           {
             ignore=true;
           }));
@@ -798,7 +848,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
             switch (get(field.uint32(2)))
             {
             case 0:
-              attachments.insert(make_pair(get(it.uint32(1)),
+              attachments.push_back(make_pair(get(it.uint32(1)),
                                            [this](unsigned, bool &ignore)
               {
                 ignore=true;
@@ -806,7 +856,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
               }));
               break;
             case 1:
-              attachments.insert(make_pair(get(it.uint32(1)),
+              attachments.push_back(make_pair(get(it.uint32(1)),
                                            [this](unsigned, bool &ignore)
               {
                 ignore=true;
@@ -826,7 +876,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
             ETONYEK_DEBUG_MSG(("IWAParser::parseText[9]: find unexpected shape's attachment at pos=%d\n", int(get(it.uint32(1)))));
           }
           else
-            attachments.insert(make_pair(get(it.uint32(1)),
+            attachments.push_back(make_pair(get(it.uint32(1)),
                                          [this,ref](unsigned, bool &ignore)
           {
             ignore=true;
@@ -843,7 +893,8 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
     if (get(msg).message(11))
     {
       // placeholder:2031 or link:2032 or time field:2034
-      map<unsigned, string> links;
+      IWAText::StringRuns_t links;
+      links.reserve(get(msg).message(11).message(1).size());
       for (const auto &it : get(msg).message(11).message(1))
       {
         if (it.uint32(1))
@@ -852,14 +903,15 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
           const optional<unsigned> &linkRef = readRef(it, 2);
           if (linkRef)
             parseLink(get(linkRef), url);
-          links.insert(links.end(), make_pair(get(it.uint32(1)), url));
+          links.push_back(make_pair(get(it.uint32(1)), url));
         }
       }
-      textParser.setLinks(links);
+      textParser.setLinks(std::move(links));
     }
     if (openPageFunction && get(msg).message(12))
     {
-      map<unsigned, IWORKStylePtr_t> sections;
+      IWAText::StyleRuns_t sections;
+      sections.reserve(get(msg).message(12).message(1).size());
       for (const auto &it : get(msg).message(12).message(1))
       {
         if (!it.uint32(1)) continue;
@@ -867,9 +919,9 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         if (!sectionRef) continue;
         const IWORKStylePtr_t &sectionStyle = querySectionStyle(get(sectionRef));
         if (sectionStyle)
-          sections.insert(sections.end(), make_pair(get(it.uint32(1)), sectionStyle));
+          sections.push_back(make_pair(get(it.uint32(1)), sectionStyle));
       }
-      textParser.setSections(sections);
+      textParser.setSections(std::move(sections));
     }
     if (get(msg).message(16))
     {
@@ -883,7 +935,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         auto textRef=readRef(get(noteMsg), 2);
         if (textRef)
         {
-          attachments.insert(make_pair(get(it.uint32(1)),
+          attachments.push_back(make_pair(get(it.uint32(1)),
                                        [this,createNoteAsFootnote,textRef](unsigned, bool &ignore)
           {
             ignore=true;
@@ -912,7 +964,8 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
     }
     if (openPageFunction && get(msg).message(17))
     {
-      map<unsigned, IWORKStylePtr_t> pageMasters;
+      IWAText::StyleRuns_t pageMasters;
+      pageMasters.reserve(get(msg).message(17).message(1).size());
       for (const auto &it : get(msg).message(17).message(1))
       {
         if (!it.uint32(1)) continue;
@@ -920,36 +973,39 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         if (!pageMasterRef) continue;
         PageMaster pageMaster;
         parsePageMaster(get(pageMasterRef), pageMaster);
-        pageMasters.insert(pageMasters.end(), make_pair(get(it.uint32(1)), pageMaster.m_style));
+        pageMasters.push_back(make_pair(get(it.uint32(1)), pageMaster.m_style));
       }
-      textParser.setPageMasters(pageMasters);
+      textParser.setPageMasters(std::move(pageMasters));
     }
     if (get(msg).message(19))
     {
-      map<unsigned, string> langs;
+      IWAText::StringRuns_t langs;
+      langs.reserve(get(msg).message(19).message(1).size());
       for (const auto &it : get(msg).message(19).message(1))
       {
         if (it.uint32(1))
-          langs.insert(langs.end(), make_pair(get(it.uint32(1)), get_optional_value_or(it.string(2), "")));
+          langs.push_back(make_pair(get(it.uint32(1)), get_optional_value_or(it.string(2), "")));
       }
-      textParser.setLanguages(langs);
+      textParser.setLanguages(std::move(langs));
     }
     if (get(msg).message(24))
     {
-      map<unsigned, bool> rtls;
+      IWAText::BoolRuns_t rtls;
+      rtls.reserve(get(msg).message(24).message(1).size());
       for (const auto &it : get(msg).message(24).message(1))
       {
         if (it.uint32(1) && (get(it.uint32(1)) < length))
         {
           if (it.bool_(2))
-            rtls[get(it.uint32(1))]=get(it.bool_(2));
+            rtls.push_back(make_pair(get(it.uint32(1)), get(it.bool_(2))));
         }
       }
-      textParser.setRTLs(rtls);
+      textParser.setRTLs(std::move(rtls));
     }
     if (get(msg).message(28))
     {
-      map<unsigned, IWORKStylePtr_t> dropCaps;
+      IWAText::StyleRuns_t dropCaps;
+      dropCaps.reserve(get(msg).message(28).message(1).size());
       for (const auto &it : get(msg).message(28).message(1))
       {
         if (!it.uint32(1)) continue;
@@ -957,9 +1013,9 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         if (!dropCapRef) continue;
         const IWORKStylePtr_t &dropCapStyle = queryDropCapStyle(get(dropCapRef));
         if (dropCapStyle && dropCapStyle->has<property::DropCap>())
-          dropCaps.insert(dropCaps.end(), make_pair(get(it.uint32(1)), dropCapStyle));
+          dropCaps.push_back(make_pair(get(it.uint32(1)), dropCapStyle));
       }
-      textParser.setDropCaps(dropCaps);
+      textParser.setDropCaps(std::move(dropCaps));
     }
     if (get(msg).message(23))
     {
@@ -976,7 +1032,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         // field 2: some small integer
         if (textRef)
         {
-          attachments.insert(make_pair(get(it.uint32(1)),
+          attachments.push_back(make_pair(get(it.uint32(1)),
                                        [this,textRef](unsigned, bool &)
           {
             auto currentText=m_currentText;
@@ -996,7 +1052,7 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
         }
       }
     }
-    textParser.setAttachments(attachments);
+    textParser.setAttachments(std::move(attachments));
     textParser.parse(*m_currentText, openPageFunction);
   }
   return true;
@@ -1004,60 +1060,70 @@ bool IWAParser::parseText(const unsigned id, bool createNoteAsFootnote, const st
 
 const IWORKStylePtr_t IWAParser::queryStyle(const unsigned id, StyleMap_t &styleMap, StyleParseFun_t parseStyle) const
 {
-  StyleMap_t::const_iterator it = styleMap.find(id);
-  if (it == styleMap.end())
   {
-    IWORKStylePtr_t style;
-    parseStyle(id, style);
-    it = styleMap.insert(make_pair(id, style)).first;
+    const std::lock_guard<std::mutex> lock(m_styles->m_mutex);
+    const StyleMap_t::const_iterator it = styleMap.find(id);
+    if (it != styleMap.end())
+      return it->second;
   }
+
+  // parse without holding the lock, as the parents are queried during parsing
+  IWORKStylePtr_t style;
+  parseStyle(id, style);
+  // the parent has been queried during parsing, so it is complete
+  if (style)
+    style->freeze();
+
+  const std::lock_guard<std::mutex> lock(m_styles->m_mutex);
+  // if another parser has been faster, use its style, so there is only one
+  const StyleMap_t::const_iterator it = styleMap.insert(make_pair(id, style)).first;
   assert(it != styleMap.end());
   return it->second;
 }
 
 const IWORKStylePtr_t IWAParser::queryCharacterStyle(const unsigned id) const
 {
-  return queryStyle(id, m_charStyles, bind(&IWAParser::parseCharacterStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_charStyles, bind(&IWAParser::parseCharacterStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryDropCapStyle(const unsigned id) const
 {
-  return queryStyle(id, m_dropCapStyles, bind(&IWAParser::parseDropCapStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_dropCapStyles, bind(&IWAParser::parseDropCapStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryParagraphStyle(const unsigned id) const
 {
-  return queryStyle(id, m_paraStyles, bind(&IWAParser::parseParagraphStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_paraStyles, bind(&IWAParser::parseParagraphStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::querySectionStyle(const unsigned id) const
 {
-  return queryStyle(id, m_sectionStyles, bind(&IWAParser::parseSectionStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_sectionStyles, bind(&IWAParser::parseSectionStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryGraphicStyle(const unsigned id) const
 {
-  return queryStyle(id, m_graphicStyles, bind(&IWAParser::parseGraphicStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_graphicStyles, bind(&IWAParser::parseGraphicStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryMediaStyle(const unsigned id) const
 {
-  return queryStyle(id, m_mediaStyles, bind(&IWAParser::parseMediaStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_mediaStyles, bind(&IWAParser::parseMediaStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryCellStyle(const unsigned id) const
 {
-  return queryStyle(id, m_cellStyles, bind(&IWAParser::parseCellStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_cellStyles, bind(&IWAParser::parseCellStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryTableStyle(const unsigned id) const
 {
-  return queryStyle(id, m_tableStyles, bind(&IWAParser::parseTableStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_tableStyles, bind(&IWAParser::parseTableStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 const IWORKStylePtr_t IWAParser::queryListStyle(const unsigned id) const
 {
-  return queryStyle(id, m_tableStyles, bind(&IWAParser::parseListStyle, const_cast<IWAParser *>(this), _1, _2));
+  return queryStyle(id, m_styles->m_tableStyles, bind(&IWAParser::parseListStyle, const_cast<IWAParser *>(this), _1, _2));
 }
 
 bool IWAParser::parseAttachment(const unsigned id)
@@ -1131,10 +1197,9 @@ bool IWAParser::parseAttachment(const unsigned id)
     break;
   default:
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
-      first=false;
       ETONYEK_DEBUG_MSG(("IWAParser::parseAttachment: unknown object type\n"));
     }
   }
@@ -1634,7 +1699,7 @@ void IWAParser::parseMask(unsigned id, IWORKGeometryPtr_t &geometry, IWORKPathPt
 
 void IWAParser::parseObjectIndex()
 {
-  m_index.parse();
+  m_index->parse();
 }
 
 void IWAParser::parseCharacterStyle(const unsigned id, IWORKStylePtr_t &style)
@@ -2457,15 +2522,15 @@ void IWAParser::parseAuthorInComment(unsigned id)
     auto len=str.size();
     if (len==0) return;
     IWAText text(str+"\t", m_langManager);
-    std::map<unsigned, IWORKStylePtr_t> spans;
+    IWAText::StyleRuns_t spans;
     IWORKPropertyMap props;
     // normally yellow, but blue may be better in LO
     props.put<property::FontColor>(IWORKColor(0,0,1,1));
-    spans[0]=std::make_shared<IWORKStyle>(props, boost::none, IWORKStylePtr_t());
+    spans.push_back(make_pair(0, std::make_shared<IWORKStyle>(props, boost::none, IWORKStylePtr_t())));
     // reset color to default, if not, comment will be blue colored
     props.put<property::FontColor>(IWORKColor(0,0,0,1));
-    spans[unsigned(len)]=std::make_shared<IWORKStyle>(props, boost::none, IWORKStylePtr_t());
-    text.setSpans(spans);
+    spans.push_back(make_pair(unsigned(len), std::make_shared<IWORKStyle>(props, boost::none, IWORKStylePtr_t())));
+    text.setSpans(std::move(spans));
     text.parse(*m_currentText);
   }
 }
@@ -3370,11 +3435,10 @@ bool IWAParser::parseFormat(const IWAMessage &msg, IWAParser::Format &format)
   case 266: // pop-up menu
   case 267:   // star rating
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
       ETONYEK_DEBUG_MSG(("IWAParser::parseFormat: using type=%d is not implemented\n", int(type)));
-      first=false;
     }
     return false;
   }
@@ -3517,10 +3581,9 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
   }
   const deque<IWAMessage> &tokens = get(msg.message(1)).message(1).repeated();
 
-  typedef std::vector<IWORKFormula::Token> Formula;
-  std::vector<Formula> stack;
+  IWORKFormula::Builder builder;
   bool ok=true;
-  for (auto it : tokens)
+  for (const auto &it : tokens)
   {
     auto type=it.uint32(1).optional();
     if (!type)
@@ -3534,7 +3597,7 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
     case 16:
       if (it.uint32(2) && it.uint32(3))
       {
-        static std::map<unsigned,std::string> functionsMap=
+        static const std::map<unsigned,std::string> functionsMap=
         {
           {1, "Abs"}, {2, "Accrint"}, {3, "AccrintM"}, {4, "Acos"}, {5, "Acosh"},
           {6, "IWORKFormula::Address"}, {7, "And"}, {8, "Areas"}, {9, "Asin"}, {10, "AsinH"},
@@ -3595,31 +3658,15 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
           {297, "PlainText"}, {298, "Stock"}, {299, "StockH"}, {300, "Currency"},
           {301, "CurrencyH"}, {302, "CurrencyConvert"}, {303, "CurrencyCode"}
         };
-        Formula child;
-        std::ostringstream s;
-        if (functionsMap.find(get(it.uint32(2)))!=functionsMap.end())
-          s << functionsMap.find(get(it.uint32(2)))->second;
+        const auto func=functionsMap.find(get(it.uint32(2)));
+        if (func!=functionsMap.end())
+          ok=builder.applyFunction(func->second, get(it.uint32(3)));
         else
-          s << "Funct" << get(it.uint32(2));
-        child.push_back(IWORKFormula::Token(s.str(), IWORKFormula::Token::Function));
-
-        size_t numArgs=get(it.uint32(3));
-        size_t numData=stack.size();
-        if (numData<numArgs)
         {
-          ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: bad stack for function\n"));
-          ok=false;
-          break;
-        }
-        child.push_back(IWORKFormula::Token("(", IWORKFormula::Token::Operator));
-        for (size_t i=numData-numArgs; i<numData; ++i)
-        {
-          if (i!=numData-numArgs) child.push_back(IWORKFormula::Token(";", IWORKFormula::Token::Operator));
-          child.insert(child.end(), stack[i].begin(),stack[i].end());
+          std::ostringstream s;
+          s << "Funct" << get(it.uint32(2));
+          ok=builder.applyFunction(s.str(), get(it.uint32(3)));
         }
-        child.push_back(IWORKFormula::Token(")", IWORKFormula::Token::Operator));
-        stack.resize(numData-numArgs);
-        stack.push_back(child);
       }
       else
       {
@@ -3629,7 +3676,7 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
       break;
     case 17:
       if (it.double_(4))
-        stack.push_back({IWORKFormula::Token(get(it.double_(4)))});
+        builder.pushNumber(get(it.double_(4)));
       else
       {
         ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not read a double\n"));
@@ -3638,11 +3685,7 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
       break;
     case 18:
       if (it.bool_(5))
-      {
-        stack.push_back({IWORKFormula::Token(get(it.bool_(5)) ? "True" : "False", IWORKFormula::Token::Function),
-                         IWORKFormula::Token("(", IWORKFormula::Token::Operator), IWORKFormula::Token(")", IWORKFormula::Token::Operator)
-                        });
-      }
+        builder.pushBool(get(it.bool_(5)));
       else
       {
         ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not read a bool\n"));
@@ -3651,7 +3694,7 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
       break;
     case 19:
       if (it.string(6))
-        stack.push_back({IWORKFormula::Token(get(it.string(6)),IWORKFormula::Token::String)});
+        builder.pushString(get(it.string(6)));
       else
       {
         ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not read a string\n"));
@@ -3659,11 +3702,11 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
       }
       break;
     case 22: // empty?
-      stack.push_back({});
+      builder.pushEmpty();
       break;
     case 23:
       if (it.bool_(10))
-        stack.push_back({});
+        builder.pushEmpty();
       else
       {
         ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not read a optional argument\n"));
@@ -3672,26 +3715,7 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
       break;
     case 25:
       if (it.uint32(13))
-      {
-        size_t numArgs=get(it.uint32(13));
-        size_t numData=stack.size();
-        if (numData<numArgs)
-        {
-          ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: bad stack for ()\n"));
-          ok=false;
-          break;
-        }
-        Formula child;
-        child.push_back(IWORKFormula::Token("(", IWORKFormula::Token::Operator));
-        for (size_t i=numData-numArgs; i<numData; ++i)
-        {
-          if (i!=numData-numArgs) child.push_back(IWORKFormula::Token(";", IWORKFormula::Token::Operator));
-          child.insert(child.end(), stack[i].begin(),stack[i].end());
-        }
-        child.push_back(IWORKFormula::Token(")", IWORKFormula::Token::Operator));
-        stack.resize(numData-numArgs);
-        stack.push_back(child);
-      }
+        ok=builder.applyParentheses(get(it.uint32(13)));
       else
       {
         ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not read a ()\n"));
@@ -3722,11 +3746,11 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
         else
           address.m_row=coord;
       }
-      address.m_table=readUUID(it,28);
+      address.m_table=readTableUUID(it,28);
       // readUUID(it,38); filename ?
       if (!ok)
         break;
-      stack.push_back({IWORKFormula::Token(address)});
+      builder.pushAddress(address);
       break;
     }
     case 34: // arg begin
@@ -3736,8 +3760,8 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
     {
       IWORKFormula::Address address;
       address.m_row=address.m_column=IWORKFormula::Coord();
-      address.m_table=readUUID(it,28);
-      stack.push_back({IWORKFormula::Token(address)});
+      address.m_table=readTableUUID(it,28);
+      builder.pushAddress(address);
       break;
     }
     default:
@@ -3756,33 +3780,12 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
           ok=false;
           break;
         }
-        size_t numArgs=(get(type)<13 || get(type)>=29) ? 2 : 1;
-        size_t numData=stack.size();
-        if (numData<numArgs)
-        {
-          ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: bad stack for type=%u\n", get(type)));
-          ok=false;
-          break;
-        }
-        Formula child;
-        if (numArgs==2)
-        {
-          child.insert(child.end(), stack[numData-2].begin(),stack[numData-2].end());
-          child.push_back(IWORKFormula::Token(get(type)>=29 ? ":" : wh[get(type)], IWORKFormula::Token::Operator));
-          child.insert(child.end(), stack[numData-1].begin(),stack[numData-1].end());
-        }
+        if (get(type)<13 || get(type)>=29)
+          ok=builder.applyInfixOp(get(type)>=29 ? ":" : wh[get(type)]);
         else if (get(type)<15)
-        {
-          child.push_back(IWORKFormula::Token(wh[get(type)], IWORKFormula::Token::Operator));
-          child.insert(child.end(), stack[numData-1].begin(),stack[numData-1].end());
-        }
+          ok=builder.applyPrefixOp(wh[get(type)][0]);
         else
-        {
-          child.insert(child.end(), stack[numData-1].begin(),stack[numData-1].end());
-          child.push_back(IWORKFormula::Token(wh[get(type)], IWORKFormula::Token::Operator));
-        }
-        stack.resize(numData-numArgs);
-        stack.push_back(child);
+          ok=builder.applyPostfixOp(wh[get(type)][0]);
         break;
       }
       ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: find unexpected type=%u\n", get(type)));
@@ -3792,19 +3795,15 @@ bool IWAParser::parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula)
     if (!ok)
       break;
   }
-  if (stack.size()!=1) ok=false;
-  if (!ok)
+  if (ok)
   {
-    std::ostringstream readData;
-    for (auto const &form : stack)
-      for (auto const &dt : form)
-        readData << dt << ",";
-    ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not find parse a formula=%s\n", readData.str().c_str()));
+    formula.reset(new IWORKFormula(boost::make_optional(0u)));
+    ok=builder.build(*formula);
   }
-  else
+  if (!ok)
   {
-    formula.reset(new IWORKFormula(boost::make_optional(0u)));
-    formula->parse(stack[0]);
+    ETONYEK_DEBUG_MSG(("IWAParser::parseFormula: can not parse a formula\n"));
+    formula.reset();
   }
   return ok;
 }
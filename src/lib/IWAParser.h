@@ -14,6 +14,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -61,6 +62,14 @@ public:
 
   bool parse();
 
+protected:
+  /** Create a parser sharing the object index and the styles of @c parent.
+    *
+    * Parsers created this way can work on different parts of the
+    * document concurrently, each with its own collector.
+    */
+  IWAParser(const IWAParser &parent, IWORKCollector &collector);
+
 protected:
   class ObjectMessage
   {
@@ -107,7 +116,7 @@ protected:
 
   bool dispatchShape(unsigned id);
   bool dispatchShapeWithMessage(const IWAMessage &msg, unsigned type);
-  bool parseText(unsigned id, bool createNoteAsFootnote=true, const std::function<void(unsigned, IWORKStylePtr_t)> &openPageSpan=nullptr);
+  bool parseText(unsigned id, bool createNoteAsFootnote=true, const std::function<bool(unsigned, IWORKStylePtr_t)> &openPageSpan=nullptr);
   void parseComment(unsigned id);
   void parseAuthorInComment(unsigned id);
   void parseCustomFormat(unsigned id);
@@ -127,6 +136,11 @@ protected:
   const IWORKStylePtr_t queryTableStyle(unsigned id) const;
   const IWORKStylePtr_t queryListStyle(unsigned id) const;
 
+  /** Get a style from @c styleMap, parsing it if it is not there yet.
+    *
+    * The map is guarded by the lock of the style cache, so it must be
+    * shared by the same parsers as the cache.
+    */
   const IWORKStylePtr_t queryStyle(unsigned id, StyleMap_t &styleMap, StyleParseFun_t parse) const;
   boost::optional<unsigned> getObjectType(unsigned id) const;
 
@@ -238,6 +252,8 @@ private:
   bool parseTabularInfo(const IWAMessage &msg);
   bool parsePath(const IWAMessage &msg, IWORKPathPtr_t &path);
   bool parseFormula(const IWAMessage &msg, IWORKFormulaPtr_t &formula);
+  /// Read the UUID of a table referenced by a formula, sharing it between all the references.
+  const std::shared_ptr<const std::string> &readTableUUID(const IWAMessage &msg, unsigned field);
   bool parseFormat(const IWAMessage &msg, Format &format);
   virtual bool parseStickyNote(const IWAMessage &msg);
 
@@ -245,26 +261,37 @@ private:
   void parseCharacterProperties(const IWAMessage &msg, IWORKPropertyMap &props);
   void parseColumnsProperties(const IWAMessage &msg, IWORKPropertyMap &props);
 
+  /// Styles shared by a parser and the parsers created from it.
+  struct StyleCache
+  {
+    StyleCache();
+
+    std::mutex m_mutex;
+
+    StyleMap_t m_charStyles;
+    StyleMap_t m_dropCapStyles;
+    StyleMap_t m_paraStyles;
+    StyleMap_t m_sectionStyles;
+
+    StyleMap_t m_graphicStyles;
+    StyleMap_t m_mediaStyles;
+    StyleMap_t m_cellStyles;
+    StyleMap_t m_tableStyles;
+    StyleMap_t m_listStyles;
+  };
+
 private:
   IWORKCollector &m_collector;
 
-  IWAObjectIndex m_index;
+  const std::shared_ptr<IWAObjectIndex> m_index;
 
   std::deque<unsigned> m_visited;
 
-  mutable StyleMap_t m_charStyles;
-  mutable StyleMap_t m_dropCapStyles;
-  mutable StyleMap_t m_paraStyles;
-  mutable StyleMap_t m_sectionStyles;
-
-  mutable StyleMap_t m_graphicStyles;
-  mutable StyleMap_t m_mediaStyles;
-  mutable StyleMap_t m_cellStyles;
-  mutable StyleMap_t m_tableStyles;
-  mutable StyleMap_t m_listStyles;
+  const std::shared_ptr<StyleCache> m_styles;
 
   std::shared_ptr<TableInfo> m_currentTable;
   std::map<uint64_t,Format> m_uidFormatMap;
+  std::map<std::pair<uint64_t, uint64_t>, std::shared_ptr<const std::string> > m_tableUUIDs;
 };
 
 }
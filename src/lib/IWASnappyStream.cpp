@@ -13,6 +13,7 @@
 #include <cassert>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -30,6 +31,69 @@ struct CompressionException
 {
 };
 
+/** Compressed input.
+  *
+  * The whole input is read at once and then decoded directly from
+  * memory, which avoids going through the stream for every byte.
+  */
+struct Input
+{
+  Input(const unsigned char *begin, const unsigned char *end);
+
+  bool isEnd() const;
+  unsigned long getRemainingLength() const;
+  unsigned char readU8();
+  uint64_t readUVar();
+
+  const unsigned char *m_pos;
+  const unsigned char *const m_end;
+};
+
+Input::Input(const unsigned char *const begin, const unsigned char *const end)
+  : m_pos(begin)
+  , m_end(end)
+{
+}
+
+bool Input::isEnd() const
+{
+  return m_pos == m_end;
+}
+
+unsigned long Input::getRemainingLength() const
+{
+  return (unsigned long)(m_end - m_pos);
+}
+
+unsigned char Input::readU8()
+{
+  if (isEnd())
+    throw EndOfStreamException();
+  return *m_pos++;
+}
+
+uint64_t Input::readUVar()
+{
+  uint64_t value = 0;
+  unsigned shift = 0;
+  bool overflow = false;
+  bool cont = true;
+  while (cont)
+  {
+    const unsigned char c = readU8();
+    const uint64_t bits = c & ~0x80;
+    if ((bits != 0) && ((shift >= 64) || ((bits << shift) >> shift != bits)))
+      overflow = true;
+    else if (shift < 64)
+      value |= bits << shift;
+    shift += 7;
+    cont = c & 0x80;
+  }
+  if (overflow)
+    throw std::range_error("Number too big");
+  return value;
+}
+
 struct Data
 {
   explicit Data(vector<unsigned char> &data);
@@ -72,19 +136,19 @@ void appendRef(Data &data, const unsigned offset, const unsigned length)
   }
 }
 
-bool uncompressBlock(const RVNGInputStreamPtr_t &input, const unsigned long length, vector<unsigned char> &uncompressed)
+bool uncompressBlock(Input &input, const unsigned long length, vector<unsigned char> &uncompressed)
 {
   Data data(uncompressed);
 
-  const long blockEnd = input->tell() + long(length);
-  const auto uncompressedLength = (unsigned long) readUVar(input);
+  const unsigned char *const begin = input.m_pos;
+  const auto uncompressedLength = (unsigned long) input.readUVar();
   const size_t maxSize = size_t((std::min)(2 * length, uncompressedLength)); // don't want unbounded allocation
   size_t newSize = data.m_data.size() + maxSize;
   data.m_data.reserve(newSize);
 
-  while (!input->isEnd() && (input->tell() < blockEnd))
+  while (!input.isEnd() && (static_cast<unsigned long>(input.m_pos - begin) < length))
   {
-    const unsigned char c = readU8(input);
+    const unsigned char c = input.readU8();
     switch (c & 0x3)
     {
     case 0 : // a run of literals
@@ -95,10 +159,10 @@ bool uncompressBlock(const RVNGInputStreamPtr_t &input, const unsigned long leng
         const unsigned count = ((c >> 2) & 0x3) + 1;
         assert(count > 0);
         assert(count <= 4);
-        runLength = unsigned(readU8(input)) + 1;
+        runLength = unsigned(input.readU8()) + 1;
         for (unsigned shift = 8; shift < 8 * count; shift += 8)
         {
-          const unsigned b = readU8(input);
+          const unsigned b = input.readU8();
           runLength += b << shift;
         }
       }
@@ -107,18 +171,17 @@ bool uncompressBlock(const RVNGInputStreamPtr_t &input, const unsigned long leng
         runLength = (c >> 2) + 1;
       }
       assert(runLength > 0);
-      unsigned long bytesRead = 0;
-      const unsigned char *const bytes = input->read(runLength, bytesRead);
-      if (bytesRead != runLength)
+      if (runLength > input.getRemainingLength())
         return false;
-      data.m_data.insert(data.m_data.end(), bytes, bytes + runLength);
+      data.m_data.insert(data.m_data.end(), input.m_pos, input.m_pos + runLength);
+      input.m_pos += runLength;
       break;
     }
     case 1 : // near ref
     {
       const unsigned runLength = ((c >> 2) & 0x7) + 4;
       const unsigned high = c >> 5;
-      const unsigned low = readU8(input);
+      const unsigned low = input.readU8();
       const unsigned offset = (high << 8) | low;
       appendRef(data, offset, runLength);
       break;
@@ -126,8 +189,8 @@ bool uncompressBlock(const RVNGInputStreamPtr_t &input, const unsigned long leng
     case 2 : // far ref
     {
       const unsigned runLength = (c >> 2) + 1;
-      const unsigned low = readU8(input);
-      const unsigned high = readU8(input);
+      const unsigned low = input.readU8();
+      const unsigned high = input.readU8();
       const unsigned offset = (high << 8) | low;
       appendRef(data, offset, runLength);
       break;
@@ -143,43 +206,60 @@ bool uncompressBlock(const RVNGInputStreamPtr_t &input, const unsigned long leng
   return true;
 }
 
-RVNGInputStreamPtr_t uncompress(const RVNGInputStreamPtr_t &input)
+/// Read the rest of @c stream into memory.
+const unsigned char *readAll(const RVNGInputStreamPtr_t &stream, unsigned long &length)
 {
-  vector<unsigned char> data;
+  const unsigned long pos = (unsigned long) stream->tell();
+  const unsigned long end = getLength(stream);
+  length = 0;
+  if (end <= pos)
+    return nullptr;
+  return stream->read(end - pos, length);
+}
 
-  while (!input->isEnd())
-  {
-    readU8(input);
-    unsigned long blockLength = readU16(input);
-    // rare, but the blockLength can be greater than 65536, ie. I find 06 00 01 in one file
-    blockLength+=65536*readU8(input);
-    if (!uncompressBlock(input, (std::min)(blockLength, getRemainingLength(input)), data))
-      throw CompressionException();
-  }
+}
 
-  return std::make_shared<IWORKMemoryStream>(data);
+IWASnappyStream::IWASnappyStream(const RVNGInputStreamPtr_t &stream)
+  : m_stream(uncompress(stream))
+{
 }
 
+IWASnappyStream::~IWASnappyStream()
+{
 }
 
-IWASnappyStream::IWASnappyStream(const RVNGInputStreamPtr_t &stream)
-  : m_stream()
+std::shared_ptr<IWORKMemoryStream> IWASnappyStream::uncompress(const RVNGInputStreamPtr_t &stream)
 {
   if (0 != stream->seek(0, librevenge::RVNG_SEEK_SET))
     throw EndOfStreamException();
 
-  m_stream = uncompress(stream);
-}
+  vector<unsigned char> data;
 
-IWASnappyStream::~IWASnappyStream()
-{
+  unsigned long length = 0;
+  const unsigned char *const bytes = readAll(stream, length);
+  Input input(bytes, bytes + length);
+  while (!input.isEnd())
+  {
+    input.readU8();
+    unsigned long blockLength = input.readU8();
+    blockLength |= unsigned(input.readU8()) << 8;
+    // rare, but the blockLength can be greater than 65536, ie. I find 06 00 01 in one file
+    blockLength+=65536*input.readU8();
+    if (!libetonyek::uncompressBlock(input, (std::min)(blockLength, input.getRemainingLength()), data))
+      throw CompressionException();
+  }
+
+  return std::make_shared<IWORKMemoryStream>(std::move(data));
 }
 
 RVNGInputStreamPtr_t IWASnappyStream::uncompressBlock(const RVNGInputStreamPtr_t &block)
 {
   vector<unsigned char> data;
-  libetonyek::uncompressBlock(block, getLength(block), data);
-  return std::make_shared<IWORKMemoryStream>(data);
+  unsigned long length = 0;
+  const unsigned char *const bytes = readAll(block, length);
+  Input input(bytes, bytes + length);
+  libetonyek::uncompressBlock(input, getLength(block), data);
+  return std::make_shared<IWORKMemoryStream>(std::move(data));
 }
 
 bool IWASnappyStream::isStructured()
@@ -10,6 +10,8 @@
 #ifndef IWASNAPPYSTREAM_H_INCLUDED
 #define IWASNAPPYSTREAM_H_INCLUDED
 
+#include <memory>
+
 #include <librevenge-stream/librevenge-stream.h>
 
 #include "libetonyek_utils.h"
@@ -17,6 +19,8 @@
 namespace libetonyek
 {
 
+class IWORKMemoryStream;
+
 class IWASnappyStream : public librevenge::RVNGInputStream
 {
 public:
@@ -26,6 +30,13 @@ public:
   // for unit tests
   static RVNGInputStreamPtr_t uncompressBlock(const RVNGInputStreamPtr_t &block);
 
+  /** Uncompress the whole of @c stream.
+    *
+    * Unlike the stream interface, this gives access to the data, so
+    * several independent views of them can be created.
+    */
+  static std::shared_ptr<IWORKMemoryStream> uncompress(const RVNGInputStreamPtr_t &stream);
+
   bool isStructured() override;
   unsigned subStreamCount() override;
   const char *subStreamName(unsigned id) override;
@@ -9,7 +9,9 @@
 
 #include "IWAText.h"
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 
 #include "IWORKLanguageManager.h"
 #include "IWORKProperties.h"
@@ -18,10 +20,6 @@
 namespace libetonyek
 {
 
-using boost::none;
-
-using std::make_shared;
-using std::map;
 using std::string;
 
 namespace
@@ -36,6 +34,92 @@ void flushText(string &text, IWORKText &collector)
   }
 }
 
+/** Get the length of an UTF-8 character from its first byte.
+  *
+  * This follows librevenge::RVNGString::Iter, so invalid bytes are
+  * handled the same way.
+  */
+std::size_t getCharLength(const unsigned char c)
+{
+  if (c < 0xc0)
+    return 1;
+  if (c < 0xe0)
+    return 2;
+  if (c < 0xf0)
+    return 3;
+  if (c < 0xf8)
+    return 4;
+  if (c < 0xfc)
+    return 5;
+  if (c < 0xfe)
+    return 6;
+  return 1;
+}
+
+/// Check if the character needs to be handled on its own.
+bool isSpecial(const char c, const bool wasSpace)
+{
+  return (unsigned(c) <= 0x1f) || ((c == ' ') && wasSpace);
+}
+
+template<typename Runs>
+void updateNextChange(const Runs &runs, const typename Runs::const_iterator &it, std::size_t &next)
+{
+  if ((runs.end() != it) && (it->first < next))
+    next = it->first;
+}
+
+struct PositionLess
+{
+  template<typename T>
+  bool operator()(const std::pair<unsigned, T> &left, const std::pair<unsigned, T> &right) const
+  {
+    return left.first < right.first;
+  }
+};
+
+struct PositionEqual
+{
+  template<typename T>
+  bool operator()(const std::pair<unsigned, T> &left, const std::pair<unsigned, T> &right) const
+  {
+    return left.first == right.first;
+  }
+};
+
+/** Make sure the runs are sorted and there is only one per position.
+  *
+  * The runs come sorted from the file normally, so this is just a check.
+  * If there are more runs for a position, the first one is kept, unless
+  * @c keepLast is set.
+  */
+template<typename T>
+void normalize(std::vector<std::pair<unsigned, T> > &runs, const bool keepLast = false)
+{
+  typedef std::pair<unsigned, T> Run_t;
+  const auto notAscending = [](const Run_t &left, const Run_t &right)
+  {
+    return left.first >= right.first;
+  };
+  if (std::adjacent_find(runs.begin(), runs.end(), notAscending) == runs.end())
+    return;
+  std::stable_sort(runs.begin(), runs.end(), PositionLess());
+  if (!keepLast)
+  {
+    runs.erase(std::unique(runs.begin(), runs.end(), PositionEqual()), runs.end());
+    return;
+  }
+  auto out = runs.begin();
+  for (auto it = runs.begin(); it != runs.end(); ++it)
+  {
+    if ((out != runs.begin()) && ((out - 1)->first == it->first))
+      *(out - 1) = std::move(*it);
+    else if (out++ != it)
+      *(out - 1) = std::move(*it);
+  }
+  runs.erase(out, runs.end());
+}
+
 }
 
 IWAText::IWAText(const std::string &text, IWORKLanguageManager &langManager)
@@ -57,73 +141,84 @@ IWAText::IWAText(const std::string &text, IWORKLanguageManager &langManager)
 {
 }
 
-void IWAText::setPageMasters(const std::map<unsigned, IWORKStylePtr_t> &pageMasters)
+void IWAText::setPageMasters(StyleRuns_t &&pageMasters)
 {
-  m_pageMasters = pageMasters;
+  m_pageMasters = std::move(pageMasters);
+  normalize(m_pageMasters);
 }
 
-void IWAText::setSections(const std::map<unsigned, IWORKStylePtr_t> &sections)
+void IWAText::setSections(StyleRuns_t &&sections)
 {
-  m_sections = sections;
+  m_sections = std::move(sections);
+  normalize(m_sections);
 }
 
-void IWAText::setParagraphs(const std::map<unsigned, IWORKStylePtr_t> &paras)
+void IWAText::setParagraphs(StyleRuns_t &&paras)
 {
-  m_paras = paras;
+  m_paras = std::move(paras);
+  normalize(m_paras);
 }
 
-void IWAText::setSpans(const std::map<unsigned, IWORKStylePtr_t> &spans)
+void IWAText::setSpans(StyleRuns_t &&spans)
 {
-  m_spans = spans;
+  m_spans = std::move(spans);
+  normalize(m_spans);
 }
 
-void IWAText::setLanguages(const std::map<unsigned, std::string> &langs)
+void IWAText::setLanguages(StringRuns_t &&langs)
 {
-  m_langs = langs;
+  m_langs = std::move(langs);
+  normalize(m_langs);
 }
 
-void IWAText::setLinks(const std::map<unsigned, std::string> &links)
+void IWAText::setLinks(StringRuns_t &&links)
 {
-  m_links = links;
+  m_links = std::move(links);
+  normalize(m_links);
 }
 
-void IWAText::setListLevels(const std::map<unsigned, unsigned> &levels)
+void IWAText::setListLevels(UIntRuns_t &&levels)
 {
-  m_listLevels = levels;
+  m_listLevels = std::move(levels);
+  normalize(m_listLevels);
 }
 
-void IWAText::setLists(const std::map<unsigned, IWORKStylePtr_t> &lists)
+void IWAText::setLists(StyleRuns_t &&lists)
 {
-  m_lists = lists;
+  m_lists = std::move(lists);
+  normalize(m_lists);
 }
 
-void IWAText::setDropCaps(const std::map<unsigned, IWORKStylePtr_t> &dropCaps)
+void IWAText::setDropCaps(StyleRuns_t &&dropCaps)
 {
-  m_dropCaps = dropCaps;
+  m_dropCaps = std::move(dropCaps);
+  normalize(m_dropCaps);
 }
 
-void IWAText::setRTLs(const std::map<unsigned, bool> &rtls)
+void IWAText::setRTLs(BoolRuns_t &&rtls)
 {
-  m_rtls = rtls;
+  m_rtls = std::move(rtls);
+  normalize(m_rtls, true); // the last value for a position wins
 }
 
-void IWAText::setAttachments(const std::multimap<unsigned, std::function<void(unsigned, bool &)> > &attachments)
+void IWAText::setAttachments(Attachments_t &&attachments)
 {
-  m_attachments = attachments;
+  m_attachments = std::move(attachments);
+  std::stable_sort(m_attachments.begin(), m_attachments.end(), PositionLess());
 }
 
-void IWAText::parse(IWORKText &collector, const std::function<void(unsigned, IWORKStylePtr_t)> &openPageSpan)
+void IWAText::parse(IWORKText &collector, const std::function<bool(unsigned, IWORKStylePtr_t)> &openPageSpan)
 {
   auto pageMasterIt = m_pageMasters.begin();
   auto sectionIt = m_sections.begin();
-  map<unsigned, IWORKStylePtr_t>::const_iterator paraIt = m_paras.begin();
-  map<unsigned, IWORKStylePtr_t>::const_iterator dropCapIt = m_dropCaps.begin();
-  map<unsigned, bool>::const_iterator rtlIt = m_rtls.begin();
-  map<unsigned, IWORKStylePtr_t>::const_iterator spanIt = m_spans.begin();
-  map<unsigned, string>::const_iterator langIt = m_langs.begin();
-  map<unsigned, string>::const_iterator linkIt = m_links.begin();
-  map<unsigned, IWORKStylePtr_t>::const_iterator listIt = m_lists.begin();
-  map<unsigned, unsigned>::const_iterator listLevelIt = m_listLevels.begin();
+  StyleRuns_t::const_iterator paraIt = m_paras.begin();
+  StyleRuns_t::const_iterator dropCapIt = m_dropCaps.begin();
+  BoolRuns_t::const_iterator rtlIt = m_rtls.begin();
+  StyleRuns_t::const_iterator spanIt = m_spans.begin();
+  StringRuns_t::const_iterator langIt = m_langs.begin();
+  StringRuns_t::const_iterator linkIt = m_links.begin();
+  StyleRuns_t::const_iterator listIt = m_lists.begin();
+  UIntRuns_t::const_iterator listLevelIt = m_listLevels.begin();
   auto attachmentIt = m_attachments.begin();
   bool wasSpace = false;
   IWORKStylePtr_t currentListStyle;
@@ -137,10 +232,11 @@ void IWAText::parse(IWORKText &collector, const std::function<void(unsigned, IWO
   boost::optional<std::size_t> endDropCapPos;
   bool rtl=false;
 
+  const std::size_t length = std::size_t(m_text.len());
+  const char *const end = m_text.cstr() + m_text.size();
+  const char *current = m_text.cstr();
   std::size_t pos = 0;
-  librevenge::RVNGString::Iter iter(m_text);
-  iter.rewind();
-  for (; iter.next(); ++pos)
+  while (current != end)
   {
     // first the page master change
     if ((pageMasterIt != m_pageMasters.end()) && (pageMasterIt->first == pos))
@@ -148,7 +244,8 @@ void IWAText::parse(IWORKText &collector, const std::function<void(unsigned, IWO
       if (openPageSpan)
       {
         flushText(curText, collector);
-        openPageSpan(unsigned(pos), pageMasterIt->second);
+        if (!openPageSpan(unsigned(pos), pageMasterIt->second))
+          break;
       }
       ++pageMasterIt;
     }
@@ -175,20 +272,7 @@ void IWAText::parse(IWORKText &collector, const std::function<void(unsigned, IWO
     }
     if ((langIt != m_langs.end()) && (langIt->first == pos))
     {
-      IWORKPropertyMap props;
-      if (!langIt->second.empty())
-      {
-        const string &tag = m_langManager.addTag(langIt->second);
-        if (tag.empty())
-          props.clear<property::Language>();
-        else
-          props.put<property::Language>(tag);
-      }
-      else
-      {
-        props.clear<property::Language>();
-      }
-      langStyle = make_shared<IWORKStyle>(props, none, none);
+      langStyle = m_langManager.getLanguageStyle(langIt->second);
       langChanged = true;
       ++langIt;
     }
@@ -284,75 +368,109 @@ void IWAText::parse(IWORKText &collector, const std::function<void(unsigned, IWO
       ++attachmentIt;
     }
     if (ignoreCharacter)
-      continue;
-    // handle text
-    const char *const u8Char = iter();
-
-    if (unsigned(u8Char[0])<=0x1f && bool(endDropCapPos))
     {
-      // a special character, better to force a span style reset
-      flushText(curText, collector);
-      collector.flushSpan();
-      collector.setSpanStyle(lastSpanStyle);
-      endDropCapPos.reset();
+      current += (std::min)(getCharLength((unsigned char)(*current)), std::size_t(end - current));
+      ++pos;
+      continue;
     }
 
-    switch (u8Char[0])
+    // nothing changes until the next position with an attribute or attachment
+    std::size_t nextChange = length;
+    updateNextChange(m_pageMasters, pageMasterIt, nextChange);
+    updateNextChange(m_sections, sectionIt, nextChange);
+    updateNextChange(m_paras, paraIt, nextChange);
+    updateNextChange(m_dropCaps, dropCapIt, nextChange);
+    updateNextChange(m_rtls, rtlIt, nextChange);
+    updateNextChange(m_spans, spanIt, nextChange);
+    updateNextChange(m_langs, langIt, nextChange);
+    updateNextChange(m_links, linkIt, nextChange);
+    updateNextChange(m_lists, listIt, nextChange);
+    updateNextChange(m_listLevels, listLevelIt, nextChange);
+    updateNextChange(m_attachments, attachmentIt, nextChange);
+    if (bool(endDropCapPos) && (get(endDropCapPos) > pos) && (get(endDropCapPos) < nextChange))
+      nextChange = get(endDropCapPos);
+    if (nextChange <= pos)
+      nextChange = pos + 1;
+
+    // handle text up to the next change
+    while ((pos < nextChange) && (current != end))
     {
-    case char(4): // new section(ok)
-      // be sure to send the last section, even if it has no content
-      if (openPageSpan && pos+1==size_t(m_text.len()) && (pageMasterIt != m_pageMasters.end()) && (pageMasterIt->first == pos+1))
+      if (!isSpecial(*current, wasSpace))
       {
-        flushText(curText, collector);
-        openPageSpan(unsigned(pos), pageMasterIt->second);
+        // copy a run of ordinary characters at once
+        const char *const runStart = current;
+        do
+        {
+          current += (std::min)(getCharLength((unsigned char)(*current)), std::size_t(end - current));
+          ++pos;
+        }
+        while ((pos < nextChange) && (current != end) && !isSpecial(*current, current[-1] == ' '));
+        curText.append(runStart, current);
+        wasSpace = current[-1] == ' ';
+        continue;
       }
-      break;
-    case char(14): // footnote: normally already ignored
-      break;
-    case char(5):
-    {
-      flushText(curText, collector);
-      collector.flushParagraph();
-      collector.insertPageBreak();
-      break;
-    }
-    case char(12): // column break
-      if (m_sections.empty()) break;
-      flushText(curText, collector);
-      collector.flushParagraph();
-      collector.insertColumnBreak();
-      break;
-    case '\t' :
-      flushText(curText, collector);
-      collector.insertTab();
-      break;
-    case '\r' :
-      flushText(curText, collector);
-      collector.insertLineBreak();
-      break;
-    case '\n' :
-      flushText(curText, collector);
-      collector.flushParagraph();
-      break;
-    case ' ' :
-      if (wasSpace)
+
+      const char c = *current;
+      ++current;
+
+      if (unsigned(c)<=0x1f && bool(endDropCapPos))
       {
+        // a special character, better to force a span style reset
         flushText(curText, collector);
-        collector.insertSpace();
+        collector.flushSpan();
+        collector.setSpanStyle(lastSpanStyle);
+        endDropCapPos.reset();
       }
-      else
-        curText.push_back(' ');
-      break;
-    default:
-      if (unsigned(u8Char[0])<=0x1f)
+
+      switch (c)
       {
-        ETONYEK_DEBUG_MSG(("IWAText::parse: find bad character %d\n", (int) unsigned(u8Char[0])));
+      case char(4): // new section(ok)
+        // be sure to send the last section, even if it has no content
+        if (openPageSpan && pos+1==length && (pageMasterIt != m_pageMasters.end()) && (pageMasterIt->first == pos+1))
+        {
+          flushText(curText, collector);
+          openPageSpan(unsigned(pos), pageMasterIt->second);
+        }
+        break;
+      case char(14): // footnote: normally already ignored
+        break;
+      case char(5):
+      {
+        flushText(curText, collector);
+        collector.flushParagraph();
+        collector.insertPageBreak();
+        break;
+      }
+      case char(12): // column break
+        if (m_sections.empty()) break;
+        flushText(curText, collector);
+        collector.flushParagraph();
+        collector.insertColumnBreak();
+        break;
+      case '\t' :
+        flushText(curText, collector);
+        collector.insertTab();
+        break;
+      case '\r' :
+        flushText(curText, collector);
+        collector.insertLineBreak();
+        break;
+      case '\n' :
+        flushText(curText, collector);
+        collector.flushParagraph();
+        break;
+      case ' ' :
+        // only a repeated space gets here
+        flushText(curText, collector);
+        collector.insertSpace();
+        break;
+      default:
+        ETONYEK_DEBUG_MSG(("IWAText::parse: find bad character %d\n", (int) unsigned(c)));
         break;
       }
-      curText.append(u8Char);
-      break;
+      wasSpace = c == ' ';
+      ++pos;
     }
-    wasSpace=u8Char[0]==' ';
   }
   flushText(curText, collector);
   collector.flushParagraph();
@@ -11,9 +11,9 @@
 #define IWATEXT_H_INCLUDED
 
 #include <functional>
-#include <map>
-#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <librevenge/librevenge.h>
 
@@ -29,42 +29,61 @@ class IWORKText;
 
 class IWAText
 {
+public:
+  /** Attribute runs: values with the position where they start.
+    *
+    * The runs are expected to be sorted by position. If they are not,
+    * they are sorted when set and only the first value for a position
+    * is kept.
+    */
+  typedef std::vector<std::pair<unsigned, IWORKStylePtr_t> > StyleRuns_t;
+  typedef std::vector<std::pair<unsigned, std::string> > StringRuns_t;
+  typedef std::vector<std::pair<unsigned, unsigned> > UIntRuns_t;
+  typedef std::vector<std::pair<unsigned, bool> > BoolRuns_t;
+  /// Attachments, in the order they should be called for the same position.
+  typedef std::vector<std::pair<unsigned, std::function<void(unsigned, bool &)> > > Attachments_t;
+
 public:
   IWAText(const std::string &text, IWORKLanguageManager &langManager);
 
-  void setPageMasters(const std::map<unsigned, IWORKStylePtr_t> &pageMasters);
-  void setSections(const std::map<unsigned, IWORKStylePtr_t> &sections);
-  void setParagraphs(const std::map<unsigned, IWORKStylePtr_t> &paras);
-  void setSpans(const std::map<unsigned, IWORKStylePtr_t> &spans);
+  void setPageMasters(StyleRuns_t &&pageMasters);
+  void setSections(StyleRuns_t &&sections);
+  void setParagraphs(StyleRuns_t &&paras);
+  void setSpans(StyleRuns_t &&spans);
 
-  void setLanguages(const std::map<unsigned, std::string> &langs);
-  void setLinks(const std::map<unsigned, std::string> &links);
-  void setListLevels(const std::map<unsigned, unsigned> &levels);
-  void setLists(const std::map<unsigned, IWORKStylePtr_t> &lists);
-  void setDropCaps(const std::map<unsigned, IWORKStylePtr_t> &dropCaps);
-  void setRTLs(const std::map<unsigned, bool> &rtls);
+  void setLanguages(StringRuns_t &&langs);
+  void setLinks(StringRuns_t &&links);
+  void setListLevels(UIntRuns_t &&levels);
+  void setLists(StyleRuns_t &&lists);
+  void setDropCaps(StyleRuns_t &&dropCaps);
+  void setRTLs(BoolRuns_t &&rtls);
 
-  void setAttachments(const std::multimap<unsigned, std::function<void(unsigned, bool &)> > &attachments);
+  void setAttachments(Attachments_t &&attachments);
 
-  void parse(IWORKText &collector, const std::function<void(unsigned, IWORKStylePtr_t)> &openPageSpan=nullptr);
+  /** Parse the text into @c collector.
+    *
+    * @c openPageSpan is called at every change of the page master. If
+    * it returns false, the rest of the text is skipped.
+    */
+  void parse(IWORKText &collector, const std::function<bool(unsigned, IWORKStylePtr_t)> &openPageSpan=nullptr);
 
 private:
   const librevenge::RVNGString m_text;
   IWORKLanguageManager &m_langManager;
 
-  std::map<unsigned, IWORKStylePtr_t> m_pageMasters;
-  std::map<unsigned, IWORKStylePtr_t> m_sections;
-  std::map<unsigned, IWORKStylePtr_t> m_paras;
-  std::map<unsigned, IWORKStylePtr_t> m_spans;
+  StyleRuns_t m_pageMasters;
+  StyleRuns_t m_sections;
+  StyleRuns_t m_paras;
+  StyleRuns_t m_spans;
 
-  std::map<unsigned, std::string> m_langs;
-  std::map<unsigned, std::string> m_links;
-  std::map<unsigned, IWORKStylePtr_t> m_lists;
-  std::map<unsigned, unsigned> m_listLevels;
-  std::map<unsigned, IWORKStylePtr_t> m_dropCaps;
-  std::map<unsigned, bool> m_rtls;
+  StringRuns_t m_langs;
+  StringRuns_t m_links;
+  StyleRuns_t m_lists;
+  UIntRuns_t m_listLevels;
+  StyleRuns_t m_dropCaps;
+  BoolRuns_t m_rtls;
 
-  std::multimap<unsigned, std::function<void(unsigned, bool &)> > m_attachments;
+  Attachments_t m_attachments;
 };
 
 }
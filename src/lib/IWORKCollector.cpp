@@ -10,11 +10,13 @@
 #include "IWORKCollector.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
 
 #include "IWORKDocumentInterface.h"
 #include "IWORKOutputElements.h"
@@ -124,6 +126,7 @@ struct FillWriter : public boost::static_visitor<void>
   {
     if (bitmap.m_data && bitmap.m_data->m_stream)
     {
+      const std::lock_guard<std::mutex> lock(bitmap.m_data->m_mutex);
       const unsigned long length = getLength(bitmap.m_data->m_stream);
       unsigned long readBytes = 0;
       bitmap.m_data->m_stream->seek(0, librevenge::RVNG_SEEK_SET);
@@ -162,11 +165,10 @@ struct FillWriter : public boost::static_visitor<void>
       (*this)(get(bitmap.m_fillColor));
     else
     {
-      static bool first=true;
-      if (first)
+      static std::atomic<bool> first(true);
+      if (first.exchange(false))
       {
         ETONYEK_DEBUG_MSG(("FillWriter::operator()(IWORKMediaContent)[IWORKCollector.cpp]: can not retrieve some pictures\n"));
-        first=false;
       }
       m_props.insert("draw:fill", "none");
     }
@@ -211,6 +213,7 @@ IWORKCollector::IWORKCollector(IWORKDocumentInterface *const document)
   , m_currentLeveled()
   , m_currentContent()
   , m_metadata()
+  , m_shapePathCache()
   , m_accumulateTransform(true)
   , m_groupLevel(0)
   , m_groupOpenLevel(0)
@@ -286,11 +289,16 @@ void IWORKCollector::collectBezier(const IWORKPathPtr_t &path)
 {
   if (bool(m_recorder))
     m_recorder->collectPath(path);
-  else
+  else if (path)
   {
-    m_currentPath = path;
-    if (m_currentPath) m_currentPath->closePath(true);
+    // the path can be shared, e.g., by a recording that is replayed
+    // more times or by the stock shape path cache, so close a copy of
+    // it (which is cheap)
+    m_currentPath = std::make_shared<IWORKPath>(*path);
+    m_currentPath->closePath(true);
   }
+  else
+    m_currentPath.reset();
 }
 
 void IWORKCollector::collectImage(const IWORKMediaContentPtr_t &image, const IWORKGeometryPtr_t &cropGeometry, const boost::optional<int> &order, bool locked)
@@ -378,7 +386,7 @@ void IWORKCollector::collectBezierPath()
 
 void IWORKCollector::collectPolygonPath(const IWORKSize &size, const unsigned edges)
 {
-  const IWORKPathPtr_t path(makePolygonPath(size, edges));
+  const IWORKPathPtr_t path(m_shapePathCache.makePolygonPath(size, edges));
   if (bool(m_recorder))
     m_recorder->collectPath(path);
   else
@@ -387,7 +395,7 @@ void IWORKCollector::collectPolygonPath(const IWORKSize &size, const unsigned ed
 
 void IWORKCollector::collectRoundedRectanglePath(const IWORKSize &size, const double radius)
 {
-  const IWORKPathPtr_t path(makeRoundedRectanglePath(size, radius));
+  const IWORKPathPtr_t path(m_shapePathCache.makeRoundedRectanglePath(size, radius));
   if (bool(m_recorder))
     m_recorder->collectPath(path);
   else
@@ -398,9 +406,9 @@ void IWORKCollector::collectArrowPath(const IWORKSize &size, const double headWi
 {
   IWORKPathPtr_t path;
   if (doubleSided)
-    path = makeDoubleArrowPath(size, headWidth, stemRelYPos);
+    path = m_shapePathCache.makeDoubleArrowPath(size, headWidth, stemRelYPos);
   else
-    path = makeArrowPath(size, headWidth, stemRelYPos);
+    path = m_shapePathCache.makeArrowPath(size, headWidth, stemRelYPos);
   if (bool(m_recorder))
     m_recorder->collectPath(path);
   else
@@ -409,7 +417,7 @@ void IWORKCollector::collectArrowPath(const IWORKSize &size, const double headWi
 
 void IWORKCollector::collectStarPath(const IWORKSize &size, const unsigned points, const double innerRadius)
 {
-  const IWORKPathPtr_t path(makeStarPath(size, points, innerRadius));
+  const IWORKPathPtr_t path(m_shapePathCache.makeStarPath(size, points, innerRadius));
   if (bool(m_recorder))
     m_recorder->collectPath(path);
   else
@@ -429,9 +437,9 @@ void IWORKCollector::collectCalloutPath(const IWORKSize &size, const double radi
 {
   IWORKPathPtr_t path;
   if (quoteBubble)
-    path = makeQuoteBubblePath(size, radius, tailSize, tailX, tailY);
+    path = m_shapePathCache.makeQuoteBubblePath(size, radius, tailSize, tailX, tailY);
   else
-    path = makeCalloutPath(size, radius, tailSize, tailX, tailY);
+    path = m_shapePathCache.makeCalloutPath(size, radius, tailSize, tailX, tailY);
   if (bool(m_recorder))
     m_recorder->collectPath(path);
   else
@@ -470,6 +478,8 @@ void IWORKCollector::collectStylesheet(const IWORKStylesheetPtr_t &stylesheet)
   }
 
   for_each(m_newStyles.begin(), m_newStyles.end(), std::bind(&IWORKStyle::link, _1, stylesheet));
+  // all the parents are known now
+  for_each(m_newStyles.begin(), m_newStyles.end(), std::bind(&IWORKStyle::freeze, _1));
   m_newStyles.clear();
 }
 
@@ -1106,6 +1116,7 @@ void IWORKCollector::drawMedia(const IWORKMediaPtr_t &media)
       && bool(media->m_content->m_data->m_stream))
   {
     const glm::dmat3 trafo = m_levelStack.top().m_trafo;
+    const std::lock_guard<std::mutex> lock(media->m_content->m_data->m_mutex);
     const RVNGInputStreamPtr_t input = media->m_content->m_data->m_stream;
 
     std::string mimetype(media->m_content->m_data->m_mimeType);
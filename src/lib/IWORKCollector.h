@@ -199,6 +199,7 @@ private:
   IWORKMediaContentPtr_t m_currentContent;
 
   IWORKMetadata m_metadata;
+  IWORKShapePathCache m_shapePathCache;
 
   bool m_accumulateTransform;
   int m_groupLevel;
@@ -9,9 +9,29 @@
 
 #include "IWORKDictionary.h"
 
+#include "IWORKProperties.h"
+
 namespace libetonyek
 {
 
+namespace
+{
+
+void createListLevels(const IWORKStyleMap_t &styles)
+{
+  for (const auto &it : styles)
+  {
+    if (bool(it.second) && it.second->has<property::ListStyle>())
+    {
+      const IWORKStylePtr_t &listStyle = it.second->get<property::ListStyle>();
+      if (bool(listStyle))
+        listStyle->createListLevelStyles();
+    }
+  }
+}
+
+}
+
 IWORKDictionary::IWORKDictionary()
   : m_cellStyles()
   , m_cellCommentStyles()
@@ -71,6 +91,16 @@ IWORKDictionary::IWORKDictionary()
 {
 }
 
+void IWORKDictionary::createListLevelStyles()
+{
+  createListLevels(m_paragraphStyles);
+  for (const auto &it : m_stylesheets)
+  {
+    if (bool(it.second))
+      createListLevels(it.second->m_styles);
+  }
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
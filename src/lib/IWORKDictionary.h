@@ -40,6 +40,14 @@ struct IWORKDictionary
 {
   IWORKDictionary();
 
+  /** Create the list levels of the list styles of all paragraph styles.
+    *
+    * IWORKText does that on first use, which modifies the list style.
+    * It has to be done in advance if the styles are going to be used by
+    * several parsers at once.
+    */
+  void createListLevelStyles();
+
   IWORKStyleMap_t m_cellStyles;
   IWORKStyleMap_t m_cellCommentStyles;
   IWORKStyleMap_t m_characterStyles;
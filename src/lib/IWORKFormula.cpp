@@ -10,15 +10,13 @@
 #include "IWORKFormula.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <limits>
 #include <sstream>
 #include <utility>
 #include <vector>
 
-#include <boost/fusion/adapted/std_pair.hpp>
-#include <boost/fusion/include/adapt_struct.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/include/phoenix.hpp>
 #include <boost/variant/recursive_variant.hpp>
 
 namespace libetonyek
@@ -34,7 +32,7 @@ using std::vector;
 
 std::ostream &operator<<(std::ostream &s, IWORKFormula::Address const &ad)
 {
-  if (ad.m_table) s << "[" << get(ad.m_table) << "]";
+  if (ad.m_table) s << "[" << *ad.m_table << "]";
   if (ad.m_column)
   {
     if (get(ad.m_column).m_absolute) s << "$";
@@ -48,34 +46,13 @@ std::ostream &operator<<(std::ostream &s, IWORKFormula::Address const &ad)
   return s;
 }
 
-std::ostream &operator<<(std::ostream &s, IWORKFormula::Token const &dt)
-{
-  switch (dt.m_type)
-  {
-  case IWORKFormula::Token::Cell:
-    s << dt.m_address;
-    break;
-  case IWORKFormula::Token::Double:
-    s << dt.m_value;
-    break;
-  case IWORKFormula::Token::Operator:
-  case IWORKFormula::Token::Function:
-    s << dt.m_string;
-    break;
-  case IWORKFormula::Token::String:
-    s << "\"" << dt.m_string << "\"";
-    break;
-#if !defined(__clang__)
-  default:
-    ETONYEK_DEBUG_MSG(("IWORKFormula::Token::operator<<: unexpected token\n"));
-    break;
-#endif
-  }
-  return s;
-}
-
 typedef std::pair<IWORKFormula::Address, IWORKFormula::Address> AddressRange;
 
+/// An omitted argument.
+struct EmptyExpr
+{
+};
+
 struct TrueOrFalseFunc
 {
   TrueOrFalseFunc()
@@ -91,7 +68,7 @@ struct InfixOp;
 struct PostfixOp;
 struct PExpr;
 
-typedef variant<double, string, TrueOrFalseFunc, IWORKFormula::Address, AddressRange, recursive_wrapper<PrefixOp>, recursive_wrapper<InfixOp>, recursive_wrapper<PostfixOp>, recursive_wrapper<Function>, recursive_wrapper<PExpr> > Expression;
+typedef variant<double, string, EmptyExpr, TrueOrFalseFunc, IWORKFormula::Address, AddressRange, recursive_wrapper<PrefixOp>, recursive_wrapper<InfixOp>, recursive_wrapper<PostfixOp>, recursive_wrapper<Function>, recursive_wrapper<PExpr> > Expression;
 
 struct PrefixOp
 {
@@ -140,257 +117,483 @@ struct Function
   vector<Expression> m_args;
 };
 
+/// A parenthesized list of expressions. Text formulas only have one.
 struct PExpr
 {
   PExpr()
-    : m_expr()
+    : m_exprs()
   {
   }
-  Expression m_expr;
+  vector<Expression> m_exprs;
 };
 
+namespace
+{
+
+bool isDigit(const char c)
+{
+  return (c >= '0') && (c <= '9');
 }
 
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::IWORKFormula::Coord,
-  (bool, m_absolute)
-  (int, m_coord)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::TrueOrFalseFunc,
-  (std::string, m_name)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::IWORKFormula::Address,
-  (optional<std::string>, m_table)
-  (optional<libetonyek::IWORKFormula::Coord>, m_column)
-  (optional<libetonyek::IWORKFormula::Coord>, m_row)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::PrefixOp,
-  (char, m_op)
-  (libetonyek::Expression, m_expr)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::InfixOp,
-  (libetonyek::Expression, m_left)
-  (std::string, m_op)
-  (libetonyek::Expression, m_right)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::PostfixOp,
-  (libetonyek::Expression, m_expr)
-  (char, m_op)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::Function,
-  (std::string, m_name)
-  (std::vector<libetonyek::Expression>, m_args)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::PExpr,
-  (libetonyek::Expression, m_expr)
-)
+bool isAlpha(const char c)
+{
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
 
-namespace libetonyek
+bool isAlnum(const char c)
 {
+  return isAlpha(c) || isDigit(c);
+}
 
-namespace
+bool isHexDigit(const char c)
+{
+  return isDigit(c) || ((c >= 'a') && (c <= 'f')) || ((c >= 'A') && (c <= 'F'));
+}
+
+bool isSpace(const char c)
 {
+  return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+}
 
-namespace ascii = boost::spirit::ascii;
-namespace fusion = boost::fusion;
-namespace phoenix = boost::phoenix;
-namespace qi = boost::spirit::qi;
-
-unsigned parseRowName(const vector<char> &columnName)
-{
-  unsigned columnNumber = 0;
-
-  for (char it : columnName)
-    columnNumber = 26 * columnNumber + unsigned(toupper(it) - 'A') + 1;
-  return columnNumber;
-}
-
-#if defined _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 4100) // unreferenced formal parameter in boost
-#endif
-
-template<typename Iterator>
-struct FormulaGrammar : public qi::grammar<Iterator, Expression()>
-{
-  FormulaGrammar()
-    : FormulaGrammar::base_type(formula, "formula")
-    , function()
-    , trueOrFalseFunction()
-    , expression()
-    , formula()
-    , term()
-    , pExpr()
-    , address()
-    , addressSpecialColumn()
-    , addressSpecialNoTableRow()
-    , addressSpecialRow()
-    , range()
-    , columnName()
-    , column()
-    , row()
-    , number()
-    , str()
-    , table()
-    , infixLit()
-    , trueOrFalseFunctionLit()
-    , prefixOp()
-    , infixOp()
-    , postfixOp()
-    , prefixLit()
-    , postfixLit()
-    , mappedName()
-  {
-    using ascii::char_;
-    using ascii::string;
-    using boost::none;
-    using phoenix::bind;
-    using qi::_1;
-    using qi::_a;
-    using qi::_val;
-    using qi::alpha;
-    using qi::alnum;
-    using qi::attr;
-    using qi::double_;
-    using qi::lit;
-    using qi::no_case;
-    using qi::uint_;
-
-    createFunctionNameMap();
-
-    number %= double_;
-    str %= lit('\"') >> +(char_ - '\"') >> '\"';
-    trueOrFalseFunctionLit %= string("TRUE")|string("FALSE");
-    prefixLit %= char_('+') | char_('-');
-    infixLit %=
-      char_('+') | char_('-') | char_('*') | char_('/')
-      | string("<>") | string("<=") | string(">=")
-      | char_('^') | char_('=') | char_('>') | char_('<')
-      ;
-    postfixLit %= char_('%');
+/** A parser of formulas of the XML formats.
+  *
+  * It accepts the same language as the Spirit grammar it replaces and
+  * produces the same expression tree: there is no operator precedence,
+  * an operator's right operand is the whole rest of the expression.
+  * Whitespace is only allowed around the formula, at the start of an
+  * expression and around the "::" table separator.
+  *
+  * All parse functions either succeed and move the current position
+  * past the parsed text or fail and leave the position unchanged.
+  */
+class FormulaParser
+{
+public:
+  FormulaParser(const char *begin, const char *end);
 
-    row %=
-      lit('$') >> attr(true) >> uint_
-      | attr(false) >> uint_
-      ;
+  bool parse(Expression &formula);
 
-    column %=
-      lit('$') >> attr(true) >> columnName
-      | attr(false) >> columnName
-      ;
+private:
+  enum AddressKind
+  {
+    ADDRESS_CELL, //< [table ::] column row
+    ADDRESS_COLUMN, //< [table ::] column
+    ADDRESS_TABLE_ROW, //< table :: row
+    ADDRESS_ROW //< row
+  };
 
-    columnName = (+alpha)[_val = bind(parseRowName, _1)] >> !lit("_");
+  bool parseExpression(Expression &expr);
+  bool parseTerm(Expression &term);
 
-    table %= lit("SFTGlobalID_") >> +char_("0-9a-fA-F");
+  bool parseString(string &str);
+  bool parseFunction(Function &func);
+  bool parseTrueOrFalse(TrueOrFalseFunc &func);
+  bool parseRange(AddressRange &range);
+  bool parseAddress(AddressKind kind, IWORKFormula::Address &address);
+  bool parseNumber(double &value);
+  bool parsePrefixOp(PrefixOp &op);
+  bool parsePExpr(PExpr &pExpr);
 
-    address %=
-      table >> *lit(' ') >> "::" >> *lit(' ') >> column >> row
-      | attr(none) >> column >> row
-      ;
+  bool parseInfixLit(string &op);
 
-    addressSpecialColumn %=
-      table >> *lit(' ') >> "::" >> *lit(' ') >> column >> attr(none)
-      | attr(none) >> column >> attr(none)
-      ;
+  bool parseTable(const char *&pos, string &table) const;
+  bool parseColumn(const char *&pos, IWORKFormula::Coord &column) const;
+  bool parseRow(const char *&pos, IWORKFormula::Coord &row) const;
 
-    addressSpecialRow %= table >> *lit(' ') >> "::" >> *lit(' ') >> attr(none) >> row;
-    addressSpecialNoTableRow %= attr(none) >> attr(none) >> row;
+  bool accept(char c);
 
-    range %=
-      address >> ':' >> address
-      | addressSpecialColumn >> ':' >> addressSpecialColumn
-      | addressSpecialRow >> ':' >> addressSpecialRow
-      | addressSpecialNoTableRow >> ":" >> addressSpecialNoTableRow
-      ;
+private:
+  const char *m_pos;
+  const char *const m_end;
+};
 
-    prefixOp %= prefixLit >> term;
-    infixOp %= term >> infixLit >> expression;
-    trueOrFalseFunction %= trueOrFalseFunctionLit;
-    postfixOp %= term >> postfixLit;
-
-    function %= (no_case[mappedName] | +alnum) >> '(' >> -(expression % ',') >> ')';
-
-    pExpr %= '(' >> expression >> ')';
-
-    term %=
-      str
-      | function
-      | trueOrFalseFunction
-      | range
-      | address
-      | addressSpecialColumn
-      | addressSpecialRow
-      | number
-      | prefixOp
-      | pExpr
-      ;
+FormulaParser::FormulaParser(const char *const begin, const char *const end)
+  : m_pos(begin)
+  , m_end(end)
+{
+}
+
+bool FormulaParser::parse(Expression &formula)
+{
+  while ((m_pos != m_end) && isSpace(*m_pos))
+    ++m_pos;
+  if (!accept('=') || !parseExpression(formula))
+    return false;
+  while ((m_pos != m_end) && isSpace(*m_pos))
+    ++m_pos;
+  return m_pos == m_end;
+}
 
-    expression %=
-      lit(' ') >> expression
-      | infixOp
-      | postfixOp
-      | term
+bool FormulaParser::parseExpression(Expression &expr)
+{
+  // collect the chain term op term op ... term and build the (right
+  // recursive) tree at the end, to avoid deep recursion
+  const char *const start = m_pos;
+  vector<Expression> terms;
+  vector<string> ops;
+  terms.reserve(4);
+  for (;;)
+  {
+    while (accept(' '))
       ;
+    terms.push_back(Expression());
+    if (!parseTerm(terms.back()))
+    {
+      m_pos = start;
+      return false;
+    }
+    string op;
+    if (parseInfixLit(op))
+    {
+      ops.push_back(op);
+      continue;
+    }
+    if (accept('%'))
+    {
+      PostfixOp postfixOp;
+      postfixOp.m_expr = std::move(terms.back());
+      postfixOp.m_op = '%';
+      terms.back() = postfixOp;
+    }
+    break;
+  }
 
-    formula %= lit('=') >> expression;
-
-    number.name("number");
-    str.name("str");
-    trueOrFalseFunction.name("trueOrFalseFunction");
-    prefixOp.name("prefixOp");
-    infixOp.name("infixOp");
-    row.name("row");
-    column.name("column");
-    columnName.name("columnName");
-    table.name("table");
-    address.name("address");
-    range.name("range");
-    function.name("function");
-    expression.name("expression");
-    term.name("term");
-    formula.name("formula");
-    pExpr.name("pExpr");
-  }
-
-  void createFunctionNameMap()
-  {
-  }
-
-  qi::rule<Iterator, Function()> function;
-  qi::rule<Iterator, TrueOrFalseFunc()> trueOrFalseFunction;
-  qi::rule<Iterator, Expression()> expression, formula, term;
-  qi::rule<Iterator, PExpr()> pExpr;
-  qi::rule<Iterator, IWORKFormula::Address()> address, addressSpecialColumn, addressSpecialNoTableRow, addressSpecialRow;
-  qi::rule<Iterator, AddressRange()> range;
-  qi::rule<Iterator, unsigned()> columnName;
-  qi::rule<Iterator, IWORKFormula::Coord()> column, row;
-  qi::rule<Iterator, double()> number;
-  qi::rule<Iterator, string()> str, table, infixLit, trueOrFalseFunctionLit;
-  qi::rule<Iterator, PrefixOp()> prefixOp;
-  qi::rule<Iterator, InfixOp()> infixOp;
-  qi::rule<Iterator, PostfixOp()> postfixOp;
-  qi::rule<Iterator, char()> prefixLit, postfixLit;
-
-  qi::symbols<char, string> mappedName;
-};
+  Expression result(std::move(terms.back()));
+  for (std::size_t i = ops.size(); i > 0; --i)
+  {
+    InfixOp infixOp;
+    infixOp.m_left = std::move(terms[i - 1]);
+    infixOp.m_op = std::move(ops[i - 1]);
+    infixOp.m_right = std::move(result);
+    result = infixOp;
+  }
+  expr = std::move(result);
+  return true;
+}
 
-#if defined _MSC_VER
-#pragma warning(pop)
-#endif
+bool FormulaParser::parseTerm(Expression &term)
+{
+  // the alternatives are tried in this order
+  {
+    string str;
+    if (parseString(str))
+    {
+      term = str;
+      return true;
+    }
+  }
+  {
+    Function func;
+    if (parseFunction(func))
+    {
+      term = func;
+      return true;
+    }
+  }
+  {
+    TrueOrFalseFunc func;
+    if (parseTrueOrFalse(func))
+    {
+      term = func;
+      return true;
+    }
+  }
+  {
+    AddressRange range;
+    if (parseRange(range))
+    {
+      term = range;
+      return true;
+    }
+  }
+  {
+    IWORKFormula::Address address;
+    if (parseAddress(ADDRESS_CELL, address) || parseAddress(ADDRESS_COLUMN, address) || parseAddress(ADDRESS_TABLE_ROW, address))
+    {
+      term = address;
+      return true;
+    }
+  }
+  {
+    double value = 0;
+    if (parseNumber(value))
+    {
+      term = value;
+      return true;
+    }
+  }
+  {
+    PrefixOp prefixOp;
+    if (parsePrefixOp(prefixOp))
+    {
+      term = prefixOp;
+      return true;
+    }
+  }
+  {
+    PExpr pExpr;
+    if (parsePExpr(pExpr))
+    {
+      term = pExpr;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FormulaParser::parseString(string &str)
+{
+  if ((m_pos == m_end) || (*m_pos != '"'))
+    return false;
+  const char *const begin = m_pos + 1;
+  const char *end = begin;
+  while ((end != m_end) && (*end != '"'))
+    ++end;
+  if ((end == m_end) || (end == begin))
+    return false;
+  str.assign(begin, end);
+  m_pos = end + 1;
+  return true;
+}
+
+bool FormulaParser::parseFunction(Function &func)
+{
+  const char *const start = m_pos;
+  const char *nameEnd = m_pos;
+  while ((nameEnd != m_end) && isAlnum(*nameEnd))
+    ++nameEnd;
+  if ((nameEnd == m_pos) || (nameEnd == m_end) || (*nameEnd != '('))
+    return false;
+  m_pos = nameEnd + 1;
+
+  Expression arg;
+  if (parseExpression(arg))
+  {
+    func.m_args.push_back(std::move(arg));
+    for (;;)
+    {
+      const char *const beforeComma = m_pos;
+      if (!accept(','))
+        break;
+      if (!parseExpression(arg))
+      {
+        m_pos = beforeComma;
+        break;
+      }
+      func.m_args.push_back(std::move(arg));
+    }
+  }
+  if (!accept(')'))
+  {
+    m_pos = start;
+    func.m_args.clear();
+    return false;
+  }
+  func.m_name.assign(start, nameEnd);
+  return true;
+}
+
+bool FormulaParser::parseTrueOrFalse(TrueOrFalseFunc &func)
+{
+  const std::size_t len = std::size_t(m_end - m_pos);
+  if ((len >= 4) && (std::memcmp(m_pos, "TRUE", 4) == 0))
+    func.m_name = "TRUE";
+  else if ((len >= 5) && (std::memcmp(m_pos, "FALSE", 5) == 0))
+    func.m_name = "FALSE";
+  else
+    return false;
+  m_pos += func.m_name.size();
+  return true;
+}
+
+bool FormulaParser::parseRange(AddressRange &range)
+{
+  const char *const start = m_pos;
+  const AddressKind kinds[] = { ADDRESS_CELL, ADDRESS_COLUMN, ADDRESS_TABLE_ROW, ADDRESS_ROW };
+  for (const auto kind : kinds)
+  {
+    if (parseAddress(kind, range.first) && accept(':') && parseAddress(kind, range.second))
+      return true;
+    m_pos = start;
+  }
+  return false;
+}
+
+bool FormulaParser::parseAddress(const AddressKind kind, IWORKFormula::Address &address)
+{
+  const char *pos = m_pos;
+  IWORKFormula::Address result;
+  string table;
+  if ((kind != ADDRESS_ROW) && parseTable(pos, table))
+    result.m_table = std::make_shared<const string>(table);
+  else if (kind == ADDRESS_TABLE_ROW)
+    return false;
+
+  IWORKFormula::Coord column;
+  IWORKFormula::Coord row;
+  switch (kind)
+  {
+  case ADDRESS_CELL :
+    if (!parseColumn(pos, column) || !parseRow(pos, row))
+      return false;
+    result.m_column = column;
+    result.m_row = row;
+    break;
+  case ADDRESS_COLUMN :
+    if (!parseColumn(pos, column))
+      return false;
+    result.m_column = column;
+    break;
+  case ADDRESS_TABLE_ROW :
+  case ADDRESS_ROW :
+    if (!parseRow(pos, row))
+      return false;
+    result.m_row = row;
+    break;
+  }
+
+  address = result;
+  m_pos = pos;
+  return true;
+}
+
+bool FormulaParser::parseNumber(double &value)
+{
+  return parseDouble(m_pos, m_end, value);
+}
+
+bool FormulaParser::parsePrefixOp(PrefixOp &op)
+{
+  if ((m_pos == m_end) || ((*m_pos != '+') && (*m_pos != '-')))
+    return false;
+  const char *const start = m_pos;
+  op.m_op = *m_pos;
+  ++m_pos;
+  if (!parseTerm(op.m_expr))
+  {
+    m_pos = start;
+    return false;
+  }
+  return true;
+}
+
+bool FormulaParser::parsePExpr(PExpr &pExpr)
+{
+  const char *const start = m_pos;
+  pExpr.m_exprs.resize(1);
+  if (accept('(') && parseExpression(pExpr.m_exprs.front()) && accept(')'))
+    return true;
+  m_pos = start;
+  return false;
+}
+
+bool FormulaParser::parseInfixLit(string &op)
+{
+  if (m_pos == m_end)
+    return false;
+  const char c = *m_pos;
+  const char next = (m_pos + 1 != m_end) ? m_pos[1] : 0;
+  std::size_t len = 0;
+  switch (c)
+  {
+  case '+' :
+  case '-' :
+  case '*' :
+  case '/' :
+  case '^' :
+  case '=' :
+    len = 1;
+    break;
+  case '<' :
+    len = ((next == '>') || (next == '=')) ? 2 : 1;
+    break;
+  case '>' :
+    len = (next == '=') ? 2 : 1;
+    break;
+  default :
+    return false;
+  }
+  op.assign(m_pos, len);
+  m_pos += len;
+  return true;
+}
+
+bool FormulaParser::parseTable(const char *&pos, string &table) const
+{
+  static const char prefix[] = "SFTGlobalID_";
+  const std::size_t prefixLen = sizeof(prefix) - 1;
+  const char *p = pos;
+  if ((std::size_t(m_end - p) < prefixLen) || (std::memcmp(p, prefix, prefixLen) != 0))
+    return false;
+  p += prefixLen;
+  const char *const begin = p;
+  while ((p != m_end) && isHexDigit(*p))
+    ++p;
+  const char *const end = p;
+  if (begin == end)
+    return false;
+  while ((p != m_end) && (*p == ' '))
+    ++p;
+  if ((m_end - p < 2) || (p[0] != ':') || (p[1] != ':'))
+    return false;
+  p += 2;
+  while ((p != m_end) && (*p == ' '))
+    ++p;
+  table.assign(begin, end);
+  pos = p;
+  return true;
+}
+
+bool FormulaParser::parseColumn(const char *&pos, IWORKFormula::Coord &column) const
+{
+  const char *p = pos;
+  const bool absolute = (p != m_end) && (*p == '$');
+  if (absolute)
+    ++p;
+  unsigned coord = 0;
+  const char *const begin = p;
+  for (; (p != m_end) && isAlpha(*p); ++p)
+    coord = 26 * coord + unsigned((*p & ~0x20) - 'A') + 1;
+  if ((p == begin) || ((p != m_end) && (*p == '_')))
+    return false;
+  column.m_absolute = absolute;
+  column.m_coord = int(coord);
+  pos = p;
+  return true;
+}
+
+bool FormulaParser::parseRow(const char *&pos, IWORKFormula::Coord &row) const
+{
+  const char *p = pos;
+  const bool absolute = (p != m_end) && (*p == '$');
+  if (absolute)
+    ++p;
+  unsigned coord = 0;
+  const char *const begin = p;
+  for (; (p != m_end) && isDigit(*p); ++p)
+  {
+    const auto digit = unsigned(*p - '0');
+    if (coord > (std::numeric_limits<unsigned>::max() - digit) / 10)
+      return false;
+    coord = coord * 10 + digit;
+  }
+  if (p == begin)
+    return false;
+  row.m_absolute = absolute;
+  row.m_coord = int(coord);
+  pos = p;
+  return true;
+}
+
+bool FormulaParser::accept(const char c)
+{
+  if ((m_pos != m_end) && (*m_pos == c))
+  {
+    ++m_pos;
+    return true;
+  }
+  return false;
+}
 
 }
 
@@ -418,6 +621,10 @@ struct Printer : public boost::static_visitor<void>
     m_out << val;
   }
 
+  void operator()(const EmptyExpr &) const
+  {
+  }
+
   void operator()(const IWORKFormula::Address &val) const
   {
     m_out << '[';
@@ -434,29 +641,6 @@ struct Printer : public boost::static_visitor<void>
     m_out << ']';
   }
 
-  void operator()(const IWORKFormula::Token &val) const
-  {
-    switch (val.m_type)
-    {
-    case IWORKFormula::Token::Cell:
-      operator()(val.m_address);
-      break;
-    case IWORKFormula::Token::Double:
-      m_out << val.m_value;
-      break;
-    case IWORKFormula::Token::Function:
-    case IWORKFormula::Token::Operator:
-    case IWORKFormula::Token::String:
-      m_out << val.m_string;
-      break;
-#if !defined(__clang__)
-    default:
-      ETONYEK_DEBUG_MSG(("IWORKFormula::Printer::operator(): unexpected token\n"));
-      break;
-#endif
-    }
-  }
-
   void operator()(const TrueOrFalseFunc &val) const
   {
     m_out << val.m_name << "()";
@@ -496,7 +680,12 @@ struct Printer : public boost::static_visitor<void>
   void operator()(const recursive_wrapper<PExpr> &val) const
   {
     m_out << '(';
-    apply_visitor(Printer(m_out, m_offsetColumn, m_offsetRow), val.get().m_expr);
+    for (auto it = val.get().m_exprs.begin(); it != val.get().m_exprs.end(); ++it)
+    {
+      if (it != val.get().m_exprs.begin())
+        m_out << ';';
+      apply_visitor(Printer(m_out, m_offsetColumn, m_offsetRow), *it);
+    }
     m_out << ')';
   }
 
@@ -504,7 +693,7 @@ private:
   void formatAddress(const IWORKFormula::Address &val) const
   {
     if (val.m_table)
-      m_out << get(val.m_table);
+      m_out << *val.m_table;
     m_out  << '.';
     if (val.m_column)
     {
@@ -549,15 +738,85 @@ private:
 namespace
 {
 
+/// A cell reference in a written formula.
+struct Reference
+{
+  Reference(const unsigned long index, const IWORKFormula::Address &start, const optional<IWORKFormula::Address> &end = boost::none)
+    : m_index(index)
+    , m_start(start)
+    , m_end(end)
+  {
+  }
+
+  unsigned long m_index; //< the index of the property list of the reference
+  IWORKFormula::Address m_start;
+  optional<IWORKFormula::Address> m_end; //< the end of a range
+};
+
+void insertCoord(librevenge::RVNGPropertyList &props, const char *const absoluteName, const char *const name, const optional<IWORKFormula::Coord> &coord, const int offset)
+{
+  if (!coord)
+    return;
+  const int realOffset = get(coord).m_absolute ? 0 : offset;
+  if (get(coord).m_coord + realOffset > 0)
+  {
+    props.insert(absoluteName, get(coord).m_absolute);
+    props.insert(name, get(coord).m_coord - 1 + realOffset);
+  }
+}
+
+/// Add the sheet name and the coordinates of a reference, as seen from a cell at the given offset.
+void insertReference(librevenge::RVNGPropertyList &props, const Reference &ref, const IWORKTableNameMapPtr_t &tableNameMap, const int offsetColumn, const int offsetRow)
+{
+  if (!ref.m_end && ref.m_start.m_table)
+  {
+    std::string tableName("SFTGlobalID_");
+    tableName+=*ref.m_start.m_table;
+    if (tableNameMap)
+    {
+      auto it = tableNameMap->find(tableName);
+      if (tableNameMap->end() != it)
+        props.insert("librevenge:sheet-name", (it->second).c_str());
+      else
+      {
+        ETONYEK_DEBUG_MSG(("IWORKFormula::write: can not find the table name: %s\n", tableName.c_str()));
+        props.insert("librevenge:sheet-name", tableName.c_str());
+      }
+    }
+    else
+    {
+      ETONYEK_DEBUG_MSG(("IWORKFormula::write: can not find the table name: %s[no correspondance tables]\n", tableName.c_str()));
+      props.insert("librevenge:sheet-name", tableName.c_str());
+    }
+  }
+
+  if (ref.m_end)
+  {
+    insertCoord(props, "librevenge:start-column-absolute", "librevenge:start-column", ref.m_start.m_column, offsetColumn);
+    insertCoord(props, "librevenge:start-row-absolute", "librevenge:start-row", ref.m_start.m_row, offsetRow);
+    insertCoord(props, "librevenge:end-column-absolute", "librevenge:end-column", get(ref.m_end).m_column, offsetColumn);
+    insertCoord(props, "librevenge:end-row-absolute", "librevenge:end-row", get(ref.m_end).m_row, offsetRow);
+  }
+  else
+  {
+    insertCoord(props, "librevenge:column-absolute", "librevenge:column", ref.m_start.m_column, offsetColumn);
+    insertCoord(props, "librevenge:row-absolute", "librevenge:row", ref.m_start.m_row, offsetRow);
+  }
+}
+
+/** Collects the property lists of a formula.
+  *
+  * The coordinates of cell references are left out, because they
+  * depend on the host cell, and so are the sheet names, which depend
+  * on the table name map. The references are collected instead, so
+  * both can be added by insertReference.
+  */
 struct Collector : public boost::static_visitor<>
 {
 
-  explicit Collector(librevenge::RVNGPropertyListVector &propsVector, const IWORKTableNameMapPtr_t &tableNameMap,
-                     int offsetColumn, int offsetRow)
+  explicit Collector(librevenge::RVNGPropertyListVector &propsVector, vector<Reference> &refs)
     : m_propsVector(propsVector)
-    , m_tableNameMap(tableNameMap)
-    , m_offsetColumn(offsetColumn)
-    , m_offsetRow(offsetRow)
+    , m_refs(refs)
   { }
 
   void operator()(double val) const
@@ -576,6 +835,10 @@ struct Collector : public boost::static_visitor<>
     m_propsVector.append(props);
   }
 
+  void operator()(const EmptyExpr &) const
+  {
+  }
+
   void operator()(const TrueOrFalseFunc &val) const
   {
     librevenge::RVNGPropertyList props1;
@@ -596,47 +859,7 @@ struct Collector : public boost::static_visitor<>
     librevenge::RVNGPropertyList props;
     props.insert("librevenge:type", "librevenge-cell");
 
-    if (val.m_table)
-    {
-      std::string tableName("SFTGlobalID_");
-      tableName+=get(val.m_table);
-      if (m_tableNameMap)
-      {
-        auto it = m_tableNameMap->find(tableName);
-        if (m_tableNameMap->end() != it)
-          props.insert("librevenge:sheet-name", (it->second).c_str());
-        else
-        {
-          ETONYEK_DEBUG_MSG(("IWORKFormula::operator()(IWORKFormula::Address): can not find the table name: %s\n", tableName.c_str()));
-          props.insert("librevenge:sheet-name", tableName.c_str());
-        }
-      }
-      else
-      {
-        ETONYEK_DEBUG_MSG(("IWORKFormula::operator()(IWORKFormula::Address): can not find the table name: %s[no correspondance tables]\n", tableName.c_str()));
-        props.insert("librevenge:sheet-name", tableName.c_str());
-      }
-    }
-
-    if (val.m_column)
-    {
-      int offsetColumn=get(val.m_column).m_absolute ? 0 : m_offsetColumn;
-      if (int(get(val.m_column).m_coord)+offsetColumn>0)
-      {
-        props.insert("librevenge:column-absolute", get(val.m_column).m_absolute);
-        props.insert("librevenge:column", int(get(val.m_column).m_coord)-1+offsetColumn);
-      }
-    }
-
-    if (val.m_row)
-    {
-      int offsetRow=get(val.m_row).m_absolute ? 0 : m_offsetRow;
-      if (int(get(val.m_row).m_coord)+offsetRow>0)
-      {
-        props.insert("librevenge:row-absolute", get(val.m_row).m_absolute);
-        props.insert("librevenge:row", int(get(val.m_row).m_coord)-1+offsetRow);
-      }
-    }
+    m_refs.push_back(Reference(m_propsVector.count(), val));
 
     m_propsVector.append(props);
   }
@@ -646,80 +869,10 @@ struct Collector : public boost::static_visitor<>
     librevenge::RVNGPropertyList props;
     props.insert("librevenge:type", "librevenge-cells");
 
-    if (val.first.m_column)
-    {
-      int offsetColumn=get(val.first.m_column).m_absolute ? 0 : m_offsetColumn;
-      if (int(get(val.first.m_column).m_coord)+offsetColumn>0)
-      {
-        props.insert("librevenge:start-column-absolute", get(val.first.m_column).m_absolute);
-        props.insert("librevenge:start-column", int(get(val.first.m_column).m_coord)-1+offsetColumn);
-      }
-    }
-    if (val.first.m_row)
-    {
-      int offsetRow=get(val.first.m_row).m_absolute ? 0 : m_offsetRow;
-      if (int(get(val.first.m_row).m_coord)+offsetRow>0)
-      {
-        props.insert("librevenge:start-row-absolute", get(val.first.m_row).m_absolute);
-        props.insert("librevenge:start-row", int(get(val.first.m_row).m_coord)-1+offsetRow);
-      }
-    }
-    if (val.second.m_column)
-    {
-      int offsetColumn=get(val.second.m_column).m_absolute ? 0 : m_offsetColumn;
-      if (int(get(val.second.m_column).m_coord)+offsetColumn>0)
-      {
-        props.insert("librevenge:end-column-absolute", get(val.second.m_column).m_absolute);
-        props.insert("librevenge:end-column", int(get(val.second.m_column).m_coord)-1+offsetColumn);
-      }
-    }
-    if (val.second.m_row)
-    {
-      int offsetRow=get(val.second.m_row).m_absolute ? 0 : m_offsetRow;
-      if (int(get(val.second.m_row).m_coord)+offsetRow>0)
-      {
-        props.insert("librevenge:end-row-absolute", get(val.second.m_row).m_absolute);
-        props.insert("librevenge:end-row", int(get(val.second.m_row).m_coord)-1+offsetRow);
-      }
-    }
+    m_refs.push_back(Reference(m_propsVector.count(), val.first, val.second));
     m_propsVector.append(props);
   }
 
-  void operator()(const IWORKFormula::Token &val) const
-  {
-    librevenge::RVNGPropertyList props;
-    switch (val.m_type)
-    {
-    case IWORKFormula::Token::Cell:
-      operator()(val.m_address);
-      break;
-    case IWORKFormula::Token::Double:
-      props.insert("librevenge:type", "librevenge-number");
-      props.insert("librevenge:number", val.m_value, librevenge::RVNG_GENERIC);
-      m_propsVector.append(props);
-      break;
-    case IWORKFormula::Token::Function:
-      props.insert("librevenge:type", "librevenge-function");
-      props.insert("librevenge:function", val.m_string.c_str());
-      m_propsVector.append(props);
-      break;
-    case IWORKFormula::Token::Operator:
-      props.insert("librevenge:type", "librevenge-operator");
-      props.insert("librevenge:operator", val.m_string.c_str());
-      m_propsVector.append(props);
-      break;
-    case IWORKFormula::Token::String:
-      props.insert("librevenge:type", "librevenge-text");
-      props.insert("librevenge:text", val.m_string.c_str());
-      m_propsVector.append(props);
-      break;
-#if !defined(__clang__)
-    default:
-      ETONYEK_DEBUG_MSG(("IWORKFormula::Collector::operator(): unexpected token\n"));
-      break;
-#endif
-    }
-  }
   void operator()(const recursive_wrapper<PrefixOp> &val) const
   {
     librevenge::RVNGPropertyList props;
@@ -728,22 +881,22 @@ struct Collector : public boost::static_visitor<>
     op+=val.get().m_op;
     props.insert("librevenge:operator", op.c_str());
     m_propsVector.append(props);
-    apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), val.get().m_expr);
+    apply_visitor(*this, val.get().m_expr);
   }
 
   void operator()(const recursive_wrapper<InfixOp> &val) const
   {
-    apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), val.get().m_left);
+    apply_visitor(*this, val.get().m_left);
     librevenge::RVNGPropertyList props;
     props.insert("librevenge:type", "librevenge-operator");
     props.insert("librevenge:operator", val.get().m_op.c_str());
     m_propsVector.append(props);
-    apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), val.get().m_right);
+    apply_visitor(*this, val.get().m_right);
   }
 
   void operator()(const recursive_wrapper<PostfixOp> &val) const
   {
-    apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), val.get().m_expr);
+    apply_visitor(*this, val.get().m_expr);
     librevenge::RVNGPropertyList props;
     props.insert("librevenge:type", "librevenge-operator");
     std::string op;
@@ -772,7 +925,7 @@ struct Collector : public boost::static_visitor<>
     {
       if (it != val.get().m_args.begin())
         m_propsVector.append(props);
-      apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), *it);
+      apply_visitor(*this, *it);
     }
     librevenge::RVNGPropertyList props3;
     props3.insert("librevenge:type", "librevenge-operator");
@@ -787,7 +940,16 @@ struct Collector : public boost::static_visitor<>
     props.insert("librevenge:operator", "(");
     m_propsVector.append(props);
 
-    apply_visitor(Collector(m_propsVector, m_tableNameMap, m_offsetColumn, m_offsetRow), val.get().m_expr);
+    librevenge::RVNGPropertyList separator;
+    separator.insert("librevenge:type", "librevenge-operator");
+    separator.insert("librevenge:operator", ";");
+
+    for (auto it = val.get().m_exprs.begin(); it != val.get().m_exprs.end(); ++it)
+    {
+      if (it != val.get().m_exprs.begin())
+        m_propsVector.append(separator);
+      apply_visitor(*this, *it);
+    }
 
     librevenge::RVNGPropertyList props1;
     props1.insert("librevenge:type", "librevenge-operator");
@@ -798,8 +960,7 @@ struct Collector : public boost::static_visitor<>
 
 private:
   librevenge::RVNGPropertyListVector &m_propsVector;
-  const IWORKTableNameMapPtr_t &m_tableNameMap;
-  int m_offsetColumn, m_offsetRow;
+  vector<Reference> &m_refs;
 };
 
 }
@@ -808,36 +969,223 @@ struct IWORKFormula::Impl
 {
   Impl()
     : m_formula()
-    , m_tokenList()
   {
   }
   Expression m_formula;
-  std::vector<Token> m_tokenList;
 };
 
-IWORKFormula::IWORKFormula(const boost::optional<unsigned> &hc)
-  : m_impl(new Impl())
-  , m_hc(hc)
+IWORKFormula::Cache::Cache()
+  : m_formulas()
+  , m_hits(0)
+  , m_misses(0)
+{
+}
+
+IWORKFormula::Cache::~Cache()
+{
+  ETONYEK_DEBUG_MSG(("IWORKFormula::Cache: %u hits, %u misses\n", m_hits, m_misses));
+}
+
+unsigned IWORKFormula::Cache::getHits() const
 {
+  return m_hits;
 }
 
-bool IWORKFormula::parse(const std::string &formula)
+unsigned IWORKFormula::Cache::getMisses() const
 {
-  FormulaGrammar<string::const_iterator> grammar;
-  string::const_iterator it = formula.begin();
-  string::const_iterator end = formula.end();
-  const bool r = qi::phrase_parse(it, end, grammar, ascii::space, m_impl->m_formula);
-  if (!r || it!=end)
+  return m_misses;
+}
+
+/// A formula written without the sheet names and coordinates of its cell references.
+struct IWORKFormula::WriteCache::Template
+{
+  explicit Template(const std::shared_ptr<const Impl> &impl)
+    : m_impl(impl)
+    , m_props()
+    , m_refs()
   {
-    ETONYEK_DEBUG_MSG(("IWORKFormula::parse: can not parse %s\n", formula.c_str()));
+  }
+
+  const std::shared_ptr<const Impl> m_impl; //< keeps the key of the template alive
+  librevenge::RVNGPropertyListVector m_props;
+  vector<Reference> m_refs;
+};
+
+IWORKFormula::WriteCache::WriteCache()
+  : m_templates()
+{
+}
+
+struct IWORKFormula::Builder::Stack
+{
+  Stack()
+    : m_exprs()
+  {
+  }
+
+  /// Check that there are at least @c count expressions on the stack.
+  bool has(const size_t count, const char *const what) const
+  {
+    if (m_exprs.size() >= count)
+      return true;
+    ETONYEK_DEBUG_MSG(("IWORKFormula::Builder: bad stack for %s\n", what));
+    (void) what;
     return false;
   }
+
+  /// Move the top @c count expressions to @c args.
+  void pop(const size_t count, vector<Expression> &args)
+  {
+    const auto first = m_exprs.end() - std::ptrdiff_t(count);
+    args.reserve(count);
+    std::move(first, m_exprs.end(), std::back_inserter(args));
+    m_exprs.erase(first, m_exprs.end());
+  }
+
+  vector<Expression> m_exprs;
+};
+
+IWORKFormula::Builder::Builder()
+  : m_stack(new Stack())
+{
+}
+
+IWORKFormula::Builder::~Builder()
+{
+}
+
+void IWORKFormula::Builder::pushNumber(const double value)
+{
+  m_stack->m_exprs.push_back(value);
+}
+
+void IWORKFormula::Builder::pushString(const std::string &value)
+{
+  m_stack->m_exprs.push_back(value);
+}
+
+void IWORKFormula::Builder::pushBool(const bool value)
+{
+  TrueOrFalseFunc func;
+  func.m_name = value ? "True" : "False";
+  m_stack->m_exprs.push_back(std::move(func));
+}
+
+void IWORKFormula::Builder::pushAddress(const Address &address)
+{
+  m_stack->m_exprs.push_back(address);
+}
+
+void IWORKFormula::Builder::pushEmpty()
+{
+  m_stack->m_exprs.push_back(EmptyExpr());
+}
+
+bool IWORKFormula::Builder::applyPrefixOp(const char op)
+{
+  if (!m_stack->has(1, "prefix operator"))
+    return false;
+  PrefixOp prefixOp;
+  prefixOp.m_op = op;
+  prefixOp.m_expr = std::move(m_stack->m_exprs.back());
+  m_stack->m_exprs.back() = std::move(prefixOp);
+  return true;
+}
+
+bool IWORKFormula::Builder::applyPostfixOp(const char op)
+{
+  if (!m_stack->has(1, "postfix operator"))
+    return false;
+  PostfixOp postfixOp;
+  postfixOp.m_op = op;
+  postfixOp.m_expr = std::move(m_stack->m_exprs.back());
+  m_stack->m_exprs.back() = std::move(postfixOp);
   return true;
 }
 
-bool IWORKFormula::parse(const std::vector<IWORKFormula::Token> &formula)
+bool IWORKFormula::Builder::applyInfixOp(const char *const op)
 {
-  m_impl->m_tokenList=formula;
+  if (!m_stack->has(2, "infix operator"))
+    return false;
+  vector<Expression> &exprs = m_stack->m_exprs;
+  InfixOp infixOp;
+  infixOp.m_op = op;
+  infixOp.m_right = std::move(exprs.back());
+  exprs.pop_back();
+  infixOp.m_left = std::move(exprs.back());
+  exprs.back() = std::move(infixOp);
+  return true;
+}
+
+bool IWORKFormula::Builder::applyFunction(const std::string &name, const unsigned numArgs)
+{
+  if (!m_stack->has(numArgs, "function"))
+    return false;
+  Function func;
+  func.m_name = name;
+  m_stack->pop(numArgs, func.m_args);
+  m_stack->m_exprs.push_back(std::move(func));
+  return true;
+}
+
+bool IWORKFormula::Builder::applyParentheses(const unsigned numArgs)
+{
+  if (!m_stack->has(numArgs, "()"))
+    return false;
+  PExpr pExpr;
+  m_stack->pop(numArgs, pExpr.m_exprs);
+  m_stack->m_exprs.push_back(std::move(pExpr));
+  return true;
+}
+
+bool IWORKFormula::Builder::build(IWORKFormula &formula)
+{
+  if (m_stack->m_exprs.size() != 1)
+  {
+    ETONYEK_DEBUG_MSG(("IWORKFormula::Builder::build: found %u expressions\n", unsigned(m_stack->m_exprs.size())));
+    m_stack->m_exprs.clear();
+    return false;
+  }
+  const std::shared_ptr<Impl> impl(new Impl());
+  impl->m_formula = std::move(m_stack->m_exprs.back());
+  m_stack->m_exprs.clear();
+  formula.m_impl = impl;
+  return true;
+}
+
+IWORKFormula::IWORKFormula(const boost::optional<unsigned> &hc)
+  : m_impl(new Impl())
+  , m_hc(hc)
+{
+}
+
+bool IWORKFormula::parse(const std::string &formula, Cache *const cache)
+{
+  if (cache)
+  {
+    const auto cached = cache->m_formulas.find(formula);
+    if (cached != cache->m_formulas.end())
+    {
+      ++cache->m_hits;
+      if (!cached->second)
+        return false;
+      m_impl = cached->second;
+      return true;
+    }
+    ++cache->m_misses;
+  }
+
+  const std::shared_ptr<Impl> impl(new Impl());
+  FormulaParser parser(formula.data(), formula.data() + formula.size());
+  const bool r = parser.parse(impl->m_formula);
+  if (cache)
+    cache->m_formulas[formula] = r ? impl : std::shared_ptr<const Impl>();
+  if (!r)
+  {
+    ETONYEK_DEBUG_MSG(("IWORKFormula::parse: can not parse %s\n", formula.c_str()));
+    return false;
+  }
+  m_impl = impl;
   return true;
 }
 
@@ -849,23 +1197,47 @@ const std::string IWORKFormula::str(const boost::optional<unsigned> &hc) const
   if (!computeOffset(hc, offsetCol, offsetRow))
     offsetCol=offsetRow=0;
   Printer printer(out, offsetCol, offsetRow);
-  if (m_impl->m_tokenList.empty())
-    apply_visitor(printer, m_impl->m_formula);
-  else
-    for (auto const &f : m_impl->m_tokenList) printer(f);
+  apply_visitor(printer, m_impl->m_formula);
   return out.str();
 }
 
-void IWORKFormula::write(const boost::optional<unsigned> &hc, librevenge::RVNGPropertyListVector &formula, const IWORKTableNameMapPtr_t &tableNameMap) const
+void IWORKFormula::write(const boost::optional<unsigned> &hc, librevenge::RVNGPropertyListVector &formula, const IWORKTableNameMapPtr_t &tableNameMap, WriteCache *const cache) const
 {
   int offsetCol=0, offsetRow=0;
   if (!computeOffset(hc, offsetCol, offsetRow))
     offsetCol=offsetRow=0;
-  Collector collect(formula, tableNameMap, offsetCol, offsetRow);
-  if (m_impl->m_tokenList.empty())
+
+  std::shared_ptr<WriteCache::Template> written;
+  if (cache)
+  {
+    const auto cached = cache->m_templates.find(m_impl.get());
+    if (cached != cache->m_templates.end())
+      written = cached->second;
+  }
+  if (!written)
+  {
+    written = std::make_shared<WriteCache::Template>(m_impl);
+    Collector collect(written->m_props, written->m_refs);
     apply_visitor(collect, m_impl->m_formula);
-  else
-    for (auto const &f : m_impl->m_tokenList) collect(f);
+    if (cache)
+      cache->m_templates[m_impl.get()] = written;
+  }
+
+  auto ref = written->m_refs.begin();
+  for (unsigned long i = 0; i != written->m_props.count(); ++i)
+  {
+    if ((ref != written->m_refs.end()) && (ref->m_index == i))
+    {
+      librevenge::RVNGPropertyList props(written->m_props[i]);
+      insertReference(props, *ref, tableNameMap, offsetCol, offsetRow);
+      formula.append(props);
+      ++ref;
+    }
+    else
+    {
+      formula.append(written->m_props[i]);
+    }
+  }
 }
 
 bool IWORKFormula::computeOffset(const boost::optional<unsigned> &hc, int &offsetColumn, int &offsetRow) const
@@ -13,6 +13,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -28,14 +29,95 @@ class IWORKFormula
   struct Impl;
 
 public:
-  struct Token;
+  struct Address;
+
+  /** A cache of parsed formulas.
+    *
+    * Formulas with the same text share one parse result. The result
+    * does not depend on the host cell, so this works for relative
+    * formulas reused in many cells too.
+    */
+  class Cache
+  {
+    friend class IWORKFormula;
+
+  public:
+    Cache();
+    ~Cache();
+
+    unsigned getHits() const;
+    unsigned getMisses() const;
+
+  private:
+    std::unordered_map<std::string, std::shared_ptr<const Impl> > m_formulas; //< null for invalid formulas
+    unsigned m_hits;
+    unsigned m_misses;
+  };
+
+  /** A cache of written formulas.
+    *
+    * A written formula only depends on the host cell through the
+    * coordinates of its cell references. So every distinct formula is
+    * only written once, without the coordinates, and just these are
+    * added for each cell.
+    */
+  class WriteCache
+  {
+    friend class IWORKFormula;
+
+    struct Template;
+
+  public:
+    WriteCache();
+
+  private:
+    std::unordered_map<const Impl *, std::shared_ptr<Template> > m_templates;
+  };
+
+  /** A builder of formulas from their postfix form.
+    *
+    * It lets the binary format construct the expression tree directly,
+    * without creating the text of the formula first. Operands are pushed
+    * on a stack; operators and functions replace their arguments at the
+    * top of the stack by the result.
+    */
+  class Builder
+  {
+    struct Stack;
+
+  public:
+    Builder();
+    ~Builder();
+
+    void pushNumber(double value);
+    void pushString(const std::string &value);
+    void pushBool(bool value);
+    void pushAddress(const Address &address);
+    /// Push an empty (e.g., omitted optional) argument.
+    void pushEmpty();
+
+    bool applyPrefixOp(char op);
+    bool applyPostfixOp(char op);
+    bool applyInfixOp(const char *op);
+    bool applyFunction(const std::string &name, unsigned numArgs);
+    bool applyParentheses(unsigned numArgs);
+
+    /** Move the built formula into @c formula.
+      *
+      * This fails if the stack does not contain exactly one expression.
+      * The stack is empty afterwards.
+      */
+    bool build(IWORKFormula &formula);
+
+  private:
+    std::unique_ptr<Stack> m_stack;
+  };
 
   explicit IWORKFormula(const boost::optional<unsigned> &hc);
 
-  bool parse(const std::string &formula);
-  bool parse(const std::vector<Token> &formula);
+  bool parse(const std::string &formula, Cache *cache = nullptr);
 
-  void write(const boost::optional<unsigned> &hc, librevenge::RVNGPropertyListVector &formula, const IWORKTableNameMapPtr_t &tableNameMap) const;
+  void write(const boost::optional<unsigned> &hc, librevenge::RVNGPropertyListVector &formula, const IWORKTableNameMapPtr_t &tableNameMap, WriteCache *cache = nullptr) const;
   const std::string str(const boost::optional<unsigned> &hc) const;
 
 public:
@@ -60,55 +142,13 @@ public:
     }
     boost::optional<Coord> m_column;
     boost::optional<Coord> m_row;
-    boost::optional<std::string> m_table;
+    std::shared_ptr<const std::string> m_table; //< shared by all the references to a table
     friend std::ostream &operator<<(std::ostream &s, Address const &ad);
   };
 
-  //! small structure used by IWAParser to create formula
-  struct Token
-  {
-    enum Type
-    {
-      Cell, Double, Function, Operator, String
-    };
-    explicit Token(Type type)
-      : m_type(type)
-      , m_string()
-      , m_value(0)
-      , m_address()
-    {
-    }
-    explicit Token(double const &val)
-      : m_type(Double)
-      , m_string()
-      , m_value(val)
-      , m_address()
-    {
-    }
-    Token(std::string const &name, Type type)
-      : m_type(type)
-      , m_string(name)
-      , m_value(0)
-      , m_address()
-    {
-    }
-    explicit Token(IWORKFormula::Address const &address)
-      : m_type(Cell)
-      , m_string()
-      , m_value()
-      , m_address(address)
-    {
-    }
-    friend std::ostream &operator<<(std::ostream &s, Token const &dt);
-    Type m_type;
-    std::string m_string;
-    double m_value;
-    IWORKFormula::Address m_address;
-  };
-
 private:
   bool computeOffset(const boost::optional<unsigned> &hc, int &offsetColumn, int &offsetRow) const;
-  std::shared_ptr<Impl> m_impl;
+  std::shared_ptr<const Impl> m_impl;
   boost::optional<unsigned> m_hc;
 };
 
@@ -22,6 +22,9 @@
 #endif
 
 #include "libetonyek_utils.h"
+#include "IWORKProperties.h"
+#include "IWORKPropertyMap.h"
+#include "IWORKStyle.h"
 
 namespace libetonyek
 {
@@ -76,6 +79,9 @@ IWORKLanguageManager::LangDB::LangDB()
   : m_db()
 {
 #ifdef WITH_LIBLANGTAG
+  // load all of liblangtag's databases here, so they are not loaded
+  // lazily by concurrent parsing of tags later
+  lt_db_initialize();
   shared_ptr<lt_lang_db_t> langDB(lt_db_get_lang(), lt_lang_db_unref);
   shared_ptr<lt_iter_t> it(LT_ITER_INIT(langDB.get()), lt_iter_finish);
   lt_pointer_t key(nullptr);
@@ -91,32 +97,33 @@ IWORKLanguageManager::LangDB::LangDB()
 
 IWORKLanguageManager::IWORKLanguageManager()
   : m_tagMap()
-  , m_invalidTags()
   , m_langMap()
   , m_invalidLangs()
   , m_localeMap()
   , m_invalidLocales()
   , m_propsMap()
-  , m_langDB()
+  , m_tagStyles()
+  , m_langStyles()
 {
 }
 
+void IWORKLanguageManager::warmUp()
+{
+  getLangDB();
+}
+
 const std::string IWORKLanguageManager::addTag(const std::string &tag)
 {
 #ifdef WITH_LIBLANGTAG
-  // Check if the tag is already known
+  // Check if the tag is already known (or was rejected as invalid)
   const unordered_map<string, string>::const_iterator it = m_tagMap.find(tag);
   if (it != m_tagMap.end())
     return it->second;
-  // Check if the tag was previously rejected as invalid
-  const unordered_set<string>::const_iterator invIt = m_invalidTags.find(tag);
-  if (invIt != m_invalidTags.end())
-    return "";
 
   const shared_ptr<lt_tag_t> &langTag = parseTag(tag);
   if (!langTag)
   {
-    m_invalidTags.insert(tag);
+    m_tagMap[tag] = "";
     return "";
   }
 
@@ -209,11 +216,32 @@ const std::string IWORKLanguageManager::getLanguage(const std::string &tag) cons
 #endif
 }
 
-const IWORKLanguageManager::LangDB &IWORKLanguageManager::getLangDB() const
+const IWORKStylePtr_t &IWORKLanguageManager::getLanguageStyle(const std::string &tag)
+{
+  const unordered_map<string, IWORKStylePtr_t>::const_iterator it = m_tagStyles.find(tag);
+  if (it != m_tagStyles.end())
+    return it->second;
+
+  const string fullTag(tag.empty() ? string() : addTag(tag));
+  IWORKStylePtr_t &style = m_langStyles[fullTag];
+  if (!style)
+  {
+    IWORKPropertyMap props;
+    if (fullTag.empty())
+      props.clear<property::Language>();
+    else
+      props.put<property::Language>(fullTag);
+    style = std::make_shared<IWORKStyle>(props, boost::none, boost::none);
+    style->freeze();
+  }
+  return m_tagStyles[tag] = style;
+}
+
+const IWORKLanguageManager::LangDB &IWORKLanguageManager::getLangDB()
 {
-  if (!m_langDB)
-    m_langDB = std::make_shared<LangDB>();
-  return *m_langDB;
+  // the DB is immutable once built, so it can be shared by all threads
+  static const LangDB langDB;
+  return langDB;
 }
 
 void IWORKLanguageManager::addProperties(const std::string &tag)
@@ -10,13 +10,14 @@
 #ifndef IWORKLANGUAGEMANAGER_H_INCLUDED
 #define IWORKLANGUAGEMANAGER_H_INCLUDED
 
-#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
 #include <librevenge/librevenge.h>
 
+#include "IWORKStyle_fwd.h"
+
 namespace libetonyek
 {
 
@@ -27,28 +28,44 @@ class IWORKLanguageManager
 public:
   IWORKLanguageManager();
 
+  /** Load the data shared by all instances.
+    *
+    * This happens on first use anyway; calling it in advance moves the
+    * cost out of document parsing. It is thread-safe.
+    */
+  static void warmUp();
+
   const std::string addTag(const std::string &tag);
   const std::string addLanguage(const std::string &lang);
   const std::string addLocale(const std::string &locale);
 
   const std::string getLanguage(const std::string &tag) const;
 
+  /** Get a style setting the language given by a tag.
+    *
+    * The style is created once for every canonical form of the tag
+    * and shared. If the tag is empty or invalid, the style clears the
+    * language.
+    */
+  const IWORKStylePtr_t &getLanguageStyle(const std::string &tag);
+
   void writeProperties(const std::string &tag, librevenge::RVNGPropertyList &props) const;
 
 private:
-  const LangDB &getLangDB() const;
+  static const LangDB &getLangDB();
 
   void addProperties(const std::string &tag);
 
 private:
+  /// Canonical forms of tags; invalid tags map to an empty string.
   std::unordered_map<std::string, std::string> m_tagMap;
-  std::unordered_set<std::string> m_invalidTags;
   std::unordered_map<std::string, std::string> m_langMap;
   std::unordered_set<std::string> m_invalidLangs;
   std::unordered_map<std::string, std::string> m_localeMap;
   std::unordered_set<std::string> m_invalidLocales;
   std::unordered_map<std::string, librevenge::RVNGPropertyList> m_propsMap;
-  mutable std::shared_ptr<LangDB> m_langDB;
+  std::unordered_map<std::string, IWORKStylePtr_t> m_tagStyles;
+  std::unordered_map<std::string, IWORKStylePtr_t> m_langStyles;
 };
 
 }
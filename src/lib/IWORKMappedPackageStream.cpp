@@ -0,0 +1,482 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "IWORKMappedPackageStream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#if defined HAVE_SYS_MMAN_H && defined HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <zlib.h>
+
+namespace libetonyek
+{
+
+namespace
+{
+
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const uint32_t END_SIGNATURE = 0x06054b50;
+const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+const uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+
+const unsigned long LOCAL_HEADER_SIZE = 30;
+const unsigned long CENTRAL_HEADER_SIZE = 46;
+const unsigned long END_SIZE = 22;
+const unsigned long ZIP64_END_SIZE = 56;
+const unsigned long ZIP64_LOCATOR_SIZE = 20;
+
+const unsigned METHOD_STORED = 0;
+const unsigned METHOD_DEFLATED = 8;
+
+uint16_t getU16(const unsigned char *const p)
+{
+  return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const unsigned char *const p)
+{
+  return uint32_t(getU16(p)) | (uint32_t(getU16(p + 2)) << 16);
+}
+
+uint64_t getU64(const unsigned char *const p)
+{
+  return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+}
+
+/// Convert a 64-bit value from the package to an offset or size.
+unsigned long toLength(const uint64_t value)
+{
+  if (value > std::numeric_limits<unsigned long>::max())
+    throw GenericException();
+  return (unsigned long) value;
+}
+
+#if defined HAVE_SYS_MMAN_H && defined HAVE_MMAP
+
+/// A read-only mapping of a file.
+struct Mapping
+{
+  // -Weffc++
+  Mapping(const Mapping &other);
+  Mapping &operator=(const Mapping &other);
+
+  Mapping(void *address, std::size_t length);
+  ~Mapping();
+
+  void *const m_address;
+  const std::size_t m_length;
+};
+
+Mapping::Mapping(void *const address, const std::size_t length)
+  : m_address(address)
+  , m_length(length)
+{
+}
+
+Mapping::~Mapping()
+{
+  munmap(m_address, m_length);
+}
+
+std::shared_ptr<const void> mapFile(const char *const path, const unsigned char *&data, unsigned long &length)
+{
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    throw GenericException();
+
+  struct stat info;
+  if ((fstat(fd, &info) != 0) || (info.st_size <= 0))
+  {
+    close(fd);
+    throw GenericException();
+  }
+
+  const auto size = std::size_t(info.st_size);
+  void *const address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the file is closed
+  close(fd);
+  if (address == MAP_FAILED)
+    throw GenericException();
+
+  const std::shared_ptr<const Mapping> mapping(std::make_shared<Mapping>(address, size));
+  data = static_cast<const unsigned char *>(address);
+  length = (unsigned long) size;
+  return mapping;
+}
+
+#else
+
+std::shared_ptr<const void> mapFile(const char *const path, const unsigned char *&data, unsigned long &length)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw GenericException();
+  const std::shared_ptr<std::vector<unsigned char> > content(std::make_shared<std::vector<unsigned char> >(
+                                                               std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+  if (content->empty())
+    throw GenericException();
+
+  data = content->data();
+  length = (unsigned long) content->size();
+  return content;
+}
+
+#endif
+
+std::shared_ptr<const void> readStream(const RVNGInputStreamPtr_t &input, const unsigned char *&data, unsigned long &length)
+{
+  const unsigned long size = getLength(input);
+  if ((size == 0) || (input->seek(0, librevenge::RVNG_SEEK_SET) != 0))
+    throw GenericException();
+
+  unsigned long numBytesRead = 0;
+  const unsigned char *const bytes = input->read(size, numBytesRead);
+  if (!bytes || (numBytesRead != size))
+    throw GenericException();
+
+  const std::shared_ptr<std::vector<unsigned char> > content(std::make_shared<std::vector<unsigned char> >(bytes, bytes + size));
+  data = content->data();
+  length = size;
+  return content;
+}
+
+/// Inflate a raw deflate stream of known size.
+std::shared_ptr<std::vector<unsigned char> > inflateEntry(const unsigned char *const data, const unsigned long compressedSize, const unsigned long size)
+{
+  const std::shared_ptr<std::vector<unsigned char> > content(std::make_shared<std::vector<unsigned char> >(size));
+  if ((compressedSize > std::numeric_limits<uInt>::max()) || (size > std::numeric_limits<uInt>::max()))
+    throw GenericException();
+
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.next_in = const_cast<Bytef *>(data);
+  strm.avail_in = uInt(compressedSize);
+
+  if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+    throw GenericException();
+
+  // an empty output buffer would make the call fail, even if there is nothing to inflate
+  Bytef dummy;
+  strm.next_out = content->empty() ? &dummy : content->data();
+  strm.avail_out = content->empty() ? 1 : uInt(size);
+  const int ret = inflate(&strm, Z_FINISH);
+  const unsigned long inflated = strm.total_out;
+  (void) inflateEnd(&strm);
+
+  if ((ret != Z_STREAM_END) || (inflated != size))
+    throw GenericException();
+  return content;
+}
+
+}
+
+IWORKMappedPackageStream::Entry::Entry()
+  : m_name()
+  , m_method(METHOD_STORED)
+  , m_encrypted(false)
+  , m_offset(0)
+  , m_compressedSize(0)
+  , m_size(0)
+{
+}
+
+IWORKMappedPackageStream::IWORKMappedPackageStream(const char *const path)
+  : m_owner()
+  , m_data(nullptr)
+  , m_length(0)
+  , m_entries()
+  , m_index()
+  , m_stream()
+{
+  const unsigned char *data = nullptr;
+  unsigned long length = 0;
+  const std::shared_ptr<const void> owner(mapFile(path, data, length));
+  init(owner, data, length);
+}
+
+IWORKMappedPackageStream::IWORKMappedPackageStream(const RVNGInputStreamPtr_t &input)
+  : m_owner()
+  , m_data(nullptr)
+  , m_length(0)
+  , m_entries()
+  , m_index()
+  , m_stream()
+{
+  const unsigned char *data = nullptr;
+  unsigned long length = 0;
+  const std::shared_ptr<const void> owner(readStream(input, data, length));
+  init(owner, data, length);
+}
+
+IWORKMappedPackageStream::IWORKMappedPackageStream(const std::shared_ptr<const void> &owner, const unsigned char *const data, const unsigned long length)
+  : m_owner()
+  , m_data(nullptr)
+  , m_length(0)
+  , m_entries()
+  , m_index()
+  , m_stream()
+{
+  init(owner, data, length);
+}
+
+IWORKMappedPackageStream::~IWORKMappedPackageStream()
+{
+}
+
+bool IWORKMappedPackageStream::isZip(const unsigned char *const data, const unsigned long length)
+{
+  return data && (length >= 4) && (getU32(data) == LOCAL_HEADER_SIGNATURE);
+}
+
+bool IWORKMappedPackageStream::isStructured()
+{
+  return true;
+}
+
+unsigned IWORKMappedPackageStream::subStreamCount()
+{
+  return unsigned(m_entries.size());
+}
+
+const char *IWORKMappedPackageStream::subStreamName(const unsigned id)
+{
+  if (id >= m_entries.size())
+    return nullptr;
+  return m_entries[id].m_name.c_str();
+}
+
+bool IWORKMappedPackageStream::existsSubStream(const char *const name)
+{
+  return name && (m_index.find(name) != m_index.end());
+}
+
+librevenge::RVNGInputStream *IWORKMappedPackageStream::getSubStreamByName(const char *const name)
+{
+  if (!name)
+    return nullptr;
+  const auto it = m_index.find(name);
+  if (it == m_index.end())
+    return nullptr;
+  return open(m_entries[it->second]);
+}
+
+librevenge::RVNGInputStream *IWORKMappedPackageStream::getSubStreamById(const unsigned id)
+{
+  if (id >= m_entries.size())
+    return nullptr;
+  return open(m_entries[id]);
+}
+
+const unsigned char *IWORKMappedPackageStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+{
+  return m_stream->read(numBytes, numBytesRead);
+}
+
+int IWORKMappedPackageStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+{
+  return m_stream->seek(offset, seekType);
+}
+
+long IWORKMappedPackageStream::tell()
+{
+  return m_stream->tell();
+}
+
+bool IWORKMappedPackageStream::isEnd()
+{
+  return m_stream->isEnd();
+}
+
+void IWORKMappedPackageStream::init(const std::shared_ptr<const void> &owner, const unsigned char *const data, const unsigned long length)
+{
+  if (!isZip(data, length) || (length > std::numeric_limits<unsigned>::max()))
+    throw GenericException();
+
+  m_owner = owner;
+  m_data = data;
+  m_length = length;
+  m_stream.reset(new IWORKMemoryStream(m_owner, m_data, unsigned(m_length)));
+
+  parseDirectory();
+}
+
+void IWORKMappedPackageStream::parseDirectory()
+{
+  if (m_length < END_SIZE)
+    throw GenericException();
+
+  // find the end of central directory record, which is followed by a comment of up to 64 KiB
+  unsigned long end = m_length - END_SIZE;
+  const unsigned long first = m_length - (std::min)(m_length, END_SIZE + 0xffff);
+  while ((getU32(m_data + end) != END_SIGNATURE) || (end + END_SIZE + getU16(m_data + end + 20) > m_length))
+  {
+    if (end == first)
+      throw GenericException();
+    --end;
+  }
+
+  uint64_t count = getU16(m_data + end + 10);
+  uint64_t size = getU32(m_data + end + 12);
+  uint64_t offset = getU32(m_data + end + 16);
+
+  if ((end >= ZIP64_LOCATOR_SIZE) && (getU32(m_data + end - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR_SIGNATURE))
+  {
+    const unsigned long zip64End = toLength(getU64(m_data + end - ZIP64_LOCATOR_SIZE + 8));
+    if ((m_length < ZIP64_END_SIZE) || (zip64End > m_length - ZIP64_END_SIZE) || (getU32(m_data + zip64End) != ZIP64_END_SIGNATURE))
+      throw GenericException();
+    count = getU64(m_data + zip64End + 32);
+    size = getU64(m_data + zip64End + 40);
+    offset = getU64(m_data + zip64End + 48);
+  }
+
+  if ((offset > m_length) || (size > m_length - offset))
+    throw GenericException();
+
+  const unsigned char *pos = m_data + offset;
+  const unsigned char *const directoryEnd = pos + size;
+  m_entries.reserve(std::size_t((std::min)(count, uint64_t(size / CENTRAL_HEADER_SIZE))));
+  for (uint64_t i = 0; i != count; ++i)
+  {
+    if ((unsigned long)(directoryEnd - pos) < CENTRAL_HEADER_SIZE)
+      throw GenericException();
+    if (getU32(pos) != CENTRAL_HEADER_SIGNATURE)
+      throw GenericException();
+
+    const unsigned long nameLength = getU16(pos + 28);
+    const unsigned long extraLength = getU16(pos + 30);
+    const unsigned long commentLength = getU16(pos + 32);
+    if ((unsigned long)(directoryEnd - pos) < CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength)
+      throw GenericException();
+
+    Entry entry;
+    entry.m_encrypted = getU16(pos + 8) & 1;
+    entry.m_method = getU16(pos + 10);
+    uint64_t compressedSize = getU32(pos + 20);
+    uint64_t entrySize = getU32(pos + 24);
+    uint64_t entryOffset = getU32(pos + 42);
+    entry.m_name.assign(reinterpret_cast<const char *>(pos + CENTRAL_HEADER_SIZE), nameLength);
+
+    // the zip64 extra field contains only the values that do not fit into the header
+    const unsigned char *extra = pos + CENTRAL_HEADER_SIZE + nameLength;
+    const unsigned char *const extraEnd = extra + extraLength;
+    while (extraEnd - extra >= 4)
+    {
+      const unsigned id = getU16(extra);
+      const unsigned long fieldLength = getU16(extra + 2);
+      const unsigned char *value = extra + 4;
+      extra = value + fieldLength;
+      if (extra > extraEnd)
+        break;
+      if (id != 0x0001)
+        continue;
+      for (uint64_t *const field : {&entrySize, &compressedSize, &entryOffset})
+      {
+        if (*field != 0xffffffff)
+          continue;
+        if (extra - value < 8)
+          throw GenericException();
+        *field = getU64(value);
+        value += 8;
+      }
+    }
+
+    entry.m_compressedSize = toLength(compressedSize);
+    entry.m_size = toLength(entrySize);
+    entry.m_offset = toLength(entryOffset);
+
+    // the first entry of a name wins, as with other zip readers
+    m_index.insert(std::make_pair(entry.m_name, m_entries.size()));
+    m_entries.push_back(entry);
+
+    pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+  }
+}
+
+librevenge::RVNGInputStream *IWORKMappedPackageStream::open(const Entry &entry) const try
+{
+  if (entry.m_encrypted || (m_length < LOCAL_HEADER_SIZE) || (entry.m_offset > m_length - LOCAL_HEADER_SIZE) || (getU32(m_data + entry.m_offset) != LOCAL_HEADER_SIGNATURE))
+  {
+    ETONYEK_DEBUG_MSG(("IWORKMappedPackageStream::open: cannot open %s\n", entry.m_name.c_str()));
+    return nullptr;
+  }
+
+  // the lengths in the local header can differ from the central directory
+  const unsigned long begin = entry.m_offset + LOCAL_HEADER_SIZE + getU16(m_data + entry.m_offset + 26) + getU16(m_data + entry.m_offset + 28);
+  if ((begin > m_length) || (entry.m_compressedSize > m_length - begin))
+  {
+    ETONYEK_DEBUG_MSG(("IWORKMappedPackageStream::open: %s is truncated\n", entry.m_name.c_str()));
+    return nullptr;
+  }
+
+  std::shared_ptr<const void> owner;
+  const unsigned char *data = nullptr;
+  unsigned long length = 0;
+  switch (entry.m_method)
+  {
+  case METHOD_STORED :
+    owner = m_owner;
+    data = m_data + begin;
+    length = entry.m_compressedSize;
+    break;
+  case METHOD_DEFLATED :
+  {
+    const std::shared_ptr<std::vector<unsigned char> > content(inflateEntry(m_data + begin, entry.m_compressedSize, entry.m_size));
+    owner = content;
+    data = content->data();
+    length = (unsigned long) content->size();
+    break;
+  }
+  default :
+    ETONYEK_DEBUG_MSG(("IWORKMappedPackageStream::open: unsupported compression method %u of %s\n", entry.m_method, entry.m_name.c_str()));
+    return nullptr;
+  }
+
+  if (length > std::numeric_limits<unsigned>::max())
+    return nullptr;
+
+  // a nested package, e.g., Index.zip of Keynote 6
+  if (isZip(data, length))
+  {
+    try
+    {
+      return new IWORKMappedPackageStream(owner, data, length);
+    }
+    catch (...)
+    {
+    }
+  }
+  return new IWORKMemoryStream(owner, data, unsigned(length));
+}
+catch (...)
+{
+  ETONYEK_DEBUG_MSG(("IWORKMappedPackageStream::open: failed to inflate %s\n", entry.m_name.c_str()));
+  return nullptr;
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
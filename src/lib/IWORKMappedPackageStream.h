@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef IWORKMAPPEDPACKAGESTREAM_H_INCLUDED
+#define IWORKMAPPEDPACKAGESTREAM_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "libetonyek_utils.h"
+#include "IWORKMemoryStream.h"
+
+namespace libetonyek
+{
+
+/** A zip package held in memory.
+  *
+  * The central directory is parsed only once, when the stream is
+  * created. Stored members are then returned as views of the package
+  * data, without copying them; deflated members are inflated into
+  * memory.
+  *
+  * The members can be opened from more threads at once.
+  */
+class IWORKMappedPackageStream : public librevenge::RVNGInputStream
+{
+  // -Weffc++
+  IWORKMappedPackageStream(const IWORKMappedPackageStream &other);
+  IWORKMappedPackageStream &operator=(const IWORKMappedPackageStream &other);
+
+public:
+  /** Map the file @c path into memory.
+    *
+    * If mmap is not available, the file is read instead.
+    */
+  explicit IWORKMappedPackageStream(const char *path);
+  /** Read the whole content of @c input into memory.
+    */
+  explicit IWORKMappedPackageStream(const RVNGInputStreamPtr_t &input);
+  /** Use @c length bytes at @c data in place.
+    *
+    * @c owner keeps the bytes alive for as long as the stream exists.
+    */
+  IWORKMappedPackageStream(const std::shared_ptr<const void> &owner, const unsigned char *data, unsigned long length);
+  ~IWORKMappedPackageStream() override;
+
+  /// Check if @c data starts like a zip file.
+  static bool isZip(const unsigned char *data, unsigned long length);
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+private:
+  struct Entry
+  {
+    Entry();
+
+    std::string m_name;
+    unsigned m_method;
+    bool m_encrypted;
+    unsigned long m_offset; //< offset of the local header
+    unsigned long m_compressedSize;
+    unsigned long m_size;
+  };
+
+  void init(const std::shared_ptr<const void> &owner, const unsigned char *data, unsigned long length);
+  void parseDirectory();
+  librevenge::RVNGInputStream *open(const Entry &entry) const;
+
+private:
+  std::shared_ptr<const void> m_owner;
+  const unsigned char *m_data;
+  unsigned long m_length;
+  std::vector<Entry> m_entries;
+  std::unordered_map<std::string, std::size_t> m_index;
+  std::unique_ptr<IWORKMemoryStream> m_stream; //< the whole package
+};
+
+}
+
+#endif // IWORKMAPPEDPACKAGESTREAM_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "libetonyek_utils.h"
 
@@ -18,7 +19,10 @@ namespace libetonyek
 {
 
 IWORKMemoryStream::IWORKMemoryStream(const RVNGInputStreamPtr_t &input)
-  : m_data()
+  : m_buffer()
+  , m_vector()
+  , m_owner()
+  , m_data(nullptr)
   , m_length(0)
   , m_pos(0)
 {
@@ -35,7 +39,10 @@ IWORKMemoryStream::IWORKMemoryStream(const RVNGInputStreamPtr_t &input)
 }
 
 IWORKMemoryStream::IWORKMemoryStream(const RVNGInputStreamPtr_t &input, const unsigned length)
-  : m_data()
+  : m_buffer()
+  , m_vector()
+  , m_owner()
+  , m_data(nullptr)
   , m_length(0)
   , m_pos(0)
 {
@@ -43,7 +50,10 @@ IWORKMemoryStream::IWORKMemoryStream(const RVNGInputStreamPtr_t &input, const un
 }
 
 IWORKMemoryStream::IWORKMemoryStream(const std::vector<unsigned char> &data)
-  : m_data()
+  : m_buffer()
+  , m_vector()
+  , m_owner()
+  , m_data(nullptr)
   , m_length(long(data.size()))
   , m_pos(0)
 {
@@ -53,8 +63,25 @@ IWORKMemoryStream::IWORKMemoryStream(const std::vector<unsigned char> &data)
   assign(&data[0], (unsigned) data.size());
 }
 
+IWORKMemoryStream::IWORKMemoryStream(std::vector<unsigned char> &&data)
+  : m_buffer()
+  , m_vector(std::move(data))
+  , m_owner()
+  , m_data(nullptr)
+  , m_length(long(m_vector.size()))
+  , m_pos(0)
+{
+  if (m_vector.empty())
+    throw GenericException();
+
+  m_data = &m_vector[0];
+}
+
 IWORKMemoryStream::IWORKMemoryStream(const unsigned char *const data, const unsigned length)
-  : m_data(nullptr)
+  : m_buffer()
+  , m_vector()
+  , m_owner()
+  , m_data(nullptr)
   , m_length(long(length))
   , m_pos(0)
 {
@@ -64,6 +91,30 @@ IWORKMemoryStream::IWORKMemoryStream(const unsigned char *const data, const unsi
   assign(data, length);
 }
 
+IWORKMemoryStream::IWORKMemoryStream(std::unique_ptr<unsigned char[]> data, const unsigned length)
+  : m_buffer(std::move(data))
+  , m_vector()
+  , m_owner()
+  , m_data(nullptr)
+  , m_length(long(length))
+  , m_pos(0)
+{
+  if ((0 == length) || !m_buffer)
+    throw GenericException();
+
+  m_data = m_buffer.get();
+}
+
+IWORKMemoryStream::IWORKMemoryStream(const std::shared_ptr<const void> &owner, const unsigned char *const data, const unsigned length)
+  : m_buffer()
+  , m_vector()
+  , m_owner(owner)
+  , m_data(data)
+  , m_length(long(length))
+  , m_pos(0)
+{
+}
+
 IWORKMemoryStream::~IWORKMemoryStream()
 {
 }
@@ -107,7 +158,7 @@ const unsigned char *IWORKMemoryStream::read(unsigned long numBytes, unsigned lo
   m_pos += numBytes;
 
   numBytesRead = numBytes;
-  return m_data.get() + oldPos;
+  return m_data + oldPos;
 }
 catch (...)
 {
@@ -153,12 +204,21 @@ bool IWORKMemoryStream::isEnd()
   return m_length == m_pos;
 }
 
+std::shared_ptr<IWORKMemoryStream> IWORKMemoryStream::makeView(const std::shared_ptr<IWORKMemoryStream> &stream)
+{
+  assert(bool(stream));
+  // a view of a view can refer to the original owner directly
+  const std::shared_ptr<const void> owner(stream->m_owner ? stream->m_owner : stream);
+  return std::make_shared<IWORKMemoryStream>(owner, stream->m_data, unsigned(stream->m_length));
+}
+
 void IWORKMemoryStream::assign(const unsigned char *const data, const unsigned length)
 {
   assert(0 != length);
 
-  m_data.reset(new unsigned char[length]);
-  std::copy(data, data + length, m_data.get());
+  m_buffer.reset(new unsigned char[length]);
+  std::copy(data, data + length, m_buffer.get());
+  m_data = m_buffer.get();
 }
 
 void IWORKMemoryStream::read(const RVNGInputStreamPtr_t &input, const unsigned length)
@@ -28,7 +28,18 @@ public:
   explicit IWORKMemoryStream(const RVNGInputStreamPtr_t &input);
   IWORKMemoryStream(const RVNGInputStreamPtr_t &input, unsigned length);
   explicit IWORKMemoryStream(const std::vector<unsigned char> &data);
+  /** Take over the content of @c data without copying it.
+    */
+  explicit IWORKMemoryStream(std::vector<unsigned char> &&data);
   IWORKMemoryStream(const unsigned char *data, unsigned length);
+  /** Take over an already allocated buffer of @c length bytes.
+    */
+  IWORKMemoryStream(std::unique_ptr<unsigned char[]> data, unsigned length);
+  /** Read @c length bytes at @c data in place, without copying them.
+    *
+    * @c owner keeps the bytes alive for as long as the stream exists.
+    */
+  IWORKMemoryStream(const std::shared_ptr<const void> &owner, const unsigned char *data, unsigned length);
   ~IWORKMemoryStream() override;
 
   bool isStructured() override;
@@ -46,12 +57,22 @@ public:
   long tell() override;
   bool isEnd() override;
 
+  /** Create another stream reading the same data as @c stream.
+    *
+    * Only the position is separate, so the two streams can be used
+    * from different threads.
+    */
+  static std::shared_ptr<IWORKMemoryStream> makeView(const std::shared_ptr<IWORKMemoryStream> &stream);
+
 private:
   void assign(const unsigned char *data, unsigned length);
   void read(const RVNGInputStreamPtr_t &input, unsigned length);
 
 private:
-  std::unique_ptr<unsigned char[]> m_data;
+  std::unique_ptr<unsigned char[]> m_buffer;
+  std::vector<unsigned char> m_vector;
+  std::shared_ptr<const void> m_owner;
+  const unsigned char *m_data;
   long m_length;
   long m_pos;
 };
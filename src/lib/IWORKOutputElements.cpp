@@ -9,1178 +9,797 @@
 
 #include "IWORKOutputElements.h"
 
+#include <cassert>
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include "IWORKDocumentInterface.h"
-#include "IWORKFormula.h"
 
 namespace libetonyek
 {
 
-using std::make_shared;
-
-class IWORKOutputElement
-{
-  // disable copying
-  IWORKOutputElement(const IWORKOutputElement &);
-  IWORKOutputElement &operator=(const IWORKOutputElement &);
-
-public:
-  IWORKOutputElement() {}
-  virtual ~IWORKOutputElement() {}
-  virtual void write(IWORKDocumentInterface *iface) const = 0;
+enum IWORKOutputElements::Opcode : unsigned char
+{
+  OPCODE_CLOSE_COMMENT,
+  OPCODE_CLOSE_ENDNOTE,
+  OPCODE_CLOSE_FOOTER,
+  OPCODE_CLOSE_FOOTNOTE,
+  OPCODE_CLOSE_FRAME,
+  OPCODE_CLOSE_GROUP,
+  OPCODE_CLOSE_HEADER,
+  OPCODE_CLOSE_LINK,
+  OPCODE_CLOSE_LIST_ELEMENT,
+  OPCODE_CLOSE_ORDERED_LIST_LEVEL,
+  OPCODE_CLOSE_PARAGRAPH,
+  OPCODE_CLOSE_SECTION,
+  OPCODE_CLOSE_SPAN,
+  OPCODE_CLOSE_TABLE,
+  OPCODE_CLOSE_TABLE_CELL,
+  OPCODE_CLOSE_TABLE_ROW,
+  OPCODE_CLOSE_UNORDERED_LIST_LEVEL,
+  OPCODE_DEFINE_SHEET_NUMBERING_STYLE,
+  OPCODE_DRAW_GRAPHIC_OBJECT,
+  OPCODE_DRAW_PATH,
+  OPCODE_DRAW_POLYLINE,
+  OPCODE_END_LAYER,
+  OPCODE_END_NOTES,
+  OPCODE_END_TEXT_OBJECT,
+  OPCODE_INSERT_BINARY_OBJECT,
+  OPCODE_INSERT_COVERED_TABLE_CELL,
+  OPCODE_INSERT_FIELD,
+  OPCODE_INSERT_LINE_BREAK,
+  OPCODE_INSERT_SPACE,
+  OPCODE_INSERT_TAB,
+  OPCODE_INSERT_TEXT,
+  OPCODE_OPEN_COMMENT,
+  OPCODE_OPEN_ENDNOTE,
+  OPCODE_OPEN_FORMULA_CELL,
+  OPCODE_OPEN_FOOTER,
+  OPCODE_OPEN_FOOTNOTE,
+  OPCODE_OPEN_FRAME,
+  OPCODE_OPEN_GROUP,
+  OPCODE_OPEN_HEADER,
+  OPCODE_OPEN_LINK,
+  OPCODE_OPEN_LIST_ELEMENT,
+  OPCODE_OPEN_ORDERED_LIST_LEVEL,
+  OPCODE_OPEN_PARAGRAPH,
+  OPCODE_OPEN_SECTION,
+  OPCODE_OPEN_SPAN,
+  OPCODE_OPEN_TABLE,
+  OPCODE_OPEN_TABLE_CELL,
+  OPCODE_OPEN_TABLE_ROW,
+  OPCODE_OPEN_UNORDERED_LIST_LEVEL,
+  OPCODE_SET_STYLE,
+  OPCODE_START_LAYER,
+  OPCODE_START_NOTES,
+  OPCODE_START_TEXT_OBJECT
 };
 
 namespace
 {
 
-class CloseCommentElement : public IWORKOutputElement
-{
-public:
-  CloseCommentElement() {}
-  ~CloseCommentElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseEndnoteElement : public IWORKOutputElement
-{
-public:
-  CloseEndnoteElement() {}
-  ~CloseEndnoteElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseFooterElement : public IWORKOutputElement
-{
-public:
-  CloseFooterElement() {}
-  ~CloseFooterElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseFootnoteElement : public IWORKOutputElement
-{
-public:
-  CloseFootnoteElement() {}
-  ~CloseFootnoteElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseFrameElement : public IWORKOutputElement
-{
-public:
-  CloseFrameElement() {}
-  ~CloseFrameElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseGroupElement : public IWORKOutputElement
-{
-public:
-  CloseGroupElement() {}
-  ~CloseGroupElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseHeaderElement : public IWORKOutputElement
-{
-public:
-  CloseHeaderElement() {}
-  ~CloseHeaderElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseLinkElement : public IWORKOutputElement
-{
-public:
-  CloseLinkElement() {}
-  ~CloseLinkElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseListElementElement : public IWORKOutputElement
-{
-public:
-  CloseListElementElement() {}
-  ~CloseListElementElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseOrderedListLevelElement : public IWORKOutputElement
-{
-public:
-  CloseOrderedListLevelElement() {}
-  ~CloseOrderedListLevelElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseParagraphElement : public IWORKOutputElement
-{
-public:
-  CloseParagraphElement() {}
-  ~CloseParagraphElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseSectionElement : public IWORKOutputElement
-{
-public:
-  CloseSectionElement() {}
-  ~CloseSectionElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseSpanElement : public IWORKOutputElement
-{
-public:
-  CloseSpanElement() {}
-  ~CloseSpanElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseTableElement : public IWORKOutputElement
-{
-public:
-  CloseTableElement() {}
-  ~CloseTableElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseTableCellElement : public IWORKOutputElement
-{
-public:
-  CloseTableCellElement() {}
-  ~CloseTableCellElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseTableRowElement : public IWORKOutputElement
-{
-public:
-  CloseTableRowElement() {}
-  ~CloseTableRowElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class CloseUnorderedListLevelElement : public IWORKOutputElement
-{
-public:
-  CloseUnorderedListLevelElement() {}
-  ~CloseUnorderedListLevelElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class DefineSheetNumberingStyleElement : public IWORKOutputElement
-{
-public:
-  explicit DefineSheetNumberingStyleElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~DefineSheetNumberingStyleElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class DrawGraphicObjectElement : public IWORKOutputElement
-{
-public:
-  explicit DrawGraphicObjectElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~DrawGraphicObjectElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class DrawPathElement : public IWORKOutputElement
-{
-public:
-  explicit DrawPathElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~DrawPathElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class DrawPolylineElement : public IWORKOutputElement
-{
-public:
-  explicit DrawPolylineElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~DrawPolylineElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class EndLayerElement : public IWORKOutputElement
-{
-public:
-  EndLayerElement() {}
-  ~EndLayerElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class EndNotesElement : public IWORKOutputElement
-{
-public:
-  EndNotesElement() {}
-  ~EndNotesElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class EndTextObjectElement : public IWORKOutputElement
-{
-public:
-  EndTextObjectElement() {}
-  ~EndTextObjectElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class InsertBinaryObjectElement : public IWORKOutputElement
-{
-public:
-  explicit InsertBinaryObjectElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~InsertBinaryObjectElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class InsertCoveredTableCellElement : public IWORKOutputElement
-{
-public:
-  explicit InsertCoveredTableCellElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~InsertCoveredTableCellElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class InsertFieldElement : public IWORKOutputElement
-{
-public:
-  explicit InsertFieldElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~InsertFieldElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class InsertLineBreakElement : public IWORKOutputElement
-{
-public:
-  InsertLineBreakElement() {}
-  ~InsertLineBreakElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class InsertSpaceElement : public IWORKOutputElement
-{
-public:
-  InsertSpaceElement() {}
-  ~InsertSpaceElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class InsertTabElement : public IWORKOutputElement
-{
-public:
-  InsertTabElement() {}
-  ~InsertTabElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-};
-
-class InsertTextElement : public IWORKOutputElement
+struct Operation
 {
-public:
-  explicit InsertTextElement(const librevenge::RVNGString &text) :
-    m_text(text) {}
-  ~InsertTextElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGString m_text;
-};
+  //! index of an operation that has no data
+  static const unsigned NO_DATA = unsigned(-1);
 
-class OpenCommentElement : public IWORKOutputElement
-{
-public:
-  explicit OpenCommentElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenCommentElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
+  Operation(const IWORKOutputElements::Opcode code, const std::size_t index = NO_DATA)
+    : m_code(code)
+    , m_index(unsigned(index))
+  {
+  }
 
-class OpenEndnoteElement : public IWORKOutputElement
-{
-public:
-  explicit OpenEndnoteElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenEndnoteElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
+  IWORKOutputElements::Opcode m_code;
+  //! index into the pool of the operation's data, if it has any
+  unsigned m_index;
 };
 
-class OpenFormulaCellElement : public IWORKOutputElement
+struct FormulaCell
 {
-public:
-  OpenFormulaCellElement(const librevenge::RVNGPropertyList &propList, const IWORKFormula &formula, const boost::optional<unsigned> &formulaHC, const IWORKTableNameMapPtr_t &tableNameMap)
+  FormulaCell(const librevenge::RVNGPropertyList &propList, const IWORKFormula &formula, const boost::optional<unsigned> &formulaHC, const IWORKTableNameMapPtr_t &tableNameMap)
     : m_propList(propList)
     , m_formula(formula)
     , m_formulaHC(formulaHC)
-    , m_tableNameMap(tableNameMap) {}
-  ~OpenFormulaCellElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
+    , m_tableNameMap(tableNameMap)
+  {
+  }
+
+  const librevenge::RVNGPropertyList m_propList;
   const IWORKFormula m_formula;
   const boost::optional<unsigned> m_formulaHC;
   const IWORKTableNameMapPtr_t m_tableNameMap;
 };
 
-class OpenFooterElement : public IWORKOutputElement
-{
-public:
-  explicit OpenFooterElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenFooterElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenFootnoteElement : public IWORKOutputElement
-{
-public:
-  explicit OpenFootnoteElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenFootnoteElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenFrameElement : public IWORKOutputElement
-{
-public:
-  explicit OpenFrameElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenFrameElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenGroupElement : public IWORKOutputElement
-{
-public:
-  explicit OpenGroupElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenGroupElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenHeaderElement : public IWORKOutputElement
-{
-public:
-  explicit OpenHeaderElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenHeaderElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenLinkElement : public IWORKOutputElement
-{
-public:
-  explicit OpenLinkElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenLinkElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenListElementElement : public IWORKOutputElement
-{
-public:
-  explicit OpenListElementElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenListElementElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenOrderedListLevelElement : public IWORKOutputElement
-{
-public:
-  explicit OpenOrderedListLevelElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenOrderedListLevelElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenParagraphElement : public IWORKOutputElement
-{
-public:
-  explicit OpenParagraphElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenParagraphElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenSectionElement : public IWORKOutputElement
-{
-public:
-  explicit OpenSectionElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenSectionElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenSpanElement : public IWORKOutputElement
-{
-public:
-  explicit OpenSpanElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenSpanElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenTableElement : public IWORKOutputElement
-{
-public:
-  explicit OpenTableElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenTableElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenTableCellElement : public IWORKOutputElement
-{
-public:
-  explicit OpenTableCellElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenTableCellElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenTableRowElement : public IWORKOutputElement
-{
-public:
-  explicit OpenTableRowElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenTableRowElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class OpenUnorderedListLevelElement : public IWORKOutputElement
-{
-public:
-  explicit OpenUnorderedListLevelElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~OpenUnorderedListLevelElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class SetStyleElement : public IWORKOutputElement
-{
-public:
-  explicit SetStyleElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~SetStyleElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
-
-class StartLayerElement : public IWORKOutputElement
-{
-public:
-  explicit StartLayerElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~StartLayerElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  const librevenge::RVNGPropertyList m_propList;
-};
-
-class StartNotesElement : public IWORKOutputElement
+void writeFormulaCell(const FormulaCell &cell, IWORKDocumentInterface *const iface, IWORKFormula::WriteCache &formulaCache)
 {
-public:
-  explicit StartNotesElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~StartNotesElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  const librevenge::RVNGPropertyList m_propList;
-};
+  librevenge::RVNGPropertyList cellProps(cell.m_propList);
 
-class StartTextObjectElement : public IWORKOutputElement
-{
-public:
-  explicit StartTextObjectElement(const librevenge::RVNGPropertyList &propList) :
-    m_propList(propList) {}
-  ~StartTextObjectElement() override {}
-  void write(IWORKDocumentInterface *iface) const override;
-private:
-  librevenge::RVNGPropertyList m_propList;
-};
+  librevenge::RVNGPropertyListVector propsVector;
+  cell.m_formula.write(cell.m_formulaHC, propsVector, cell.m_tableNameMap, &formulaCache);
+  cellProps.insert("librevenge:formula", propsVector);
 
-void CloseCommentElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->closeComment();
+  iface->openTableCell(cellProps);
 }
 
-void CloseEndnoteElement::write(IWORKDocumentInterface *iface) const
+void writeElement(const IWORKOutputElements::Opcode opcode, IWORKDocumentInterface *const iface)
 {
-  if (iface)
+  switch (opcode)
+  {
+  case IWORKOutputElements::OPCODE_CLOSE_COMMENT :
+    iface->closeComment();
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_ENDNOTE :
     iface->closeEndnote();
-}
-
-void CloseFooterElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_FOOTER :
     iface->closeFooter();
-}
-
-void CloseFootnoteElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_FOOTNOTE :
     iface->closeFootnote();
-}
-
-void CloseFrameElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_FRAME :
     iface->closeFrame();
-}
-
-void CloseGroupElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_GROUP :
     iface->closeGroup();
-}
-
-void CloseHeaderElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_HEADER :
     iface->closeHeader();
-}
-
-void CloseLinkElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_LINK :
     iface->closeLink();
-}
-
-void CloseListElementElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_LIST_ELEMENT :
     iface->closeListElement();
-}
-
-void CloseOrderedListLevelElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_ORDERED_LIST_LEVEL :
     iface->closeOrderedListLevel();
-}
-
-void CloseParagraphElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_PARAGRAPH :
     iface->closeParagraph();
-}
-
-void CloseSectionElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_SECTION :
     iface->closeSection();
-}
-
-void CloseSpanElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_SPAN :
     iface->closeSpan();
-}
-
-void CloseTableElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_TABLE :
     iface->closeTable();
-}
-
-void CloseTableCellElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_TABLE_CELL :
     iface->closeTableCell();
-}
-
-void CloseTableRowElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_TABLE_ROW :
     iface->closeTableRow();
-}
-
-void CloseUnorderedListLevelElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_CLOSE_UNORDERED_LIST_LEVEL :
     iface->closeUnorderedListLevel();
-}
-
-void DefineSheetNumberingStyleElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->defineSheetNumberingStyle(m_propList);
-}
-
-void DrawGraphicObjectElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->drawGraphicObject(m_propList);
-}
-
-void DrawPathElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->drawPath(m_propList);
-}
-
-void DrawPolylineElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->drawPolyline(m_propList);
-}
-
-void EndLayerElement::write(IWORKDocumentInterface *const iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_END_LAYER :
     iface->endLayer();
-}
-
-void EndNotesElement::write(IWORKDocumentInterface *const iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_END_NOTES :
     iface->endNotes();
-}
-
-void EndTextObjectElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_END_TEXT_OBJECT :
     iface->endTextObject();
-}
-
-void InsertBinaryObjectElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->insertBinaryObject(m_propList);
-}
-
-void InsertCoveredTableCellElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->insertCoveredTableCell(m_propList);
-}
-
-void InsertFieldElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->insertField(m_propList);
-}
-
-void InsertLineBreakElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_LINE_BREAK :
     iface->insertLineBreak();
-}
-
-void InsertSpaceElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_SPACE :
     iface->insertSpace();
-}
-
-void InsertTabElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_TAB :
     iface->insertTab();
+    break;
+  default :
+    assert(0);
+  }
 }
 
-void InsertTextElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->insertText(m_text);
-}
-
-void OpenCommentElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openComment(m_propList);
-}
-
-void OpenEndnoteElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openEndnote(m_propList);
-}
-
-void OpenFormulaCellElement::write(IWORKDocumentInterface *iface) const
-{
-  librevenge::RVNGPropertyList cellProps(m_propList);
-
-  librevenge::RVNGPropertyListVector propsVector;
-  m_formula.write(m_formulaHC, propsVector, m_tableNameMap);
-  cellProps.insert("librevenge:formula", propsVector);
-
-  if (iface)
-    iface->openTableCell(cellProps);
-}
-
-void OpenFooterElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openFooter(m_propList);
-}
-
-void OpenFootnoteElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openFootnote(m_propList);
-}
-
-void OpenFrameElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openFrame(m_propList);
-}
-
-void OpenGroupElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openGroup(m_propList);
-}
-
-void OpenHeaderElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openHeader(m_propList);
-}
-
-void OpenLinkElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openLink(m_propList);
-}
-
-void OpenListElementElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openListElement(m_propList);
-}
-
-void OpenOrderedListLevelElement::write(IWORKDocumentInterface *iface) const
+void writeElement(const IWORKOutputElements::Opcode opcode, const librevenge::RVNGPropertyList &propList, IWORKDocumentInterface *const iface)
 {
-  if (iface)
-    iface->openOrderedListLevel(m_propList);
+  switch (opcode)
+  {
+  case IWORKOutputElements::OPCODE_DEFINE_SHEET_NUMBERING_STYLE :
+    iface->defineSheetNumberingStyle(propList);
+    break;
+  case IWORKOutputElements::OPCODE_DRAW_GRAPHIC_OBJECT :
+    iface->drawGraphicObject(propList);
+    break;
+  case IWORKOutputElements::OPCODE_DRAW_PATH :
+    iface->drawPath(propList);
+    break;
+  case IWORKOutputElements::OPCODE_DRAW_POLYLINE :
+    iface->drawPolyline(propList);
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_BINARY_OBJECT :
+    iface->insertBinaryObject(propList);
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_COVERED_TABLE_CELL :
+    iface->insertCoveredTableCell(propList);
+    break;
+  case IWORKOutputElements::OPCODE_INSERT_FIELD :
+    iface->insertField(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_COMMENT :
+    iface->openComment(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_ENDNOTE :
+    iface->openEndnote(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_FOOTER :
+    iface->openFooter(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_FOOTNOTE :
+    iface->openFootnote(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_FRAME :
+    iface->openFrame(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_GROUP :
+    iface->openGroup(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_HEADER :
+    iface->openHeader(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_LINK :
+    iface->openLink(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_LIST_ELEMENT :
+    iface->openListElement(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_ORDERED_LIST_LEVEL :
+    iface->openOrderedListLevel(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_PARAGRAPH :
+    iface->openParagraph(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_SECTION :
+    iface->openSection(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_SPAN :
+    iface->openSpan(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_TABLE :
+    iface->openTable(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_TABLE_CELL :
+    iface->openTableCell(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_TABLE_ROW :
+    iface->openTableRow(propList);
+    break;
+  case IWORKOutputElements::OPCODE_OPEN_UNORDERED_LIST_LEVEL :
+    iface->openUnorderedListLevel(propList);
+    break;
+  case IWORKOutputElements::OPCODE_SET_STYLE :
+    iface->setStyle(propList);
+    break;
+  case IWORKOutputElements::OPCODE_START_LAYER :
+    iface->startLayer(propList);
+    break;
+  case IWORKOutputElements::OPCODE_START_NOTES :
+    iface->startNotes(propList);
+    break;
+  case IWORKOutputElements::OPCODE_START_TEXT_OBJECT :
+    iface->startTextObject(propList);
+    break;
+  default :
+    assert(0);
+  }
 }
 
-void OpenParagraphElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openParagraph(m_propList);
 }
 
-void OpenSectionElement::write(IWORKDocumentInterface *iface) const
+/** A chunk of recorded output elements.
+  *
+  * Every element is stored as an opcode and, if it carries any data, an
+  * index into one of the data pools. The pools are deques, so adding to
+  * them never moves the already stored data.
+  *
+  * A block is only appended to while it is owned by a single
+  * IWORKOutputElements. Once it is shared, it does not change anymore.
+  */
+struct IWORKOutputElements::Block
 {
-  if (iface)
-    iface->openSection(m_propList);
-}
+  Block();
 
-void OpenSpanElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openSpan(m_propList);
-}
+  void write(const Operation &operation, IWORKDocumentInterface *iface, IWORKFormula::WriteCache &formulaCache) const;
 
-void OpenTableElement::write(IWORKDocumentInterface *iface) const
-{
-  if (iface)
-    iface->openTable(m_propList);
-}
+  std::vector<Operation> m_operations;
+  std::deque<librevenge::RVNGPropertyList> m_propLists;
+  std::deque<librevenge::RVNGString> m_texts;
+  std::deque<FormulaCell> m_formulaCells;
+};
 
-void OpenTableCellElement::write(IWORKDocumentInterface *iface) const
+IWORKOutputElements::Block::Block()
+  : m_operations()
+  , m_propLists()
+  , m_texts()
+  , m_formulaCells()
 {
-  if (iface)
-    iface->openTableCell(m_propList);
 }
 
-void OpenTableRowElement::write(IWORKDocumentInterface *iface) const
+void IWORKOutputElements::Block::write(const Operation &operation, IWORKDocumentInterface *const iface, IWORKFormula::WriteCache &formulaCache) const
 {
-  if (iface)
-    iface->openTableRow(m_propList);
+  switch (operation.m_code)
+  {
+  case OPCODE_INSERT_TEXT :
+    iface->insertText(m_texts[operation.m_index]);
+    break;
+  case OPCODE_OPEN_FORMULA_CELL :
+    writeFormulaCell(m_formulaCells[operation.m_index], iface, formulaCache);
+    break;
+  default :
+    if (operation.m_index == Operation::NO_DATA)
+      writeElement(operation.m_code, iface);
+    else
+      writeElement(operation.m_code, m_propLists[operation.m_index], iface);
+  }
 }
 
-void OpenUnorderedListLevelElement::write(IWORKDocumentInterface *iface) const
+IWORKOutputElements::Segment::Segment(const std::shared_ptr<Block> &block, const std::size_t begin, const std::size_t end)
+  : m_block(block)
+  , m_begin(begin)
+  , m_end(end)
 {
-  if (iface)
-    iface->openUnorderedListLevel(m_propList);
 }
 
-void SetStyleElement::write(IWORKDocumentInterface *iface) const
+IWORKOutputElements::IWORKOutputElements()
+  : m_segments()
+  , m_document(nullptr)
+  , m_prologue()
+  , m_written(false)
+  , m_formulaCache()
 {
-  if (iface)
-    iface->setStyle(m_propList);
 }
 
-void StartLayerElement::write(IWORKDocumentInterface *const iface) const
+IWORKOutputElements::IWORKOutputElements(IWORKDocumentInterface *const document, const std::function<void()> &prologue)
+  : m_segments()
+  , m_document(document)
+  , m_prologue(prologue)
+  , m_written(false)
+  , m_formulaCache()
 {
-  if (iface)
-    iface->startLayer(m_propList);
+  assert(m_document);
 }
 
-void StartNotesElement::write(IWORKDocumentInterface *const iface) const
+IWORKOutputElements::IWORKOutputElements(const IWORKOutputElements &other)
+  : m_segments(other.m_segments)
+  , m_document(nullptr)
+  , m_prologue()
+  , m_written(false)
+  , m_formulaCache()
 {
-  if (iface)
-    iface->startNotes(m_propList);
 }
 
-void StartTextObjectElement::write(IWORKDocumentInterface *iface) const
+IWORKOutputElements &IWORKOutputElements::operator=(const IWORKOutputElements &other)
 {
-  if (iface)
-    iface->startTextObject(m_propList);
-}
-
+  if (this != &other)
+  {
+    m_segments = other.m_segments;
+    m_document = nullptr;
+    m_prologue = std::function<void()>();
+    m_written = false;
+    m_formulaCache.reset();
+  }
+  return *this;
 }
 
-IWORKOutputElements::IWORKOutputElements()
-  : m_elements()
+bool IWORKOutputElements::isDirect() const
 {
+  return bool(m_document);
 }
 
 void IWORKOutputElements::append(const IWORKOutputElements &elements)
 {
-  m_elements.insert(m_elements.end(), elements.m_elements.begin(), elements.m_elements.end());
+  if (m_document)
+  {
+    if (!elements.m_segments.empty())
+      elements.write(getDocument(), getFormulaCache());
+    return;
+  }
+  // elements might be this
+  const SegmentList_t segments(elements.m_segments);
+  m_segments.insert(m_segments.end(), segments.begin(), segments.end());
 }
 
 void IWORKOutputElements::addShapesInSpreadsheet(const IWORKOutputElements &elements)
 {
-  if (m_elements.empty())
+  if (m_document)
+  {
+    ETONYEK_DEBUG_MSG(("IWORKOutputElements::addShapesInSpreadsheet: the elements have already been written\n"));
+    return;
+  }
+  if (m_segments.empty())
   {
     ETONYEK_DEBUG_MSG(("IWORKOutputElements::addShapesInSpreadsheet: the elements is empty\n"));
     return;
   }
   // TODO: check that the first element is really OpenSheet
-  m_elements.insert(m_elements.begin()+1, elements.m_elements.begin(), elements.m_elements.end());
+  const Segment &first = m_segments.front();
+  SegmentList_t segments;
+  segments.reserve(m_segments.size() + elements.m_segments.size() + 1);
+  segments.push_back(Segment(first.m_block, first.m_begin, first.m_begin + 1));
+  segments.insert(segments.end(), elements.m_segments.begin(), elements.m_segments.end());
+  if (first.m_begin + 1 < first.m_end)
+    segments.push_back(Segment(first.m_block, first.m_begin + 1, first.m_end));
+  segments.insert(segments.end(), m_segments.begin() + 1, m_segments.end());
+  m_segments.swap(segments);
 }
 
 void IWORKOutputElements::write(IWORKDocumentInterface *iface) const
 {
-  ElementList_t::const_iterator iter;
-  for (iter = m_elements.begin(); iter != m_elements.end(); ++iter)
-    (*iter)->write(iface);
+  IWORKFormula::WriteCache formulaCache;
+  write(iface, formulaCache);
 }
 
 void IWORKOutputElements::clear()
 {
-  m_elements.clear();
+  m_segments.clear();
 }
 
 bool IWORKOutputElements::empty() const
 {
-  return m_elements.empty();
+  return m_segments.empty() && !m_written;
+}
+
+void IWORKOutputElements::clearFormulaCache()
+{
+  m_formulaCache.reset();
 }
 
 void IWORKOutputElements::addCloseComment()
 {
-  m_elements.push_back(make_shared<CloseCommentElement>());
+  add(OPCODE_CLOSE_COMMENT);
 }
 
 void IWORKOutputElements::addCloseEndnote()
 {
-  m_elements.push_back(make_shared<CloseEndnoteElement>());
+  add(OPCODE_CLOSE_ENDNOTE);
 }
 
 void IWORKOutputElements::addCloseFooter()
 {
-  m_elements.push_back(make_shared<CloseFooterElement>());
+  add(OPCODE_CLOSE_FOOTER);
 }
 
 void IWORKOutputElements::addCloseFootnote()
 {
-  m_elements.push_back(make_shared<CloseFootnoteElement>());
+  add(OPCODE_CLOSE_FOOTNOTE);
 }
 
 void IWORKOutputElements::addCloseFrame()
 {
-  m_elements.push_back(make_shared<CloseFrameElement>());
+  add(OPCODE_CLOSE_FRAME);
 }
 
 void IWORKOutputElements::addCloseGroup()
 {
-  m_elements.push_back(make_shared<CloseGroupElement>());
+  add(OPCODE_CLOSE_GROUP);
 }
 
 void IWORKOutputElements::addCloseHeader()
 {
-  m_elements.push_back(make_shared<CloseHeaderElement>());
+  add(OPCODE_CLOSE_HEADER);
 }
 
 void IWORKOutputElements::addCloseLink()
 {
-  m_elements.push_back(make_shared<CloseLinkElement>());
+  add(OPCODE_CLOSE_LINK);
 }
 
 void IWORKOutputElements::addCloseListElement()
 {
-  m_elements.push_back(make_shared<CloseListElementElement>());
+  add(OPCODE_CLOSE_LIST_ELEMENT);
 }
 
 void IWORKOutputElements::addCloseOrderedListLevel()
 {
-  m_elements.push_back(make_shared<CloseOrderedListLevelElement>());
+  add(OPCODE_CLOSE_ORDERED_LIST_LEVEL);
 }
 
 void IWORKOutputElements::addCloseParagraph()
 {
-  m_elements.push_back(make_shared<CloseParagraphElement>());
+  add(OPCODE_CLOSE_PARAGRAPH);
 }
 
 void IWORKOutputElements::addCloseSection()
 {
-  m_elements.push_back(make_shared<CloseSectionElement>());
+  add(OPCODE_CLOSE_SECTION);
 }
 
 void IWORKOutputElements::addCloseSpan()
 {
-  m_elements.push_back(make_shared<CloseSpanElement>());
+  add(OPCODE_CLOSE_SPAN);
 }
 
 void IWORKOutputElements::addCloseTable()
 {
-  m_elements.push_back(make_shared<CloseTableElement>());
+  add(OPCODE_CLOSE_TABLE);
 }
 
 void IWORKOutputElements::addCloseTableCell()
 {
-  m_elements.push_back(make_shared<CloseTableCellElement>());
+  add(OPCODE_CLOSE_TABLE_CELL);
 }
 
 void IWORKOutputElements::addCloseTableRow()
 {
-  m_elements.push_back(make_shared<CloseTableRowElement>());
+  add(OPCODE_CLOSE_TABLE_ROW);
 }
 
 void IWORKOutputElements::addCloseUnorderedListLevel()
 {
-  m_elements.push_back(make_shared<CloseUnorderedListLevelElement>());
+  add(OPCODE_CLOSE_UNORDERED_LIST_LEVEL);
 }
 
 void IWORKOutputElements::addDefineSheetNumberingStyle(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<DefineSheetNumberingStyleElement>(propList));
+  add(OPCODE_DEFINE_SHEET_NUMBERING_STYLE, propList);
 }
 
 void IWORKOutputElements::addDrawGraphicObject(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<DrawGraphicObjectElement>(propList));
+  add(OPCODE_DRAW_GRAPHIC_OBJECT, propList);
 }
 
 void IWORKOutputElements::addDrawPath(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<DrawPathElement>(propList));
+  add(OPCODE_DRAW_PATH, propList);
 }
 
 void IWORKOutputElements::addDrawPolyline(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<DrawPolylineElement>(propList));
+  add(OPCODE_DRAW_POLYLINE, propList);
 }
 
 void IWORKOutputElements::addEndLayer()
 {
-  m_elements.push_back(make_shared<EndLayerElement>());
+  add(OPCODE_END_LAYER);
 }
 
 void IWORKOutputElements::addEndNotes()
 {
-  m_elements.push_back(make_shared<EndNotesElement>());
+  add(OPCODE_END_NOTES);
 }
 
 void IWORKOutputElements::addEndTextObject()
 {
-  m_elements.push_back(make_shared<EndTextObjectElement>());
+  add(OPCODE_END_TEXT_OBJECT);
 }
 
 void IWORKOutputElements::addInsertBinaryObject(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<InsertBinaryObjectElement>(propList));
+  add(OPCODE_INSERT_BINARY_OBJECT, propList);
 }
 
 void IWORKOutputElements::addInsertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<InsertCoveredTableCellElement>(propList));
+  add(OPCODE_INSERT_COVERED_TABLE_CELL, propList);
 }
 
 void IWORKOutputElements::addInsertField(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<InsertFieldElement>(propList));
+  add(OPCODE_INSERT_FIELD, propList);
 }
 
 void IWORKOutputElements::addInsertLineBreak()
 {
-  m_elements.push_back(make_shared<InsertLineBreakElement>());
+  add(OPCODE_INSERT_LINE_BREAK);
 }
 
 void IWORKOutputElements::addInsertSpace()
 {
-  m_elements.push_back(make_shared<InsertSpaceElement>());
+  add(OPCODE_INSERT_SPACE);
 }
 
 void IWORKOutputElements::addInsertTab()
 {
-  m_elements.push_back(make_shared<InsertTabElement>());
+  add(OPCODE_INSERT_TAB);
 }
 
 void IWORKOutputElements::addInsertText(const librevenge::RVNGString &text)
 {
-  m_elements.push_back(make_shared<InsertTextElement>(text));
+  if (m_document)
+  {
+    getDocument()->insertText(text);
+    return;
+  }
+  Block &block = getBlock();
+  block.m_texts.push_back(text);
+  block.m_operations.push_back(Operation(OPCODE_INSERT_TEXT, block.m_texts.size() - 1));
+  ++m_segments.back().m_end;
 }
 
 void IWORKOutputElements::addOpenComment(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenCommentElement>(propList));
+  add(OPCODE_OPEN_COMMENT, propList);
 }
 
 void IWORKOutputElements::addOpenEndnote(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenEndnoteElement>(propList));
+  add(OPCODE_OPEN_ENDNOTE, propList);
 }
 
 void IWORKOutputElements::addOpenFormulaCell(const librevenge::RVNGPropertyList &propList, const IWORKFormula &formula, const boost::optional<unsigned> &formulaHC, const IWORKTableNameMapPtr_t &tableNameMap)
 {
-  m_elements.push_back(std::shared_ptr<OpenFormulaCellElement>(new OpenFormulaCellElement(propList, formula, formulaHC, tableNameMap)));
+  if (m_document)
+  {
+    writeFormulaCell(FormulaCell(propList, formula, formulaHC, tableNameMap), getDocument(), getFormulaCache());
+    return;
+  }
+  Block &block = getBlock();
+  block.m_formulaCells.push_back(FormulaCell(propList, formula, formulaHC, tableNameMap));
+  block.m_operations.push_back(Operation(OPCODE_OPEN_FORMULA_CELL, block.m_formulaCells.size() - 1));
+  ++m_segments.back().m_end;
 }
 
 void IWORKOutputElements::addOpenFooter(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenFooterElement>(propList));
+  add(OPCODE_OPEN_FOOTER, propList);
 }
 
 void IWORKOutputElements::addOpenFootnote(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenFootnoteElement>(propList));
+  add(OPCODE_OPEN_FOOTNOTE, propList);
 }
 
 void IWORKOutputElements::addOpenFrame(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenFrameElement>(propList));
+  add(OPCODE_OPEN_FRAME, propList);
 }
 
 void IWORKOutputElements::addOpenGroup(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenGroupElement>(propList));
+  add(OPCODE_OPEN_GROUP, propList);
 }
 
 void IWORKOutputElements::addOpenHeader(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenHeaderElement>(propList));
+  add(OPCODE_OPEN_HEADER, propList);
 }
 
 void IWORKOutputElements::addOpenLink(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenLinkElement>(propList));
+  add(OPCODE_OPEN_LINK, propList);
 }
 
 void IWORKOutputElements::addOpenListElement(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenListElementElement>(propList));
+  add(OPCODE_OPEN_LIST_ELEMENT, propList);
 }
 
 void IWORKOutputElements::addOpenOrderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenOrderedListLevelElement>(propList));
+  add(OPCODE_OPEN_ORDERED_LIST_LEVEL, propList);
 }
 
 void IWORKOutputElements::addOpenParagraph(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenParagraphElement>(propList));
+  add(OPCODE_OPEN_PARAGRAPH, propList);
 }
 
 void IWORKOutputElements::addOpenSection(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenSectionElement>(propList));
+  add(OPCODE_OPEN_SECTION, propList);
 }
 
 void IWORKOutputElements::addOpenSpan(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenSpanElement>(propList));
+  add(OPCODE_OPEN_SPAN, propList);
 }
 
 void IWORKOutputElements::addOpenTable(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenTableElement>(propList));
+  add(OPCODE_OPEN_TABLE, propList);
 }
 
 void IWORKOutputElements::addOpenTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenTableCellElement>(propList));
+  add(OPCODE_OPEN_TABLE_CELL, propList);
 }
 
 void IWORKOutputElements::addOpenTableRow(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenTableRowElement>(propList));
+  add(OPCODE_OPEN_TABLE_ROW, propList);
 }
 
 void IWORKOutputElements::addOpenUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<OpenUnorderedListLevelElement>(propList));
+  add(OPCODE_OPEN_UNORDERED_LIST_LEVEL, propList);
 }
 
 void IWORKOutputElements::addSetStyle(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<SetStyleElement>(propList));
+  add(OPCODE_SET_STYLE, propList);
 }
 
 void IWORKOutputElements::addStartLayer(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<StartLayerElement>(propList));
+  add(OPCODE_START_LAYER, propList);
 }
 
 void IWORKOutputElements::addStartNotes(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<StartNotesElement>(propList));
+  add(OPCODE_START_NOTES, propList);
 }
 
 void IWORKOutputElements::addStartTextObject(const librevenge::RVNGPropertyList &propList)
 {
-  m_elements.push_back(make_shared<StartTextObjectElement>(propList));
+  add(OPCODE_START_TEXT_OBJECT, propList);
+}
+
+IWORKOutputElements::Block &IWORKOutputElements::getBlock()
+{
+  if (!m_segments.empty())
+  {
+    const Segment &last = m_segments.back();
+    if ((last.m_block.use_count() == 1) && (last.m_end == last.m_block->m_operations.size()))
+      return *last.m_block;
+  }
+  m_segments.push_back(Segment(std::make_shared<Block>(), 0, 0));
+  return *m_segments.back().m_block;
+}
+
+void IWORKOutputElements::write(IWORKDocumentInterface *const iface, IWORKFormula::WriteCache &formulaCache) const
+{
+  if (!iface)
+    return;
+
+  for (const auto &segment : m_segments)
+  {
+    const Block &block = *segment.m_block;
+    for (std::size_t i = segment.m_begin; i != segment.m_end; ++i)
+      block.write(block.m_operations[i], iface, formulaCache);
+  }
+}
+
+IWORKFormula::WriteCache &IWORKOutputElements::getFormulaCache()
+{
+  if (!m_formulaCache)
+    m_formulaCache = std::make_shared<IWORKFormula::WriteCache>();
+  return *m_formulaCache;
+}
+
+IWORKDocumentInterface *IWORKOutputElements::getDocument()
+{
+  if (m_document && !m_written)
+  {
+    m_written = true;
+    if (m_prologue)
+      m_prologue();
+  }
+  return m_document;
+}
+
+void IWORKOutputElements::add(const Opcode opcode)
+{
+  if (m_document)
+  {
+    writeElement(opcode, getDocument());
+    return;
+  }
+  Block &block = getBlock();
+  block.m_operations.push_back(Operation(opcode));
+  ++m_segments.back().m_end;
+}
+
+void IWORKOutputElements::add(const Opcode opcode, const librevenge::RVNGPropertyList &propList)
+{
+  if (m_document)
+  {
+    writeElement(opcode, propList, getDocument());
+    return;
+  }
+  Block &block = getBlock();
+  block.m_propLists.push_back(propList);
+  block.m_operations.push_back(Operation(opcode, block.m_propLists.size() - 1));
+  ++m_segments.back().m_end;
 }
 
 }
@@ -10,38 +10,85 @@
 #ifndef IWORKOUTPUTELEMENTS_H_INCLUDED
 #define IWORKOUTPUTELEMENTS_H_INCLUDED
 
-#include <deque>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/optional.hpp>
 
 #include <librevenge/librevenge.h>
 
 #include "IWORKEnum.h"
+#include "IWORKFormula.h"
 #include "IWORKTypes_fwd.h"
 
 namespace libetonyek
 {
 
 class IWORKDocumentInterface;
-class IWORKFormula;
-class IWORKOutputElement;
-
 
+/** A recorded sequence of calls of IWORKDocumentInterface.
+  *
+  * The elements are kept in compact blocks, which are shared between
+  * copies. Therefore copying and appending is cheap.
+  *
+  * Alternatively, the elements can be created in direct mode, in which
+  * nothing is recorded and every added element is passed to the
+  * document immediately. That is useful for content that does not need
+  * to be reordered, e.g., the body text of a word processing document.
+  */
 class IWORKOutputElements
 {
-  typedef std::deque<std::shared_ptr<IWORKOutputElement> > ElementList_t;
+public:
+  enum Opcode : unsigned char;
+
+private:
+  struct Block;
+
+  struct Segment
+  {
+    Segment(const std::shared_ptr<Block> &block, std::size_t begin, std::size_t end);
+
+    std::shared_ptr<Block> m_block;
+    std::size_t m_begin;
+    std::size_t m_end;
+  };
+
+  typedef std::vector<Segment> SegmentList_t;
 
 public:
   IWORKOutputElements();
+  /** Create elements in direct mode.
+    *
+    * @arg[in] document the document to pass the elements to.
+    * @arg[in] prologue function that is called just before the first
+    *   element is passed to the document, if set.
+    */
+  explicit IWORKOutputElements(IWORKDocumentInterface *document, const std::function<void()> &prologue = std::function<void()>());
+  /** Create a copy of the recorded elements.
+    *
+    * A copy is never in direct mode, even if @c other is. Only the
+    * original passes elements to the document and runs the prologue.
+    */
+  IWORKOutputElements(const IWORKOutputElements &other);
+  IWORKOutputElements(IWORKOutputElements &&other) = default;
+
+  IWORKOutputElements &operator=(const IWORKOutputElements &other);
+  IWORKOutputElements &operator=(IWORKOutputElements &&other) = default;
+
+  bool isDirect() const;
 
   void append(const IWORKOutputElements &elements);
   //! add shapes data in spreadsheet. Assume that the current elements are OpenSheet(...), ...
   void addShapesInSpreadsheet(const IWORKOutputElements &elements);
   void write(IWORKDocumentInterface *iface) const;
   void clear();
+  //! In direct mode, this is true if nothing has been passed to the document yet.
   bool empty() const;
+  //! Drop the formulas cached while writing in direct mode.
+  void clearFormulaCache();
 
   void addCloseComment();
   void addCloseEndnote();
@@ -98,7 +145,28 @@ public:
   void addStartTextObject(const librevenge::RVNGPropertyList &propList);
 
 private:
-  ElementList_t m_elements;
+  /** Get a block that can be appended to.
+    *
+    * The last segment always ends at the end of the returned block.
+    */
+  Block &getBlock();
+  void write(IWORKDocumentInterface *iface, IWORKFormula::WriteCache &formulaCache) const;
+  /// Get the cache of written formulas used in direct mode.
+  IWORKFormula::WriteCache &getFormulaCache();
+  /** Get the document to pass the elements to, if in direct mode.
+    *
+    * The prologue is called if this is the first element.
+    */
+  IWORKDocumentInterface *getDocument();
+  void add(Opcode opcode);
+  void add(Opcode opcode, const librevenge::RVNGPropertyList &propList);
+
+private:
+  SegmentList_t m_segments;
+  IWORKDocumentInterface *m_document;
+  std::function<void()> m_prologue;
+  bool m_written;
+  std::shared_ptr<IWORKFormula::WriteCache> m_formulaCache;
 };
 
 }
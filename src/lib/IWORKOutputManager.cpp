@@ -9,6 +9,8 @@
 
 #include "IWORKOutputManager.h"
 
+#include "libetonyek_utils.h"
+
 namespace libetonyek
 {
 
@@ -39,6 +41,10 @@ void IWORKOutputManager::pop()
 IWORKOutputID_t IWORKOutputManager::save()
 {
   assert(!m_active.empty());
+  if (m_active.top().isDirect())
+  {
+    ETONYEK_DEBUG_MSG(("IWORKOutputManager::save: the elements have already been written\n"));
+  }
   m_saved.push_back(m_active.top());
   return IWORKOutputID_t(m_saved.size() - 1);
 }
@@ -122,9 +122,10 @@ bool IWORKParser::parse()
     }
     case XML_READER_TYPE_TEXT :
     {
-      xmlChar *const text = xmlTextReaderReadString(reader);
+      // the reader keeps the content of the current text node, so there
+      // is no need to copy it (as xmlTextReaderReadString would do)
+      const xmlChar *text = xmlTextReaderConstValue(reader);
       contextStack.top()->text(char_cast(text));
-      xmlFree(text);
       break;
     }
     default:
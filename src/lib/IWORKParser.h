@@ -29,7 +29,7 @@ class IWORKParser
 public:
   IWORKParser(const RVNGInputStreamPtr_t &input, const RVNGInputStreamPtr_t &package);
   virtual ~IWORKParser() = 0;
-  bool parse();
+  virtual bool parse();
 
   RVNGInputStreamPtr_t &getInput();
   RVNGInputStreamPtr_t getInput() const;
@@ -9,487 +9,511 @@
 
 #include "IWORKPath.h"
 
+#include <algorithm>
 #include <cassert>
-#include <deque>
+#include <cmath>
 #include <sstream>
 #include <utility>
-
-#include <boost/fusion/include/adapt_struct.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/variant.hpp>
+#include <vector>
 
 #include "libetonyek_utils.h"
 #include "IWORKTransformation.h"
 #include "IWORKTypes.h"
 
-namespace phoenix = boost::phoenix;
-
-using boost::apply_visitor;
-using boost::static_visitor;
-
 using librevenge::RVNGPropertyList;
 using librevenge::RVNGPropertyListVector;
 
-using std::string;
-
 namespace libetonyek
 {
 
-struct MoveTo
-{
-  double m_x;
-  double m_y;
-};
-
-struct LineTo
-{
-  double m_x;
-  double m_y;
-};
-
-struct CCurveTo
-{
-  double m_x1;
-  double m_y1;
-  double m_x2;
-  double m_y2;
-  double m_x;
-  double m_y;
-};
-
-struct QCurveTo
-{
-  double m_x1;
-  double m_y1;
-  double m_x;
-  double m_y;
-};
-
-struct ClosePolygon
+/// The type of an element of a path.
+enum PathVerb : unsigned char
 {
-  char m_char;
-  //operator bool() const { return true; }
+  VERB_MOVE_TO,
+  VERB_LINE_TO,
+  VERB_QCURVE_TO,
+  VERB_CCURVE_TO,
+  VERB_CLOSE
 };
 
-typedef boost::variant<MoveTo, LineTo, CCurveTo, QCurveTo, ClosePolygon> CurveElement_t;
-typedef std::deque<CurveElement_t> Curve_t;
-typedef std::deque<Curve_t> Path_t;
-
+/** The elements of a path.
+  *
+  * The path is stored as an array of element types and one array of the
+  * coordinates of all the elements, as (x, y) pairs in SVG order (i.e.,
+  * the end point comes last). Curves are not stored separately: every
+  * curve starts with a move.
+  */
 struct IWORKPath::Impl
 {
   Impl();
 
-  Path_t m_path;
+  std::vector<PathVerb> m_verbs;
+  std::vector<double> m_coords;
   bool m_closed;
 };
 
 IWORKPath::Impl::Impl()
-  : m_path()
+  : m_verbs()
+  , m_coords()
   , m_closed(false)
 {
 }
 
-}
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::MoveTo,
-  (double, m_x)
-  (double, m_y)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::LineTo,
-  (double, m_x)
-  (double, m_y)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::CCurveTo,
-  (double, m_x1)
-  (double, m_y1)
-  (double, m_x2)
-  (double, m_y2)
-  (double, m_x)
-  (double, m_y)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::QCurveTo,
-  (double, m_x1)
-  (double, m_y1)
-  (double, m_x)
-  (double, m_y)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::ClosePolygon,
-  (char, m_char)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-  libetonyek::IWORKPath::Impl,
-  (libetonyek::Path_t, m_path)
-)
-
-namespace libetonyek
-{
-
 namespace
 {
 
-namespace ascii = boost::spirit::ascii;
-namespace qi = boost::spirit::qi;
+/// The number of points of an element of a given type.
+const unsigned char VERB_POINTS[] = {1, 1, 2, 3, 0};
 
-#if defined _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 4100) // unreferenced formal parameter in boost
-#endif
-
-template<typename Iterator>
-struct PathGrammar : public qi::grammar<Iterator, IWORKPath::Impl(), ascii::space_type>
+bool isSpace(const char c)
 {
-  PathGrammar()
-    : PathGrammar::base_type(path, "path")
-    , path()
-    , curve()
-    , move()
-    , line()
-    , cCurve()
-    , qCurve()
-    , close('Z')
-  {
-    using qi::attr;
-    using qi::as;
-    using qi::double_;
-    using qi::lit;
-    using qi::omit;
-
-    move %= 'M' >> double_ >> double_;
-
-    line %= 'L' >> double_ >> double_;
+  return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+}
 
-    qCurve %= 'Q' >> double_ >> double_ >> double_ >> double_;
+/** A parser of SVG-like paths.
+  *
+  * A path is a sequence of curves, optionally followed by moves (which
+  * are dropped). A curve is a move, followed by at least one line,
+  * cubic or quadratic curve element and an optional close. Only
+  * absolute commands are supported and whitespace is allowed anywhere
+  * between commands and numbers.
+  *
+  * The elements are appended directly to the path. A failed element or
+  * curve is removed again, so the parser backtracks exactly as the
+  * Spirit grammar it replaces did.
+  */
+class PathParser
+{
+public:
+  PathParser(const char *begin, const char *end, IWORKPath::Impl &path);
 
-    cCurve %= 'C' >> double_ >> double_ >> double_ >> double_ >> double_ >> double_;
+  bool parse();
 
-    curve %= as<Curve_t>()[move >> +(line | cCurve | qCurve) >> -close];
-    path %= as<Path_t>()[+curve >> *(omit[move]) ];
+private:
+  bool parseCurve();
+  bool parseElement(char command, PathVerb verb);
+  bool parseNumbers(unsigned count);
 
-    close.name("close");
-    move.name("move");
-    line.name("line");
-    cCurve.name("cCurve");
-    qCurve.name("qCurve");
-    curve.name("curve");
-    path.name("path");
-  }
+  bool accept(char c);
+  void skipSpace();
+  void rollback(const char *pos, std::size_t verbs, std::size_t coords);
 
-  qi::rule<Iterator, IWORKPath::Impl(), ascii::space_type> path;
-  qi::rule<Iterator, Curve_t(), ascii::space_type> curve;
-  qi::rule<Iterator, MoveTo(), ascii::space_type> move;
-  qi::rule<Iterator, LineTo(), ascii::space_type> line;
-  qi::rule<Iterator, CCurveTo(), ascii::space_type> cCurve;
-  qi::rule<Iterator, QCurveTo(), ascii::space_type> qCurve;
-  qi::rule<Iterator, ClosePolygon(), ascii::space_type> close;
+private:
+  const char *m_pos;
+  const char *const m_end;
+  std::vector<PathVerb> &m_verbs;
+  std::vector<double> &m_coords;
 };
 
-#if defined _MSC_VER
-#pragma warning(pop)
-#endif
-
-}
-
-namespace
+PathParser::PathParser(const char *const begin, const char *const end, IWORKPath::Impl &path)
+  : m_pos(begin)
+  , m_end(end)
+  , m_verbs(path.m_verbs)
+  , m_coords(path.m_coords)
 {
+}
 
-struct Transformer : public static_visitor<void>
+bool PathParser::parse()
 {
-  explicit Transformer(const glm::dmat3 &tr)
-    : m_tr(tr)
+  if (!parseCurve())
+    return false;
+  while (parseCurve())
+    ;
+  // trailing moves do not make a curve
+  while (parseElement('M', VERB_MOVE_TO))
   {
+    m_verbs.pop_back();
+    m_coords.resize(m_coords.size() - 2);
   }
+  skipSpace();
+  return m_pos == m_end;
+}
 
-  template<typename T>
-  void operator()(T &element) const
+bool PathParser::parseCurve()
+{
+  const char *const start = m_pos;
+  const std::size_t verbs = m_verbs.size();
+  const std::size_t coords = m_coords.size();
+
+  if (!parseElement('M', VERB_MOVE_TO))
+    return false;
+  bool hasElement = false;
+  while (parseElement('L', VERB_LINE_TO) || parseElement('C', VERB_CCURVE_TO) || parseElement('Q', VERB_QCURVE_TO))
+    hasElement = true;
+  if (!hasElement)
   {
-    transform(element.m_x, element.m_y);
+    rollback(start, verbs, coords);
+    return false;
   }
+  parseElement('Z', VERB_CLOSE);
+  return true;
+}
 
-  void operator()(CCurveTo &element) const
+bool PathParser::parseElement(const char command, const PathVerb verb)
+{
+  const char *const start = m_pos;
+  if (!accept(command))
+    return false;
+  const std::size_t coords = m_coords.size();
+  if (!parseNumbers(2 * VERB_POINTS[verb]))
   {
-    transform(element.m_x1, element.m_y1);
-    transform(element.m_x2, element.m_y2);
-    transform(element.m_x, element.m_y);
+    rollback(start, m_verbs.size(), coords);
+    return false;
   }
+  m_verbs.push_back(verb);
+  return true;
+}
 
-  void operator()(QCurveTo &element) const
+bool PathParser::parseNumbers(const unsigned count)
+{
+  for (unsigned i = 0; i != count; ++i)
   {
-    transform(element.m_x1, element.m_y1);
-    transform(element.m_x, element.m_y);
+    skipSpace();
+    double value = 0;
+    if (!parseDouble(m_pos, m_end, value))
+      return false;
+    m_coords.push_back(value);
   }
+  return true;
+}
 
-  void operator()(ClosePolygon &) const
+bool PathParser::accept(const char c)
+{
+  skipSpace();
+  if ((m_pos != m_end) && (*m_pos == c))
   {
+    ++m_pos;
+    return true;
   }
-private:
-  void transform(double &x, double &y) const
-  {
-    glm::dvec3 vec = m_tr * glm::dvec3(x, y, 1);
+  return false;
+}
 
-    x = vec[0];
-    y = vec[1];
-  }
+void PathParser::skipSpace()
+{
+  while ((m_pos != m_end) && isSpace(*m_pos))
+    ++m_pos;
+}
 
-private:
-  const glm::dmat3 &m_tr;
-};
+void PathParser::rollback(const char *const pos, const std::size_t verbs, const std::size_t coords)
+{
+  m_pos = pos;
+  m_verbs.resize(verbs);
+  m_coords.resize(coords);
+}
 
 }
 
 namespace
 {
 
-struct Writer : public static_visitor<void>
+void writeElement(RVNGPropertyListVector &path, const PathVerb verb, const double *const coords, const double deltaX, const double deltaY)
 {
-  explicit Writer(RVNGPropertyListVector &path, double deltaX, double deltaY)
-    : m_path(path)
-    , m_deltaX(deltaX)
-    , m_deltaY(deltaY)
-  {
-  }
-
-  void operator()(const MoveTo &element) const
+  RVNGPropertyList command;
+  switch (verb)
   {
-    RVNGPropertyList command;
+  case VERB_MOVE_TO :
     command.insert("librevenge:path-action", "M");
-    command.insert("svg:x", pt2in(element.m_x+m_deltaX));
-    command.insert("svg:y", pt2in(element.m_y+m_deltaY));
-    m_path.append(command);
-  }
-
-  void operator()(const LineTo &element) const
-  {
-    RVNGPropertyList command;
+    break;
+  case VERB_LINE_TO :
     command.insert("librevenge:path-action", "L");
-    command.insert("svg:x", pt2in(element.m_x+m_deltaX));
-    command.insert("svg:y", pt2in(element.m_y+m_deltaY));
-    m_path.append(command);
-  }
-
-  void operator()(const CCurveTo &element) const
-  {
-    RVNGPropertyList command;
+    break;
+  case VERB_CCURVE_TO :
     command.insert("librevenge:path-action", "C");
-    command.insert("svg:x", pt2in(element.m_x+m_deltaX));
-    command.insert("svg:y", pt2in(element.m_y+m_deltaY));
-    command.insert("svg:x1", pt2in(element.m_x1+m_deltaX));
-    command.insert("svg:y1", pt2in(element.m_y1+m_deltaY));
-    command.insert("svg:x2", pt2in(element.m_x2+m_deltaX));
-    command.insert("svg:y2", pt2in(element.m_y2+m_deltaY));
-    m_path.append(command);
-  }
-
-  void operator()(const QCurveTo &element) const
-  {
-    RVNGPropertyList command;
+    command.insert("svg:x1", pt2in(coords[0]+deltaX));
+    command.insert("svg:y1", pt2in(coords[1]+deltaY));
+    command.insert("svg:x2", pt2in(coords[2]+deltaX));
+    command.insert("svg:y2", pt2in(coords[3]+deltaY));
+    break;
+  case VERB_QCURVE_TO :
     command.insert("librevenge:path-action", "Q");
-    command.insert("svg:x", pt2in(element.m_x+m_deltaX));
-    command.insert("svg:y", pt2in(element.m_y+m_deltaY));
-    command.insert("svg:x1", pt2in(element.m_x1+m_deltaX));
-    command.insert("svg:y1", pt2in(element.m_y1+m_deltaY));
-    m_path.append(command);
+    command.insert("svg:x1", pt2in(coords[0]+deltaX));
+    command.insert("svg:y1", pt2in(coords[1]+deltaY));
+    break;
+  case VERB_CLOSE :
+    command.insert("librevenge:path-action", "Z");
+    break;
+  default :
+    assert(0);
   }
-
-  void operator()(const ClosePolygon &) const
+  if (VERB_POINTS[verb] != 0)
   {
-    RVNGPropertyList command;
-    command.insert("librevenge:path-action", "Z");
-    m_path.append(command);
+    const double *const end = coords + 2 * (VERB_POINTS[verb] - 1);
+    command.insert("svg:x", pt2in(end[0]+deltaX));
+    command.insert("svg:y", pt2in(end[1]+deltaY));
   }
-private:
-  RVNGPropertyListVector &m_path;
-  double m_deltaX;
-  double m_deltaY;
-};
-
+  path.append(command);
 }
 
-namespace
-{
+/// Exact powers of ten used by appendNumber().
+const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
 
-struct Comparator : public static_visitor<bool>
+/** Append a number to a string, formatted as by an ostream with default settings.
+  *
+  * Numbers that are printed in fixed notation are rounded to six
+  * significant digits directly. If the rounding could be ambiguous, or
+  * the number needs the scientific notation, an ostream is used.
+  */
+void appendNumber(std::string &sink, const double value)
 {
-  explicit Comparator(double eps)
-    : m_eps(eps)
+  const double absValue = std::fabs(value);
+  if (absValue == 0)
   {
+    sink += std::signbit(value) ? "-0" : "0";
+    return;
   }
 
-  template<typename T, typename U>
-  bool operator()(const T &, const U &) const
+  // find the scale that brings the number to [1e5, 1e6)
+  int scale = 0;
+  double scaled = absValue;
+  while ((scaled < 1e5) && (scale < 9))
   {
-    return false;
+    ++scale;
+    scaled = absValue * POWERS_OF_TEN[scale];
   }
-
-  template<typename T>
-  bool operator()(const T &left, const T &right) const
+  const double fraction = scaled - std::floor(scaled);
+  if (!std::isfinite(value) || (scaled < 1e5 + 1e-6) || (scaled >= 999999.5 - 1e-6) || (std::fabs(fraction - 0.5) < 1e-6))
   {
-    return approxEqual(left, right);
+    std::ostringstream out;
+    out << value;
+    sink += out.str();
+    return;
   }
 
-private:
-  template<typename T>
-  bool approxEqual(const T &left, const T &right) const
+  // six significant digits, the last scale of them after the decimal point
+  unsigned long rounded = static_cast<unsigned long>(std::floor(scaled + 0.5));
+  int decimals = scale;
+  while ((decimals > 0) && (rounded % 10 == 0))
   {
-    using libetonyek::approxEqual;
-    return approxEqual(left.m_x, right.m_x, m_eps) && approxEqual(left.m_y, right.m_y, m_eps);
+    rounded /= 10;
+    --decimals;
   }
 
-  bool approxEqual(const QCurveTo &left, const QCurveTo &right) const
+  char digits[20];
+  int len = 0;
+  for (int i = 0; i != decimals; ++i)
   {
-    using libetonyek::approxEqual;
-    return approxEqual(left.m_x1, right.m_x1, m_eps) && approxEqual(left.m_y1, right.m_y1, m_eps)
-           && approxEqual(left.m_x, right.m_x, m_eps) && approxEqual(left.m_y, right.m_y, m_eps)
-           ;
+    digits[len++] = char('0' + rounded % 10);
+    rounded /= 10;
   }
-
-  bool approxEqual(const CCurveTo &left, const CCurveTo &right) const
+  if (decimals > 0)
+    digits[len++] = '.';
+  do
   {
-    using libetonyek::approxEqual;
-    return approxEqual(left.m_x1, right.m_x1, m_eps) && approxEqual(left.m_y1, right.m_y1, m_eps)
-           && approxEqual(left.m_x2, right.m_x2, m_eps) && approxEqual(left.m_y2, right.m_y2, m_eps)
-           && approxEqual(left.m_x, right.m_x, m_eps) && approxEqual(left.m_y, right.m_y, m_eps)
-           ;
+    digits[len++] = char('0' + rounded % 10);
+    rounded /= 10;
   }
+  while (rounded != 0);
 
-  bool approxEqual(const ClosePolygon &, const ClosePolygon &) const
+  if (value < 0)
+    sink += '-';
+  while (len > 0)
+    sink += digits[--len];
+}
+
+void appendPoints(std::string &sink, const double *const coords, const unsigned count)
+{
+  for (unsigned i = 0; i != 2 * count; ++i)
   {
-    return true;
+    sink += ' ';
+    appendNumber(sink, coords[i]);
   }
+}
 
-private:
-  const double m_eps;
-};
+void printElement(std::string &sink, const PathVerb verb, const double *const coords)
+{
+  switch (verb)
+  {
+  case VERB_MOVE_TO :
+    sink += 'M';
+    break;
+  case VERB_LINE_TO :
+    sink += 'L';
+    break;
+  case VERB_CCURVE_TO :
+    sink += 'C';
+    break;
+  case VERB_QCURVE_TO :
+    sink += 'Q';
+    break;
+  case VERB_CLOSE :
+    sink += 'Z';
+    break;
+  default :
+    assert(0);
+  }
+  appendPoints(sink, coords, VERB_POINTS[verb]);
+}
 
 }
 
+
 namespace
 {
 
-using std::ostringstream;
-
-struct SVGPrinter : public static_visitor<void>
+/** Apply an affine transformation to a sequence of points.
+  *
+  * The points are stored as x, y pairs. The arithmetic is the same as
+  * that of tr * glm::dvec3(x, y, 1), but the coefficients are read only
+  * once and the loop has no branches, so it can be vectorized.
+  */
+void transformPoints(const glm::dmat3 &tr, double *const points, const std::size_t count)
 {
-  explicit SVGPrinter(ostringstream &sink)
-    : m_sink(sink)
+  const double a = tr[0][0], b = tr[1][0], c = tr[2][0];
+  const double d = tr[0][1], e = tr[1][1], f = tr[2][1];
+  double *const end = points + 2 * count;
+  for (double *point = points; point != end; point += 2)
   {
+    const double x = point[0];
+    const double y = point[1];
+    point[0] = a * x + b * y + c;
+    point[1] = d * x + e * y + f;
   }
+}
 
-  void operator()(const MoveTo &element) const
+/// Bounds of a set of points, extended by a batch of points at a time.
+struct PointBounds
+{
+  PointBounds()
+    : m_empty(true)
   {
-    m_sink << "M " << element.m_x << ' ' << element.m_y;
+    m_min[0]=m_min[1]=m_max[0]=m_max[1]=0;
   }
 
-  void operator()(const LineTo &element) const
+  /** Extend the bounds by a sequence of points.
+    *
+    * @arg[in] points the points, stored as x, y pairs
+    * @arg[in] count the number of points
+    */
+  void add(const double *const points, const std::size_t count)
   {
-    m_sink << "L " << element.m_x << ' ' << element.m_y;
+    if (count==0)
+      return;
+    if (m_empty)
+    {
+      m_min[0]=m_max[0]=points[0];
+      m_min[1]=m_max[1]=points[1];
+      m_empty=false;
+    }
+    double minX=m_min[0], minY=m_min[1], maxX=m_max[0], maxY=m_max[1];
+    const double *const end = points + 2 * count;
+    for (const double *point = points; point != end; point += 2)
+    {
+      minX = std::min(minX, point[0]);
+      maxX = std::max(maxX, point[0]);
+      minY = std::min(minY, point[1]);
+      maxY = std::max(maxY, point[1]);
+    }
+    m_min[0]=minX;
+    m_min[1]=minY;
+    m_max[0]=maxX;
+    m_max[1]=maxY;
   }
 
-  void operator()(const CCurveTo &element) const
-  {
-    m_sink
-        << 'C'
-        << ' ' << element.m_x1 << ' ' << element.m_y1
-        << ' ' << element.m_x2 << ' ' << element.m_y2
-        << ' ' << element.m_x << ' ' << element.m_y
-        ;
-  }
+  double m_min[2], m_max[2];
+  bool m_empty;
+};
 
-  void operator()(const QCurveTo &element) const
-  {
-    m_sink
-        << 'Q'
-        << ' ' << element.m_x1 << ' ' << element.m_y1
-        << ' ' << element.m_x << ' ' << element.m_y
-        ;
-  }
+/// Number of segments a cubic curve is split into to find its bounds.
+const int CUBIC_SEGMENTS = 100;
 
-  void operator()(const ClosePolygon &) const
+/** Weights of the control points of a cubic curve at the sampled points.
+  *
+  * Each weight is computed by the same expression as when evaluating
+  * the curve directly, so the sampled points are the same too.
+  */
+struct CubicWeights
+{
+  CubicWeights()
   {
-    m_sink
-        << 'Z'
-        ;
+    for (int i=0; i<=CUBIC_SEGMENTS; ++i)
+    {
+      const double t=double(i)/CUBIC_SEGMENTS;
+      m_weights[i][0]=(1.0-t)*(1.0-t)*(1.0-t);
+      m_weights[i][1]=3.0*(1.0-t)*(1.0-t)*t;
+      m_weights[i][2]=3.0*(1.0-t)*t*t;
+      m_weights[i][3]=t*t*t;
+    }
   }
-private:
-  ostringstream &m_sink;
-};
-
-}
 
+  double m_weights[CUBIC_SEGMENTS + 1][4];
+};
 
-namespace
+const CubicWeights &getCubicWeights()
 {
+  static const CubicWeights weights;
+  return weights;
+}
 
-struct ComputeBoundingBox : public static_visitor<void>
+struct ComputeBoundingBox
 {
-  explicit ComputeBoundingBox()
-    : m_first(true)
+  ComputeBoundingBox()
+    : m_bounds()
     , m_x(0)
     , m_y(0)
   {
-    for (int i=0; i<2; ++i) m_boundX[i]=m_boundY[i]=0;
   }
 
-  void operator()(const MoveTo &element)
+  /** Add a run of move and line elements.
+    *
+    * @arg[in] coords the end points of the elements
+    * @arg[in] count the number of elements
+    */
+  void addPoints(const double *const coords, const std::size_t count)
   {
-    m_x=element.m_x;
-    m_y=element.m_y;
-    addPoint(m_x, m_y);
+    if (count==0)
+      return;
+    m_bounds.add(coords, count);
+    m_x=coords[2*count-2];
+    m_y=coords[2*count-1];
   }
 
-  void operator()(const LineTo &element)
+  void add(const PathVerb verb, const double *const coords)
   {
-    m_x=element.m_x;
-    m_y=element.m_y;
-    addPoint(m_x, m_y);
+    switch (verb)
+    {
+    case VERB_MOVE_TO :
+    case VERB_LINE_TO :
+      addPoints(coords, 1);
+      break;
+    case VERB_CCURVE_TO :
+      addCubicBezier(coords);
+      m_x=coords[4];
+      m_y=coords[5];
+      break;
+    case VERB_QCURVE_TO :
+      addQuadraticBezier(coords);
+      m_x=coords[2];
+      m_y=coords[3];
+      break;
+    case VERB_CLOSE :
+      break;
+    default :
+      assert(0);
+    }
   }
 
-  void operator()(const CCurveTo &element)
+  double getMinX() const
   {
-    getCubicBezierBBox(m_x, m_y, element.m_x1, element.m_y1, element.m_x2, element.m_y2, element.m_x, element.m_y);
-    m_x=element.m_x;
-    m_y=element.m_y;
+    return m_bounds.m_min[0];
   }
-
-  void operator()(const QCurveTo &element)
+  double getMinY() const
   {
-    getQuadraticBezierBBox(m_x, m_y, element.m_x1, element.m_y1, element.m_x, element.m_y);
-    m_x=element.m_x;
-    m_y=element.m_y;
+    return m_bounds.m_min[1];
   }
-
-  void operator()(const ClosePolygon &)
+  double getMaxX() const
   {
+    return m_bounds.m_max[0];
   }
-public:
-  double m_boundX[2], m_boundY[2];
-protected:
-  void addPoint(double x, double y)
+  double getMaxY() const
   {
-    if (m_first)
-    {
-      m_boundX[0]=m_boundX[1]=x;
-      m_boundY[0]=m_boundY[1]=y;
-      m_first=false;
-      return;
-    }
-    if (x<m_boundX[0])
-      m_boundX[0]=x;
-    else if (x>m_boundX[1])
-      m_boundX[1]=x;
-    if (y<m_boundY[0])
-      m_boundY[0]=y;
-    else if (y>m_boundY[1])
-      m_boundY[1]=y;
+    return m_bounds.m_max[1];
+  }
+
+private:
+  void addCurrentPoint()
+  {
+    const double point[2] = {m_x, m_y};
+    m_bounds.add(point, 1);
   }
 
   static double quadraticExtreme(double t, double a, double b, double c)
@@ -505,46 +529,48 @@ protected:
     return -1.0;
   }
 
-  void getQuadraticBezierBBox(double x0, double y0, double x1, double y1, double x, double y)
+  void addQuadraticBezier(const double *const coords)
   {
-    addPoint(x0,y0);
+    addCurrentPoint();
 
-    double t = quadraticDerivative(x0, x1, x);
+    double t = quadraticDerivative(m_x, coords[0], coords[2]);
     if (t>=0 && t<=1)
     {
-      double tmpx = quadraticExtreme(t, x0, x1, x);
-      if (tmpx < m_boundX[0])
-        m_boundX[0]=tmpx;
-      else if (tmpx > m_boundX[1])
-        m_boundX[1]=tmpx;
+      double tmpx = quadraticExtreme(t, m_x, coords[0], coords[2]);
+      if (tmpx < m_bounds.m_min[0])
+        m_bounds.m_min[0]=tmpx;
+      else if (tmpx > m_bounds.m_max[0])
+        m_bounds.m_max[0]=tmpx;
     }
 
-    t = quadraticDerivative(y0, y1, y);
+    t = quadraticDerivative(m_y, coords[1], coords[3]);
     if (t>=0 && t<=1)
     {
-      double tmpy = quadraticExtreme(t, y0, y1, y);
-      if (tmpy < m_boundY[0])
-        m_boundY[0]=tmpy;
-      else if (tmpy > m_boundY[1])
-        m_boundY[1]=tmpy;
+      double tmpy = quadraticExtreme(t, m_y, coords[1], coords[3]);
+      if (tmpy < m_bounds.m_min[1])
+        m_bounds.m_min[1]=tmpy;
+      else if (tmpy > m_bounds.m_max[1])
+        m_bounds.m_max[1]=tmpy;
     }
   }
 
-  static double cubicBase(double t, double a, double b, double c, double d)
+  void addCubicBezier(const double *const coords)
   {
-    return (1.0-t)*(1.0-t)*(1.0-t)*a + 3.0*(1.0-t)*(1.0-t)*t*b + 3.0*(1.0-t)*t*t*c + t*t*t*d;
-  }
+    addCurrentPoint();
 
-  void getCubicBezierBBox(double x0, double y0, double x1, double y1, double x2, double y2, double x, double y)
-  {
-    addPoint(x0,y0);
-    for (int i=0; i<=100; ++i)
+    // sample the curve into a buffer and bound all samples at once
+    const CubicWeights &weights = getCubicWeights();
+    double samples[2 * (CUBIC_SEGMENTS + 1)];
+    for (int i=0; i<=CUBIC_SEGMENTS; ++i)
     {
-      double t=double(i)/100.;
-      addPoint(cubicBase(t, x0, x1, x2, x), cubicBase(t, y0, y1, y2, y));
+      const double *const w = weights.m_weights[i];
+      samples[2*i] = w[0]*m_x + w[1]*coords[0] + w[2]*coords[2] + w[3]*coords[4];
+      samples[2*i+1] = w[0]*m_y + w[1]*coords[1] + w[2]*coords[3] + w[3]*coords[5];
     }
+    m_bounds.add(samples, CUBIC_SEGMENTS + 1);
   }
-  bool m_first;
+
+  PointBounds m_bounds;
   double m_x, m_y;
 };
 
@@ -558,11 +584,8 @@ IWORKPath::IWORKPath()
 IWORKPath::IWORKPath(const std::string &path)
   : m_impl(new Impl())
 {
-  PathGrammar<string::const_iterator> grammar;
-  string::const_iterator it = path.begin();
-  const bool r = qi::phrase_parse(it, path.end(), grammar, ascii::space, *m_impl);
-
-  if (!r || (path.end() != it))
+  PathParser parser(path.data(), path.data() + path.size(), *m_impl);
+  if (!parser.parse())
   {
     ETONYEK_DEBUG_MSG(("parsing of path '%s' failed\n", path.c_str()));
     throw InvalidException();
@@ -570,14 +593,13 @@ IWORKPath::IWORKPath(const std::string &path)
 }
 
 IWORKPath::IWORKPath(const IWORKPath &other)
-  : m_impl(new Impl(*other.m_impl))
+  : m_impl(other.m_impl)
 {
 }
 
 IWORKPath &IWORKPath::operator=(const IWORKPath &other)
 {
-  IWORKPath copy(other);
-  swap(copy);
+  m_impl = other.m_impl;
   return *this;
 }
 
@@ -586,132 +608,143 @@ void IWORKPath::swap(IWORKPath &other)
   m_impl.swap(other.m_impl);
 }
 
+IWORKPath::Impl &IWORKPath::getMutableImpl()
+{
+  if (m_impl.use_count() != 1)
+    m_impl = std::make_shared<Impl>(*m_impl);
+  return *m_impl;
+}
+
 void IWORKPath::clear()
 {
-  m_impl->m_path.clear();
+  if (m_impl.use_count() != 1)
+  {
+    m_impl = std::make_shared<Impl>();
+    return;
+  }
+  m_impl->m_verbs.clear();
+  m_impl->m_coords.clear();
   m_impl->m_closed = false;
 }
 
 bool IWORKPath::empty() const
 {
-  return m_impl->m_path.empty();
+  return m_impl->m_verbs.empty();
 }
 
 void IWORKPath::appendMoveTo(const double x, const double y)
 {
-  if (!m_impl->m_path.empty() && m_impl->m_path.back().size()<=1)
+  Impl &impl = getMutableImpl();
+  if (!impl.m_verbs.empty() && impl.m_verbs.back()==VERB_MOVE_TO)
   {
     ETONYEK_DEBUG_MSG(("IWORKPath::appendMoveTo: find a single point path\n"));
-    m_impl->m_path.pop_back();
+    impl.m_verbs.pop_back();
+    impl.m_coords.resize(impl.m_coords.size() - 2);
   }
-  MoveTo element;
-  element.m_x = x;
-  element.m_y = y;
-  m_impl->m_path.push_back(Curve_t());
-  m_impl->m_path.back().push_back(element);
-  m_impl->m_closed=false;
+  impl.m_verbs.push_back(VERB_MOVE_TO);
+  impl.m_coords.insert(impl.m_coords.end(), {x, y});
+  impl.m_closed=false;
 }
 
 void IWORKPath::appendLineTo(const double x, const double y)
 {
-  assert(!m_impl->m_closed && !m_impl->m_path.empty());
+  Impl &impl = getMutableImpl();
+  assert(!impl.m_closed && !impl.m_verbs.empty());
 
-  LineTo element;
-  element.m_x = x;
-  element.m_y = y;
-  m_impl->m_path.back().push_back(element);
+  impl.m_verbs.push_back(VERB_LINE_TO);
+  impl.m_coords.insert(impl.m_coords.end(), {x, y});
 }
 
 void IWORKPath::appendCCurveTo(const double x1, const double y1, const double x2, const double y2, const double x, const double y)
 {
-  assert(!m_impl->m_closed && !m_impl->m_path.empty());
+  Impl &impl = getMutableImpl();
+  assert(!impl.m_closed && !impl.m_verbs.empty());
 
-  CCurveTo element;
-  element.m_x1 = x1;
-  element.m_y1 = y1;
-  element.m_x2 = x2;
-  element.m_y2 = y2;
-  element.m_x = x;
-  element.m_y = y;
-  m_impl->m_path.back().push_back(element);
+  impl.m_verbs.push_back(VERB_CCURVE_TO);
+  impl.m_coords.insert(impl.m_coords.end(), {x1, y1, x2, y2, x, y});
 }
 
 void IWORKPath::appendQCurveTo(const double x1, const double y1, const double x, const double y)
 {
-  assert(!m_impl->m_closed && !m_impl->m_path.empty());
+  Impl &impl = getMutableImpl();
+  assert(!impl.m_closed && !impl.m_verbs.empty());
 
-  QCurveTo element;
-  element.m_x1 = x1;
-  element.m_y1 = y1;
-  element.m_x = x;
-  element.m_y = y;
-  m_impl->m_path.back().push_back(element);
+  impl.m_verbs.push_back(VERB_QCURVE_TO);
+  impl.m_coords.insert(impl.m_coords.end(), {x1, y1, x, y});
 }
 
 void IWORKPath::appendClose()
 {
-  assert(!m_impl->m_closed && !m_impl->m_path.empty());
-  if (m_impl->m_path.back().size()==1)
+  Impl &impl = getMutableImpl();
+  assert(!impl.m_closed && !impl.m_verbs.empty());
+  if (impl.m_verbs.back()==VERB_MOVE_TO)
   {
     ETONYEK_DEBUG_MSG(("IWORKPath::appendClose: impossible to close an path with one point\n"));
-    m_impl->m_path.pop_back();
-    m_impl->m_closed = true;
+    impl.m_verbs.pop_back();
+    impl.m_coords.resize(impl.m_coords.size() - 2);
+    impl.m_closed = true;
     return;
   }
-  m_impl->m_path.back().push_back(ClosePolygon());
+  impl.m_verbs.push_back(VERB_CLOSE);
 
-  m_impl->m_closed = true;
+  impl.m_closed = true;
 }
 
 void IWORKPath::operator*=(const glm::dmat3 &tr)
 {
-  for (auto &it : m_impl->m_path)
-  {
-    for (auto &cIt : it)
-      apply_visitor(Transformer(tr), cIt);
-  }
+  std::vector<double> &coords = getMutableImpl().m_coords;
+  transformPoints(tr, coords.data(), coords.size() / 2);
 }
 
 void IWORKPath::computeBoundingBox(double &minX, double &minY, double &maxX, double &maxY, double factor) const
 {
   ComputeBoundingBox bdCompute;
-  for (auto const &it : m_impl->m_path)
+  const std::vector<PathVerb> &verbs = m_impl->m_verbs;
+  const double *coords = m_impl->m_coords.data();
+  for (auto it = verbs.begin(); it != verbs.end();)
   {
-    for (auto const &cIt : it)
-      apply_visitor(bdCompute, cIt);
+    // the end points of consecutive moves and lines are contiguous
+    const auto runEnd = std::find_if(it, verbs.end(), [](const PathVerb verb)
+    {
+      return verb!=VERB_MOVE_TO && verb!=VERB_LINE_TO;
+    });
+    if (runEnd!=it)
+    {
+      const std::size_t count = std::size_t(runEnd - it);
+      bdCompute.addPoints(coords, count);
+      coords += 2 * count;
+      it = runEnd;
+      continue;
+    }
+    bdCompute.add(*it, coords);
+    coords += 2 * VERB_POINTS[*it];
+    ++it;
   }
-  minX=factor*bdCompute.m_boundX[0];
-  maxX=factor*bdCompute.m_boundX[1];
-  minY=factor*bdCompute.m_boundY[0];
-  maxY=factor*bdCompute.m_boundY[1];
+  minX=factor*bdCompute.getMinX();
+  maxX=factor*bdCompute.getMaxX();
+  minY=factor*bdCompute.getMinY();
+  maxY=factor*bdCompute.getMaxY();
 }
 
 bool IWORKPath::isRectangle() const
 {
-  if (m_impl->m_path.size()!=1) return false;
-  Curve_t const &curve=m_impl->m_path[0];
-  if (curve.size()!=4 && (curve.size()!=5 || !boost::get<ClosePolygon>(&curve.back())))
+  const std::vector<PathVerb> &verbs=m_impl->m_verbs;
+  if (verbs.empty() || std::count(verbs.begin() + 1, verbs.end(), VERB_MOVE_TO)!=0) return false;
+  if (verbs.size()!=4 && (verbs.size()!=5 || verbs.back()!=VERB_CLOSE))
+    return false;
+  // a move followed by three lines
+  if (verbs[1]!=VERB_LINE_TO || verbs[2]!=VERB_LINE_TO || verbs[3]!=VERB_LINE_TO)
     return false;
+  const std::vector<double> &coords=m_impl->m_coords;
   double x[5] = {0};
   double y[5] = {0};
-  int pt=0;
-  for (const auto &it : curve)
+  for (int pt=0; pt<4; ++pt)
   {
-    if (pt==0 && boost::get<MoveTo>(&it))
-    {
-      x[0]=x[4]=boost::get<MoveTo>(&it)->m_x;
-      y[0]=y[4]=boost::get<MoveTo>(&it)->m_y;
-    }
-    else if (pt && boost::get<LineTo>(&it))
-    {
-      x[pt]=boost::get<LineTo>(&it)->m_x;
-      y[pt]=boost::get<LineTo>(&it)->m_y;
-    }
-    else
-      return false;
-    if (++pt==4)
-      break;
+    x[pt]=coords[size_t(2*pt)];
+    y[pt]=coords[size_t(2*pt+1)];
   }
+  x[4]=x[0];
+  y[4]=y[0];
   int id=(x[0]<=x[1] && x[0]>=x[1]) ? 0 : 1;
   if (x[id]<x[id+1] || x[id]>x[id+1] || // check axis
       y[id+1]<y[id+2] || y[id+1]>y[id+2] ||
@@ -735,97 +768,104 @@ bool IWORKPath::isRectangle() const
 
 void IWORKPath::closePath(bool closeOnlyIsSamePoint)
 {
+  const std::vector<PathVerb> &verbs=m_impl->m_verbs;
+  const std::vector<double> &coords=m_impl->m_coords;
+  // the positions to insert the closes at, so the path is only changed
+  // (and unshared) if needed
+  std::vector<size_t> closes;
   bool lastClosed=false;
-  for (auto &curve : m_impl->m_path)
-  {
+  size_t begin=0;
+  size_t point=0;
+  while (begin<verbs.size())
+  {
+    // find the end of the curve
+    const size_t beginPoint=point;
+    size_t end=begin;
+    do
+    {
+      point+=VERB_POINTS[verbs[end]];
+      ++end;
+    }
+    while (end<verbs.size() && verbs[end]!=VERB_MOVE_TO);
+
     lastClosed=false;
-    if (curve.size()<=1) continue;
-    const CurveElement_t front=curve.front();
-    const CurveElement_t back=curve.back();
-    if (!closeOnlyIsSamePoint)
+    if (end-begin>1)
     {
-      if (!boost::get<ClosePolygon>(&back) && (curve.size()>1 || !boost::get<LineTo>(&back)))
+      bool close=false;
+      if (!closeOnlyIsSamePoint)
+        close=verbs[end-1]!=VERB_CLOSE;
+      else if (verbs[end-1]==VERB_CLOSE)
+        break;
+      else
+      {
+        // the end point of the last element
+        const double *const origin=&coords[2*beginPoint];
+        const double *const dest=&coords[2*(point-1)];
+        close=origin[0]<=dest[0] && origin[0]>=dest[0] &&
+              origin[1]<=dest[1] && origin[1]>=dest[1];
+      }
+      if (close)
       {
-        curve.push_back(ClosePolygon());
+        closes.push_back(end);
         lastClosed=true;
       }
-      continue;
-    }
-    if (!boost::get<MoveTo>(&front)) return;
-    double origin[2]= {boost::get<MoveTo>(&front)->m_x,boost::get<MoveTo>(&front)->m_y};
-    double dest[2];
-    if (boost::get<LineTo>(&back))
-    {
-      dest[0]=boost::get<LineTo>(&back)->m_x;
-      dest[1]=boost::get<LineTo>(&back)->m_y;
-    }
-    else if (boost::get<CCurveTo>(&back))
-    {
-      dest[0]=boost::get<CCurveTo>(&back)->m_x;
-      dest[1]=boost::get<CCurveTo>(&back)->m_y;
-    }
-    else if (boost::get<QCurveTo>(&back))
-    {
-      dest[0]=boost::get<QCurveTo>(&back)->m_x;
-      dest[1]=boost::get<QCurveTo>(&back)->m_y;
-    }
-    else
-      return;
-    if (origin[0]<=dest[0] && origin[0]>=dest[0] &&
-        origin[1]<=dest[1] && origin[1]>=dest[1])
-    {
-      curve.push_back(ClosePolygon());
-      lastClosed=true;
     }
+    begin=end;
   }
+  if (closes.empty())
+    return;
+
+  Impl &impl = getMutableImpl();
+  for (auto it = closes.rbegin(); it != closes.rend(); ++it)
+    impl.m_verbs.insert(impl.m_verbs.begin()+std::ptrdiff_t(*it), VERB_CLOSE);
   if (lastClosed)
-    m_impl->m_closed=true;
+    impl.m_closed=true;
 }
 
 const std::string IWORKPath::str() const
 {
-  ostringstream sink;
+  std::string sink;
+  // most numbers take a few characters
+  sink.reserve(2 * m_impl->m_verbs.size() + 6 * m_impl->m_coords.size());
 
   bool first=true;
-  for (Path_t::const_iterator it = m_impl->m_path.begin(); it != m_impl->m_path.end(); ++it)
+  const double *coords = m_impl->m_coords.data();
+  for (const auto verb : m_impl->m_verbs)
   {
-    for (const auto &cIt : *it)
-    {
-      if (!first)
-        sink << ' ';
-      else
-        first=false;
-      apply_visitor(SVGPrinter(sink), cIt);
-    }
+    if (!first)
+      sink += ' ';
+    else
+      first=false;
+    printElement(sink, verb, coords);
+    coords += 2 * VERB_POINTS[verb];
   }
 
-  return sink.str();
+  return sink;
 }
 
 void IWORKPath::write(librevenge::RVNGPropertyListVector &vec, double deltaX, double deltaY) const
 {
-  for (Path_t::const_iterator it = m_impl->m_path.begin(); it != m_impl->m_path.end(); ++it)
+  const double *coords = m_impl->m_coords.data();
+  for (const auto verb : m_impl->m_verbs)
   {
-    for (const auto &cIt : *it)
-      apply_visitor(Writer(vec, deltaX, deltaY), cIt);
+    writeElement(vec, verb, coords, deltaX, deltaY);
+    coords += 2 * VERB_POINTS[verb];
   }
 }
 
 bool approxEqual(const IWORKPath &left, const IWORKPath &right, const double eps)
 {
   if ((left.m_impl->m_closed != right.m_impl->m_closed)
-      || (left.m_impl->m_path.size() != right.m_impl->m_path.size()))
+      || (left.m_impl->m_verbs != right.m_impl->m_verbs))
     return false;
-  for (Path_t::const_iterator lit = left.m_impl->m_path.begin(), rit = right.m_impl->m_path.begin();
-       lit != left.m_impl->m_path.end();
-       ++lit, ++rit)
+  // the same elements have the same number of coordinates
+  const std::vector<double> &leftCoords = left.m_impl->m_coords;
+  const std::vector<double> &rightCoords = right.m_impl->m_coords;
+  assert(leftCoords.size() == rightCoords.size());
+  for (size_t i = 0; i != leftCoords.size(); ++i)
   {
-    if (lit->size()!=rit->size()) return false;
-    for (auto cLit = lit->begin(), cRit = rit->begin(); cLit != lit->end(); ++cLit, ++cRit)
-    {
-      if (!apply_visitor(Comparator(eps), *cLit, *cRit))
-        return false;
-    }
+    if (!approxEqual(leftCoords[i], rightCoords[i], eps))
+      return false;
   }
   return true;
 }
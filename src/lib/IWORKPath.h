@@ -68,6 +68,13 @@ public:
   /** Create librevenge representation of this path.
     */
   void write(librevenge::RVNGPropertyListVector &vec, double deltaX=0, double deltaY=0) const;
+private:
+  /** Get the elements for modification.
+    *
+    * Copies of a path share the elements until one of them is changed.
+    */
+  Impl &getMutableImpl();
+
 private:
   std::shared_ptr<Impl> m_impl;
 };
@@ -0,0 +1,51 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "IWORKPropertyInfo.h"
+
+#include <cassert>
+#include <vector>
+
+namespace libetonyek
+{
+
+namespace
+{
+
+/** Get the names of the registered properties, indexed by id.
+  *
+  * This is a function-local static, so it is safe to use while the
+  * property ids are being initialized.
+  */
+std::vector<const char *> &getNames()
+{
+  // id 0 is not used
+  static std::vector<const char *> names(1, "");
+  return names;
+}
+
+}
+
+IWORKPropertyID_t registerProperty(const char *const name)
+{
+  std::vector<const char *> &names = getNames();
+  names.push_back(name);
+  return IWORKPropertyID_t(names.size() - 1);
+}
+
+const char *getPropertyName(const IWORKPropertyID_t id)
+{
+  const std::vector<const char *> &names = getNames();
+  assert(id < names.size());
+  return (id < names.size()) ? names[id] : "";
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -15,7 +15,27 @@
 namespace libetonyek
 {
 
-typedef std::string IWORKPropertyID_t;
+/** Id of a property.
+  *
+  * The ids are dense, starting from 1, so they can be used as indices.
+  * 0 is never used as an id.
+  */
+typedef unsigned IWORKPropertyID_t;
+
+/** Register a new property.
+  *
+  * This is used by IWORK_IMPLEMENT_PROPERTY to assign the property id
+  * when the id is initialized.
+  *
+  * @arg[in] name the name of the property, which is only kept for
+  *   debugging.
+  * @returns a new property id
+  */
+IWORKPropertyID_t registerProperty(const char *name);
+
+/** Get the name of a registered property, for debugging.
+  */
+const char *getPropertyName(IWORKPropertyID_t id);
 
 template<typename Name>
 struct IWORKPropertyInfo
@@ -37,7 +57,7 @@ struct IWORKPropertyInfo<property::name> \
 }
 
 #define IWORK_IMPLEMENT_PROPERTY(name) \
-const IWORKPropertyID_t IWORKPropertyInfo<property::name>::id = #name
+const IWORKPropertyID_t IWORKPropertyInfo<property::name>::id = registerProperty(#name)
 
 }
 
@@ -9,24 +9,78 @@
 
 #include "IWORKPropertyMap.h"
 
+#include <algorithm>
+#include <cassert>
+
 namespace libetonyek
 {
 
+namespace
+{
+
+struct EntryIdLess
+{
+  template<typename Entry>
+  bool operator()(const Entry &entry, const IWORKPropertyID_t id) const
+  {
+    return entry.first < id;
+  }
+};
+
+template<typename Map>
+typename Map::const_iterator findEntry(const Map &map, const IWORKPropertyID_t id)
+{
+  const typename Map::const_iterator it = std::lower_bound(map.begin(), map.end(), id, EntryIdLess());
+  return ((map.end() != it) && (it->first == id)) ? it : map.end();
+}
+
+/** Add entries of @c parent that are not overridden in @c map.
+  */
+template<typename Map>
+void mergeParent(Map &map, const Map &parent)
+{
+  Map merged;
+  merged.reserve(map.size() + parent.size());
+  typename Map::const_iterator it = map.begin();
+  const typename Map::const_iterator end = map.end();
+  typename Map::const_iterator parentIt = parent.begin();
+  while ((end != it) && (parent.end() != parentIt))
+  {
+    if (it->first < parentIt->first)
+      merged.push_back(*it++);
+    else if (parentIt->first < it->first)
+      merged.push_back(*parentIt++);
+    else
+    {
+      merged.push_back(*it++);
+      ++parentIt;
+    }
+  }
+  merged.insert(merged.end(), it, end);
+  merged.insert(merged.end(), parentIt, parent.end());
+  map.swap(merged);
+}
+
+}
+
 IWORKPropertyMap::IWORKPropertyMap()
   : m_map()
   , m_parent(nullptr)
+  , m_frozen()
 {
 }
 
 IWORKPropertyMap::IWORKPropertyMap(const IWORKPropertyMap *const parent)
   : m_map()
   , m_parent(parent)
+  , m_frozen()
 {
 }
 
 IWORKPropertyMap::IWORKPropertyMap(const IWORKPropertyMap &other)
   : m_map(other.m_map)
   , m_parent(other.m_parent)
+  , m_frozen(other.m_frozen)
 {
 }
 
@@ -42,11 +96,61 @@ void IWORKPropertyMap::swap(IWORKPropertyMap &other)
   using std::swap;
   swap(m_map, other.m_map);
   swap(m_parent, other.m_parent);
+  swap(m_frozen, other.m_frozen);
 }
 
 void IWORKPropertyMap::setParent(const IWORKPropertyMap *const parent)
 {
   m_parent = parent;
+  m_frozen.reset();
+}
+
+void IWORKPropertyMap::freeze()
+{
+  const std::shared_ptr<Map_t> frozen = std::make_shared<Map_t>(m_map);
+  for (const IWORKPropertyMap *map = m_parent; map; map = map->m_parent)
+  {
+    if (map->m_frozen)
+    {
+      mergeParent(*frozen, *map->m_frozen);
+      break;
+    }
+    mergeParent(*frozen, map->m_map);
+  }
+  m_frozen = frozen;
+}
+
+const IWORKPropertyValue *IWORKPropertyMap::find(const IWORKPropertyID_t id, const bool lookInParent) const
+{
+  assert(id != 0);
+
+  for (const IWORKPropertyMap *map = this; map; map = map->m_parent)
+  {
+    if (lookInParent && map->m_frozen)
+    {
+      const Map_t::const_iterator it = findEntry(*map->m_frozen, id);
+      return (map->m_frozen->end() != it) ? &it->second : nullptr;
+    }
+
+    const Map_t::const_iterator it = findEntry(map->m_map, id);
+    if (map->m_map.end() != it)
+      return &it->second;
+
+    if (!lookInParent)
+      break;
+  }
+  return nullptr;
+}
+
+IWORKPropertyValue &IWORKPropertyMap::getEntry(const IWORKPropertyID_t id)
+{
+  assert(id != 0);
+
+  m_frozen.reset();
+  Map_t::iterator it = std::lower_bound(m_map.begin(), m_map.end(), id, EntryIdLess());
+  if ((m_map.end() == it) || (it->first != id))
+    it = m_map.insert(it, Map_t::value_type(id, IWORKPropertyValue()));
+  return it->second;
 }
 
 }
@@ -10,11 +10,12 @@
 #ifndef IWORKPROPERTYMAP_H_INCLUDED
 #define IWORKPROPERTYMAP_H_INCLUDED
 
-#include <unordered_map>
-
-#include <boost/any.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "IWORKPropertyInfo.h"
+#include "IWORKPropertyValue.h"
 
 namespace libetonyek
 {
@@ -27,7 +28,12 @@ public:
   class NotFoundException {};
 
 private:
-  typedef std::unordered_map<IWORKPropertyID_t, boost::any> Map_t;
+  /** The entries, sorted by property id.
+    *
+    * A map usually only contains a few properties, so a sorted vector
+    * is both smaller and faster to search than a hash map.
+    */
+  typedef std::vector<std::pair<IWORKPropertyID_t, IWORKPropertyValue> > Map_t;
 
 public:
   /** Construct an empty map.
@@ -65,6 +71,15 @@ public:
     */
   void setParent(const IWORKPropertyMap *parent);
 
+  /** Take a snapshot of the content of this map and all its parents.
+    *
+    * Lookups that search the parents then only need to look into the
+    * snapshot. Changing this map drops the snapshot. Changes of the
+    * parents are not reflected in it, so this should only be done when
+    * all the parents are complete.
+    */
+  void freeze();
+
   /** Check for the presence of a property.
     *
     * If the property is not found in this map and @c lookInParent is @c
@@ -77,27 +92,15 @@ public:
   template<class Property>
   bool has(bool lookInParent = false) const
   {
-    const auto it = m_map.find(IWORKPropertyInfo<Property>::id);
-    if (m_map.end() != it)
-      return !it->second.empty();
-
-    if (lookInParent && m_parent)
-      return m_parent->has<Property>(lookInParent);
-
-    return false;
+    const IWORKPropertyValue *const value = find(IWORKPropertyInfo<Property>::id, lookInParent);
+    return value && !value->empty();
   }
 
   template<class Property>
   bool clears(bool lookInParent = false) const
   {
-    const auto it = m_map.find(IWORKPropertyInfo<Property>::id);
-    if (m_map.end() != it)
-      return it->second.empty();
-
-    if (lookInParent && m_parent)
-      return m_parent->clears<Property>(lookInParent);
-
-    return false;
+    const IWORKPropertyValue *const value = find(IWORKPropertyInfo<Property>::id, lookInParent);
+    return value && value->empty();
   }
 
   /** Retrieve the value of a property.
@@ -112,18 +115,10 @@ public:
   template<class Property>
   const typename IWORKPropertyInfo<Property>::ValueType &get(bool lookInParent = false) const
   {
-    const auto it = m_map.find(IWORKPropertyInfo<Property>::id);
-    if (m_map.end() != it)
-    {
-      if (!it->second.empty())
-        return boost::any_cast<const typename IWORKPropertyInfo<Property>::ValueType &>(it->second);
-    }
-    else if (lookInParent && m_parent)
-    {
-      return m_parent->get<Property>(lookInParent);
-    }
-
-    throw NotFoundException();
+    const IWORKPropertyValue *const value = find(IWORKPropertyInfo<Property>::id, lookInParent);
+    if (!value || value->empty())
+      throw NotFoundException();
+    return value->get<typename IWORKPropertyInfo<Property>::ValueType>();
   }
 
   /** Insert a new value for key @c key.
@@ -133,7 +128,7 @@ public:
   template<class Property>
   void put(const typename IWORKPropertyInfo<Property>::ValueType &value)
   {
-    m_map[IWORKPropertyInfo<Property>::id] = value;
+    getEntry(IWORKPropertyInfo<Property>::id) = IWORKPropertyValue(value);
   }
 
   /** Clear property.
@@ -144,12 +139,29 @@ public:
   template<class Property>
   void clear()
   {
-    m_map[IWORKPropertyInfo<Property>::id] = boost::any();
+    getEntry(IWORKPropertyInfo<Property>::id) = IWORKPropertyValue();
   }
 
+private:
+  /** Find the entry for a property.
+    *
+    * @returns the entry or @c nullptr if there is none. An empty entry
+    * means the property is cleared.
+    */
+  const IWORKPropertyValue *find(IWORKPropertyID_t id, bool lookInParent) const;
+
+  /** Get the entry for a property for modification.
+    *
+    * The entry is created if it does not exist yet. The snapshot is
+    * dropped.
+    */
+  IWORKPropertyValue &getEntry(IWORKPropertyID_t id);
+
 private:
   Map_t m_map;
   const IWORKPropertyMap *m_parent;
+  /// the content of this map and its parents, if frozen
+  std::shared_ptr<const Map_t> m_frozen;
 };
 
 }
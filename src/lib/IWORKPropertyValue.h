@@ -0,0 +1,203 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef IWORKPROPERTYVALUE_H_INCLUDED
+#define IWORKPROPERTYVALUE_H_INCLUDED
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace libetonyek
+{
+
+/** A value of a property.
+  *
+  * The type of the value is given by the property, so it is not checked
+  * at run time (except by an assertion).
+  *
+  * Values that fit into the inline storage are kept there. Larger
+  * values are allocated and shared between copies. A value is never
+  * changed once it has been stored, so the sharing is safe.
+  *
+  * A default-constructed value is empty, which marks a cleared property.
+  */
+class IWORKPropertyValue
+{
+  typedef std::aligned_storage<32, alignof(double)>::type Storage_t;
+
+  /// Type-specific operations; the address also identifies the type.
+  struct Ops
+  {
+    bool m_trivial;
+    void (*m_copy)(const Storage_t &source, Storage_t &target);
+    void (*m_destroy)(Storage_t &storage);
+  };
+
+  template<typename T>
+  struct IsInline
+  {
+    static const bool value = (sizeof(T) <= sizeof(Storage_t)) && (alignof(Storage_t) % alignof(T) == 0);
+  };
+
+  template<typename T, bool isInline = IsInline<T>::value>
+  struct Impl;
+
+  template<typename T>
+  struct Impl<T, true>
+  {
+    static void construct(const T &value, Storage_t &storage)
+    {
+      new(&storage) T(value);
+    }
+
+    static const T &get(const Storage_t &storage)
+    {
+      return *reinterpret_cast<const T *>(&storage);
+    }
+
+    static void copy(const Storage_t &source, Storage_t &target)
+    {
+      new(&target) T(get(source));
+    }
+
+    static void destroy(Storage_t &storage)
+    {
+      reinterpret_cast<T *>(&storage)->~T();
+    }
+
+    static const Ops ops;
+  };
+
+  template<typename T>
+  struct Impl<T, false>
+  {
+    typedef std::shared_ptr<const T> Ptr_t;
+
+    static void construct(const T &value, Storage_t &storage)
+    {
+      new(&storage) Ptr_t(std::make_shared<T>(value));
+    }
+
+    static const T &get(const Storage_t &storage)
+    {
+      return **reinterpret_cast<const Ptr_t *>(&storage);
+    }
+
+    static void copy(const Storage_t &source, Storage_t &target)
+    {
+      new(&target) Ptr_t(*reinterpret_cast<const Ptr_t *>(&source));
+    }
+
+    static void destroy(Storage_t &storage)
+    {
+      reinterpret_cast<Ptr_t *>(&storage)->~Ptr_t();
+    }
+
+    static const Ops ops;
+  };
+
+public:
+  IWORKPropertyValue()
+    : m_storage()
+    , m_ops(nullptr)
+  {
+  }
+
+  template<typename T>
+  explicit IWORKPropertyValue(const T &value)
+    : m_storage()
+    , m_ops(&Impl<T>::ops)
+  {
+    Impl<T>::construct(value, m_storage);
+  }
+
+  IWORKPropertyValue(const IWORKPropertyValue &other)
+    : m_storage()
+    , m_ops(nullptr)
+  {
+    copyFrom(other);
+  }
+
+  ~IWORKPropertyValue()
+  {
+    destroy();
+  }
+
+  IWORKPropertyValue &operator=(const IWORKPropertyValue &other)
+  {
+    if (this != &other)
+    {
+      destroy();
+      copyFrom(other);
+    }
+    return *this;
+  }
+
+  bool empty() const
+  {
+    return !m_ops;
+  }
+
+  template<typename T>
+  const T &get() const
+  {
+    assert(m_ops == &Impl<T>::ops);
+    return Impl<T>::get(m_storage);
+  }
+
+private:
+  /// Copy the value of @c other into the (empty) storage.
+  void copyFrom(const IWORKPropertyValue &other)
+  {
+    assert(!m_ops);
+    if (!other.m_ops)
+      return;
+    if (other.m_ops->m_trivial)
+      std::memcpy(&m_storage, &other.m_storage, sizeof(Storage_t));
+    else
+      other.m_ops->m_copy(other.m_storage, m_storage);
+    m_ops = other.m_ops;
+  }
+
+  void destroy()
+  {
+    if (m_ops && !m_ops->m_trivial)
+      m_ops->m_destroy(m_storage);
+    m_ops = nullptr;
+  }
+
+private:
+  Storage_t m_storage;
+  const Ops *m_ops;
+};
+
+template<typename T>
+const IWORKPropertyValue::Ops IWORKPropertyValue::Impl<T, true>::ops =
+{
+  std::is_trivially_copyable<T>::value,
+  &IWORKPropertyValue::Impl<T, true>::copy,
+  &IWORKPropertyValue::Impl<T, true>::destroy
+};
+
+template<typename T>
+const IWORKPropertyValue::Ops IWORKPropertyValue::Impl<T, false>::ops =
+{
+  false,
+  &IWORKPropertyValue::Impl<T, false>::copy,
+  &IWORKPropertyValue::Impl<T, false>::destroy
+};
+
+}
+
+#endif // IWORKPROPERTYVALUE_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -434,6 +434,83 @@ IWORKPathPtr_t makeQuoteBubblePath(const IWORKSize &size, const double radius, c
   return makeCalloutPath(size, radius, tailSize, tailX, tailY);
 }
 
+IWORKShapePathCache::IWORKShapePathCache()
+  : m_paths()
+{
+}
+
+template<typename Make>
+IWORKPathPtr_t IWORKShapePathCache::get(const Kind kind, const std::initializer_list<double> params, Make make)
+{
+  // the parameters are compared bitwise, so NaN and -0 are safe too
+  std::string key(1, char(kind));
+  for (const double param : params)
+    key.append(reinterpret_cast<const char *>(&param), sizeof(param));
+
+  const auto it = m_paths.find(key);
+  if (it != m_paths.end())
+    return it->second;
+  const IWORKPathPtr_t path = make();
+  m_paths.insert(std::make_pair(key, path));
+  return path;
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makePolygonPath(const IWORKSize &size, const unsigned edges)
+{
+  return get(KIND_POLYGON, {size.m_width, size.m_height, double(edges)}, [&]()
+  {
+    return libetonyek::makePolygonPath(size, edges);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeRoundedRectanglePath(const IWORKSize &size, const double radius)
+{
+  return get(KIND_ROUNDED_RECTANGLE, {size.m_width, size.m_height, radius}, [&]()
+  {
+    return libetonyek::makeRoundedRectanglePath(size, radius);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeArrowPath(const IWORKSize &size, const double headWidth, const double stemThickness)
+{
+  return get(KIND_ARROW, {size.m_width, size.m_height, headWidth, stemThickness}, [&]()
+  {
+    return libetonyek::makeArrowPath(size, headWidth, stemThickness);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeDoubleArrowPath(const IWORKSize &size, const double headWidth, const double stemThickness)
+{
+  return get(KIND_DOUBLE_ARROW, {size.m_width, size.m_height, headWidth, stemThickness}, [&]()
+  {
+    return libetonyek::makeDoubleArrowPath(size, headWidth, stemThickness);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeStarPath(const IWORKSize &size, const unsigned points, const double innerRadius)
+{
+  return get(KIND_STAR, {size.m_width, size.m_height, double(points), innerRadius}, [&]()
+  {
+    return libetonyek::makeStarPath(size, points, innerRadius);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeCalloutPath(const IWORKSize &size, const double radius, const double tailSize, const double tailX, const double tailY)
+{
+  return get(KIND_CALLOUT, {size.m_width, size.m_height, radius, tailSize, tailX, tailY}, [&]()
+  {
+    return libetonyek::makeCalloutPath(size, radius, tailSize, tailX, tailY);
+  });
+}
+
+IWORKPathPtr_t IWORKShapePathCache::makeQuoteBubblePath(const IWORKSize &size, const double radius, const double tailSize, const double tailX, const double tailY)
+{
+  return get(KIND_QUOTE_BUBBLE, {size.m_width, size.m_height, radius, tailSize, tailX, tailY}, [&]()
+  {
+    return libetonyek::makeQuoteBubblePath(size, radius, tailSize, tailX, tailY);
+  });
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -10,7 +10,10 @@
 #ifndef IWORKSHAPE_H_INCLUDED
 #define IWORKSHAPE_H_INCLUDED
 
+#include <initializer_list>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "IWORKPath_fwd.h"
 #include "IWORKStyle.h"
@@ -50,6 +53,46 @@ IWORKPathPtr_t makeStarPath(const IWORKSize &size, unsigned points, double inner
 IWORKPathPtr_t makeCalloutPath(const IWORKSize &size, double radius, double tailSize, double tailX, double tailY);
 IWORKPathPtr_t makeQuoteBubblePath(const IWORKSize &size, double radius, double tailSize, double tailX, double tailY);
 
+/** A cache of paths of stock shapes.
+  *
+  * A document often repeats the same stock shape, with the same size
+  * and parameters, many times. Its path is only created once and then
+  * shared by all the shapes, so the returned paths must not be
+  * modified. The position of a shape is not a part of the path; it is
+  * applied when the shape is drawn.
+  */
+class IWORKShapePathCache
+{
+  enum Kind
+  {
+    KIND_POLYGON,
+    KIND_ROUNDED_RECTANGLE,
+    KIND_ARROW,
+    KIND_DOUBLE_ARROW,
+    KIND_STAR,
+    KIND_CALLOUT,
+    KIND_QUOTE_BUBBLE
+  };
+
+public:
+  IWORKShapePathCache();
+
+  IWORKPathPtr_t makePolygonPath(const IWORKSize &size, unsigned edges);
+  IWORKPathPtr_t makeRoundedRectanglePath(const IWORKSize &size, double radius);
+  IWORKPathPtr_t makeArrowPath(const IWORKSize &size, double headWidth, double stemThickness);
+  IWORKPathPtr_t makeDoubleArrowPath(const IWORKSize &size, double headWidth, double stemThickness);
+  IWORKPathPtr_t makeStarPath(const IWORKSize &size, unsigned points, double innerRadius);
+  IWORKPathPtr_t makeCalloutPath(const IWORKSize &size, double radius, double tailSize, double tailX, double tailY);
+  IWORKPathPtr_t makeQuoteBubblePath(const IWORKSize &size, double radius, double tailSize, double tailX, double tailY);
+
+private:
+  template<typename Make>
+  IWORKPathPtr_t get(Kind kind, std::initializer_list<double> params, Make make);
+
+private:
+  std::unordered_map<std::string, IWORKPathPtr_t> m_paths; //< keyed by the kind and the bytes of the parameters
+};
+
 }
 
 #endif // IWORKSHAPE_H_INCLUDED
@@ -59,9 +59,9 @@ bool IWORKStyle::link(const IWORKStylesheetPtr_t &stylesheet)
   return bool(m_parent);
 }
 
-void IWORKStyle::flatten()
+void IWORKStyle::freeze()
 {
-  // TODO: implement me
+  m_props.freeze();
 }
 
 const IWORKPropertyMap &IWORKStyle::getPropertyMap() const
@@ -38,11 +38,13 @@ public:
     */
   bool link(const IWORKStylesheetPtr_t &stylesheet);
 
-  /** Copy attributes from parent style (recursively).
+  /** Take a flattened snapshot of the properties, including the inherited ones.
     *
-    * @todo Will this have any effect on performance anyway?
+    * This makes lookups independent of the length of the chain of
+    * parents. It should be done once the parent styles are complete.
+    * Changing the style later drops the snapshot.
     */
-  void flatten();
+  void freeze();
 
   /** Get the style's property map.
     */
@@ -50,6 +50,11 @@ void IWORKStyleStack::set(const IWORKStylePtr_t &style)
   m_stack.front() = style;
 }
 
+bool IWORKStyleStack::operator<(const IWORKStyleStack &other) const
+{
+  return m_stack < other.m_stack;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -65,6 +65,13 @@ public:
 
   void set(const IWORKStylePtr_t &style);
 
+  /** Compare the active styles with those of another stack.
+    *
+    * The styles are compared by identity, not by content. That allows
+    * to use the stack as a key for caching values derived from it.
+    */
+  bool operator<(const IWORKStyleStack &other) const;
+
   template<class Property>
   bool has(const bool lookInParent = true) const
   {
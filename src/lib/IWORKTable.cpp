@@ -12,6 +12,7 @@
 #include <cassert>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <set>
 #include <sstream>
 
@@ -902,6 +903,7 @@ void IWORKTable::draw(const librevenge::RVNGPropertyList &tableProps, IWORKOutpu
             auto const &media=boost::get<IWORKMediaContent>(style.get<property::Fill>());
             if (media.m_data && media.m_data->m_stream)
             {
+              const std::lock_guard<std::mutex> lock(media.m_data->m_mutex);
               auto input=media.m_data->m_stream;
               string mimetype(media.m_data->m_mimeType);
               if (mimetype.empty())
@@ -512,13 +512,26 @@ void IWORKText::draw(IWORKOutputElements &elements)
   flushList();
 
   elements.append(m_elements);
-  m_elements.clear();
+  if (m_elements.isDirect())
+    m_elements = IWORKOutputElements();
+  else
+    m_elements.clear();
+}
+
+void IWORKText::setDirectOutput(IWORKDocumentInterface *const document, const std::function<void()> &prologue)
+{
+  assert(!m_recorder);
+  const IWORKOutputElements elements(m_elements);
+  m_elements = IWORKOutputElements(document, prologue);
+  m_elements.append(elements);
 }
 
 IWORKText::IWORKText(const IWORKLanguageManager &langManager, const bool discardEmptyContent, bool allowListInsertion)
   : m_langManager(langManager)
   , m_layoutStyleStack()
   , m_paraStyleStack()
+  , m_paraPropsCache()
+  , m_spanPropsCache()
   , m_elements()
   , m_hasContent(false)
   , m_layoutStyle()
@@ -1044,7 +1057,14 @@ void IWORKText::closePara()
 void IWORKText::fillParaPropList(librevenge::RVNGPropertyList &propList, bool realParagraph)
 {
   m_paraStyleStack.push(m_paraStyle);
-  libetonyek::fillParaPropList(m_paraStyleStack, propList);
+  PropListCache_t::const_iterator it = m_paraPropsCache.find(m_paraStyleStack);
+  if (it == m_paraPropsCache.end())
+  {
+    librevenge::RVNGPropertyList props;
+    libetonyek::fillParaPropList(m_paraStyleStack, props);
+    it = m_paraPropsCache.insert(PropListCache_t::value_type(m_paraStyleStack, props)).first;
+  }
+  propList = it->second;
 
   if (realParagraph)
   {
@@ -1068,8 +1088,14 @@ void IWORKText::openSpan()
   m_paraStyleStack.push(m_paraStyle);
   m_paraStyleStack.push(m_spanStyle);
   m_paraStyleStack.push(m_langStyle);
-  librevenge::RVNGPropertyList props;
-  fillCharPropList(m_paraStyleStack, m_langManager, props);
+  PropListCache_t::const_iterator it = m_spanPropsCache.find(m_paraStyleStack);
+  if (it == m_spanPropsCache.end())
+  {
+    librevenge::RVNGPropertyList props;
+    fillCharPropList(m_paraStyleStack, m_langManager, props);
+    it = m_spanPropsCache.insert(PropListCache_t::value_type(m_paraStyleStack, props)).first;
+  }
+  const librevenge::RVNGPropertyList &props = it->second;
   m_paraStyleStack.pop();
   m_paraStyleStack.pop();
   m_paraStyleStack.pop();
@@ -13,6 +13,8 @@
 #include "IWORKText_fwd.h"
 
 #include <deque>
+#include <functional>
+#include <map>
 #include <stack>
 
 #include <glm/glm.hpp>
@@ -27,11 +29,20 @@
 namespace libetonyek
 {
 
+class IWORKDocumentInterface;
 class IWORKLanguageManager;
 class IWORKTextRecorder;
 
 class IWORKText
 {
+  /** Property lists of paragraphs or spans, by the style stack they
+    * have been created from.
+    *
+    * This relies on styles not being changed after they have been
+    * used in text.
+    */
+  typedef std::map<IWORKStyleStack, librevenge::RVNGPropertyList> PropListCache_t;
+
 public:
   IWORKText(const IWORKLanguageManager &langManager, bool discardEmptyContent, bool allowListInsertion);
   ~IWORKText();
@@ -87,6 +98,17 @@ public:
 
   void draw(IWORKOutputElements &elements);
 
+  /** Pass the content directly to a document from now on.
+    *
+    * The content collected so far is passed first. The direct output
+    * ends when the text is drawn.
+    *
+    * @arg[in] document the document to pass the content to.
+    * @arg[in] prologue function that is called just before the first
+    *   element is passed to the document, if set.
+    */
+  void setDirectOutput(IWORKDocumentInterface *document, const std::function<void()> &prologue);
+
   // utility function
   static void fillCharPropList(const IWORKStyleStack &style, const IWORKLanguageManager &langManager, librevenge::RVNGPropertyList &props);
 
@@ -109,6 +131,8 @@ private:
 
   IWORKStyleStack m_layoutStyleStack;
   IWORKStyleStack m_paraStyleStack;
+  PropListCache_t m_paraPropsCache;
+  PropListCache_t m_spanPropsCache;
 
   IWORKOutputElements m_elements;
 
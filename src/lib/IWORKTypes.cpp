@@ -112,6 +112,7 @@ IWORKData::IWORKData()
   : m_stream()
   , m_displayName()
   , m_mimeType()
+  , m_mutex()
 {
 }
 
@@ -14,6 +14,7 @@
 
 #include <deque>
 #include <map>
+#include <mutex>
 #include <string>
 
 #include <boost/optional.hpp>
@@ -141,6 +142,8 @@ struct IWORKData
   RVNGInputStreamPtr_t m_stream;
   boost::optional<std::string> m_displayName;
   std::string m_mimeType;
+  /// Guards reading of m_stream, as the data can be shared by concurrently parsed slides.
+  std::mutex m_mutex;
 
   IWORKData();
 };
@@ -28,6 +28,7 @@ IWORKXMLParserState::IWORKXMLParserState(IWORKParser &parser, IWORKCollector &co
   , m_formatNameMap()
   , m_tableNameMap(std::make_shared<IWORKTableNameMap_t>())
   , m_langManager()
+  , m_formulaCache()
   , m_currentTable()
   , m_currentText()
   , m_parser(parser)
@@ -12,6 +12,7 @@
 
 #include <memory>
 
+#include "IWORKFormula.h"
 #include "IWORKStylesheet.h"
 #include "IWORKLanguageManager.h"
 #include "IWORKStyle_fwd.h"
@@ -52,6 +53,7 @@ public:
   IWORKFormatNameMap m_formatNameMap;
   IWORKTableNameMapPtr_t m_tableNameMap;
   IWORKLanguageManager m_langManager;
+  IWORKFormula::Cache m_formulaCache;
   std::shared_ptr<IWORKTable> m_currentTable;
   std::shared_ptr<IWORKText> m_currentText;
 
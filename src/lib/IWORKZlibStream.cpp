@@ -9,6 +9,7 @@
 
 #include "IWORKZlibStream.h"
 
+#include <utility>
 #include <vector>
 
 #include <zlib.h>
@@ -28,92 +29,98 @@ class ZlibStreamException
 {
 };
 
-RVNGInputStreamPtr_t getInflatedStream(const RVNGInputStreamPtr_t &input)
+RVNGInputStreamPtr_t getInflatedStream(const RVNGInputStreamPtr_t &input, const unsigned long begin, const unsigned long compressedSize)
 {
-  unsigned long offset = 2;
-
-  const unsigned char sig1 = readU8(input);
-  if (0x78 != sig1) // not a zlib stream
-  {
-    offset = 3;
-    const unsigned char sig2 = readU8(input);
-    if ((0x1f != sig1) || (0x8b != sig2))
-      throw ZlibStreamException();
-  }
-
-  const bool uncompressed = Z_NO_COMPRESSION == readU8(input);
-  if (uncompressed)
-    offset = 0;
-
-  auto begin = (unsigned long) input->tell();
-  input->seek(0, librevenge::RVNG_SEEK_END);
-  auto end = (unsigned long) input->tell();
-  unsigned long compressedSize = end - begin + offset;
-  input->seek(long(begin - offset), librevenge::RVNG_SEEK_SET);
+  input->seek(long(begin), librevenge::RVNG_SEEK_SET);
 
   unsigned long numBytesRead = 0;
   auto *compressedData = const_cast<unsigned char *>(input->read(compressedSize, numBytesRead));
 
-  if (uncompressed)
-  {
-    if (numBytesRead != compressedSize)
-      throw ZlibStreamException();
-    return RVNGInputStreamPtr_t(new IWORKMemoryStream(compressedData, static_cast<unsigned>(compressedSize)));
-  }
-  else
-  {
-    int ret;
-    z_stream strm;
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = (unsigned)numBytesRead;
-    strm.next_in = (Bytef *)compressedData;
-    strm.total_in = 0;
-    strm.total_out = 0;
-
-    ret = inflateInit2(&strm, 16 + MAX_WBITS);
-    if (ret != Z_OK)
-      throw ZlibStreamException();
+  int ret;
+  z_stream strm;
+
+  /* allocate inflate state */
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  strm.avail_in = (unsigned)numBytesRead;
+  strm.next_in = (Bytef *)compressedData;
+  strm.total_in = 0;
+  strm.total_out = 0;
+
+  ret = inflateInit2(&strm, 16 + MAX_WBITS);
+  if (ret != Z_OK)
+    throw ZlibStreamException();
 
-    vector<unsigned char> data(2 * compressedSize);
+  vector<unsigned char> data(2 * compressedSize);
 
-    while (true)
+  while (true)
+  {
+    strm.next_out = reinterpret_cast<Bytef *>(&data[strm.total_out]);
+    strm.avail_out = unsigned(data.size() - strm.total_out);
+    ret = inflate(&strm, Z_SYNC_FLUSH);
+
+    if (Z_STREAM_END == ret)
+      break;
+    if ((Z_OK == ret) && (0 == strm.avail_in) && (0 < strm.avail_out)) // end of stream too
+      break;
+    if (Z_OK != ret)
     {
-      strm.next_out = reinterpret_cast<Bytef *>(&data[strm.total_out]);
-      strm.avail_out = unsigned(data.size() - strm.total_out);
-      ret = inflate(&strm, Z_SYNC_FLUSH);
-
-      if (Z_STREAM_END == ret)
-        break;
-      if ((Z_OK == ret) && (0 == strm.avail_in) && (0 < strm.avail_out)) // end of stream too
-        break;
-      if (Z_OK != ret)
-      {
-        (void)inflateEnd(&strm);
-        throw ZlibStreamException();
-      }
-
-      data.resize(data.size() + compressedSize);
+      (void)inflateEnd(&strm);
+      throw ZlibStreamException();
     }
 
-    (void)inflateEnd(&strm);
-
-    return RVNGInputStreamPtr_t(new IWORKMemoryStream(&data[0], (unsigned) strm.total_out));
+    data.resize(data.size() + compressedSize);
   }
+
+  (void)inflateEnd(&strm);
+
+  data.resize(strm.total_out);
+  return std::make_shared<IWORKMemoryStream>(std::move(data));
 }
 
 }
 
 IWORKZlibStream::IWORKZlibStream(const RVNGInputStreamPtr_t &stream)
   : m_stream()
+  , m_begin(0)
+  , m_length(0)
+  , m_pos(0)
 {
   if (0 != stream->seek(0, librevenge::RVNG_SEEK_SET))
     throw EndOfStreamException();
 
-  m_stream = getInflatedStream(stream);
+  unsigned long offset = 2;
+
+  const unsigned char sig1 = readU8(stream);
+  if (0x78 != sig1) // not a zlib stream
+  {
+    offset = 3;
+    const unsigned char sig2 = readU8(stream);
+    if ((0x1f != sig1) || (0x8b != sig2))
+      throw ZlibStreamException();
+  }
+
+  const bool uncompressed = Z_NO_COMPRESSION == readU8(stream);
+
+  const auto begin = (unsigned long) stream->tell();
+  stream->seek(0, librevenge::RVNG_SEEK_END);
+  const auto end = (unsigned long) stream->tell();
+
+  if (uncompressed)
+  {
+    // There is nothing to inflate, so just expose the rest of the input.
+    if (begin == end)
+      throw ZlibStreamException();
+    m_stream = stream;
+    m_begin = long(begin);
+    m_length = long(end - begin);
+  }
+  else
+  {
+    m_stream = getInflatedStream(stream, begin - offset, end - begin + offset);
+    m_length = long(getLength(m_stream));
+  }
 }
 
 IWORKZlibStream::~IWORKZlibStream()
@@ -145,24 +152,58 @@ librevenge::RVNGInputStream *IWORKZlibStream::getSubStreamById(unsigned)
   return nullptr;
 }
 
-const unsigned char *IWORKZlibStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+const unsigned char *IWORKZlibStream::read(unsigned long numBytes, unsigned long &numBytesRead)
 {
-  return m_stream->read(numBytes, numBytesRead);
+  numBytesRead = 0;
+
+  if ((0 == numBytes) || (m_pos >= m_length))
+    return nullptr;
+
+  if (numBytes > static_cast<unsigned long>(m_length - m_pos))
+    numBytes = static_cast<unsigned long>(m_length - m_pos);
+
+  // the underlying stream might be shared, so always reposition it
+  if (0 != m_stream->seek(m_begin + m_pos, librevenge::RVNG_SEEK_SET))
+    return nullptr;
+
+  const unsigned char *const data = m_stream->read(numBytes, numBytesRead);
+  m_pos += long(numBytesRead);
+  return data;
 }
 
-int IWORKZlibStream::seek(long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+int IWORKZlibStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
 {
-  return m_stream->seek(offset, seekType);
+  long pos = 0;
+  switch (seekType)
+  {
+  case librevenge::RVNG_SEEK_SET :
+    pos = offset;
+    break;
+  case librevenge::RVNG_SEEK_CUR :
+    pos = offset + m_pos;
+    break;
+  case librevenge::RVNG_SEEK_END :
+    pos = offset + m_length;
+    break;
+  default :
+    return -1;
+  }
+
+  if ((pos < 0) || (pos > m_length))
+    return 1;
+
+  m_pos = pos;
+  return 0;
 }
 
 long IWORKZlibStream::tell()
 {
-  return m_stream->tell();
+  return m_pos;
 }
 
 bool IWORKZlibStream::isEnd()
 {
-  return m_stream->isEnd();
+  return m_length == m_pos;
 }
 
 }
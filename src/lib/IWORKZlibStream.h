@@ -17,6 +17,10 @@ namespace libetonyek
 
 class IWORKZlibStream : public librevenge::RVNGInputStream
 {
+  // -Weffc++
+  IWORKZlibStream(const IWORKZlibStream &other);
+  IWORKZlibStream &operator=(const IWORKZlibStream &other);
+
 public:
   explicit IWORKZlibStream(const RVNGInputStreamPtr_t &stream);
   ~IWORKZlibStream() override;
@@ -37,7 +41,15 @@ public:
   bool isEnd() override;
 
 private:
+  /** Either the inflated content or, for stored members, the input itself.
+    *
+    * In the latter case only the window [m_begin, m_begin + m_length)
+    * of it is visible.
+    */
   RVNGInputStreamPtr_t m_stream;
+  long m_begin;
+  long m_length;
+  long m_pos;
 };
 
 }
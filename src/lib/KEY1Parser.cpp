@@ -1676,10 +1676,14 @@ private:
   void startOfElement() override;
   IWORKXMLContextPtr_t element(int name) override;
   void endOfElement() override;
+
+private:
+  unsigned m_slideIndex;
 };
 
 SlideListElement::SlideListElement(KEY1ParserState &state)
   : KEY1XMLElementContextBase(state)
+  , m_slideIndex(0)
 {
 }
 
@@ -1694,6 +1698,8 @@ IWORKXMLContextPtr_t SlideListElement::element(const int name)
   switch (name)
   {
   case KEY1Token::slide | KEY1Token::NS_URI_KEY :
+    if (!getCollector().isSlideInRange(m_slideIndex++))
+      break; // skip the whole slide
     return std::make_shared<SlideElement>(getState(), false);
   default :
     ETONYEK_DEBUG_MSG(("SlideListElement::element[KEY1Parser.cpp]: unexpected element\n"));
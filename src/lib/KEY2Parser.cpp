@@ -9,7 +9,15 @@
 
 #include "KEY2Parser.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "libetonyek_utils.h"
 #include "libetonyek_xml.h"
@@ -20,6 +28,7 @@
 #include "IWORKImageElement.h"
 #include "IWORKLineElement.h"
 #include "IWORKMediaElement.h"
+#include "IWORKMemoryStream.h"
 #include "IWORKPath.h"
 #include "IWORKPathElement.h"
 #include "IWORKPositionElement.h"
@@ -43,6 +52,7 @@
 #include "KEY2Dictionary.h"
 #include "KEY2ParserState.h"
 #include "KEY2StyleContext.h"
+#include "KEY2Structure.h"
 #include "KEY2Token.h"
 #include "KEY2XMLContextBase.h"
 #include "KEYCollector.h"
@@ -77,6 +87,122 @@ unsigned getVersion(const int token)
   return 0;
 }
 
+/// Get the number of threads to parse @c count groups of slides with.
+unsigned getThreadCount(const std::size_t count)
+{
+  const unsigned cores = std::thread::hardware_concurrency();
+  return unsigned((std::min)(count, std::size_t(cores > 0 ? cores : 1)));
+}
+
+bool readAll(const RVNGInputStreamPtr_t &input, std::vector<unsigned char> &data)
+{
+  if (0 != input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+  while (!input->isEnd())
+  {
+    unsigned long readBytes = 0;
+    const unsigned char *const bytes = input->read(0x10000, readBytes);
+    if (!bytes || (0 == readBytes))
+      break;
+    data.insert(data.end(), bytes, bytes + readBytes);
+  }
+  return input->isEnd();
+}
+
+/** A stream that can be used by several threads at once.
+  *
+  * All calls are serialized. That is enough for a package, which is
+  * only asked for substreams, as these do not depend on the package
+  * once they are created.
+  */
+class LockedStream : public librevenge::RVNGInputStream
+{
+public:
+  explicit LockedStream(const RVNGInputStreamPtr_t &stream);
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+private:
+  const RVNGInputStreamPtr_t m_stream;
+  std::mutex m_mutex;
+};
+
+LockedStream::LockedStream(const RVNGInputStreamPtr_t &stream)
+  : m_stream(stream)
+  , m_mutex()
+{
+}
+
+bool LockedStream::isStructured()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->isStructured();
+}
+
+unsigned LockedStream::subStreamCount()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->subStreamCount();
+}
+
+const char *LockedStream::subStreamName(const unsigned id)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->subStreamName(id);
+}
+
+bool LockedStream::existsSubStream(const char *const name)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->existsSubStream(name);
+}
+
+librevenge::RVNGInputStream *LockedStream::getSubStreamByName(const char *const name)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->getSubStreamByName(name);
+}
+
+librevenge::RVNGInputStream *LockedStream::getSubStreamById(const unsigned id)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->getSubStreamById(id);
+}
+
+const unsigned char *LockedStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->read(numBytes, numBytesRead);
+}
+
+int LockedStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->seek(offset, seekType);
+}
+
+long LockedStream::tell()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->tell();
+}
+
+bool LockedStream::isEnd()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stream->isEnd();
+}
+
 }
 
 namespace
@@ -1251,10 +1377,14 @@ private:
   void startOfElement() override;
   IWORKXMLContextPtr_t element(int name) override;
   void endOfElement() override;
+
+private:
+  unsigned m_slideIndex;
 };
 
 SlideListElement::SlideListElement(KEY2ParserState &state)
   : KEY2XMLElementContextBase(state)
+  , m_slideIndex(0)
 {
 }
 
@@ -1269,6 +1399,8 @@ IWORKXMLContextPtr_t SlideListElement::element(const int name)
   switch (name)
   {
   case KEY2Token::NS_URI_KEY | KEY2Token::slide :
+    if (!getCollector().isSlideInRange(m_slideIndex++))
+      break; // skip the whole slide
     return std::make_shared<SlideElement>(getState(), false);
   default:
     break;
@@ -1279,6 +1411,8 @@ IWORKXMLContextPtr_t SlideListElement::element(const int name)
 
 void SlideListElement::endOfElement()
 {
+  // the slides might have been cut out of the list
+  getState().getParser().parseSeparatedSlides();
   if (isCollector())
     getCollector().endSlides();
 }
@@ -1543,6 +1677,87 @@ IWORKXMLContextPtr_t XMLDocument::element(const int name)
 namespace
 {
 
+class SlidePresentationElement : public KEY2XMLElementContextBase
+{
+public:
+  SlidePresentationElement(KEY2ParserState &state, bool slideInRange);
+
+private:
+  void attribute(int name, const char *value) override;
+  IWORKXMLContextPtr_t element(int name) override;
+
+private:
+  const bool m_slideInRange;
+};
+
+SlidePresentationElement::SlidePresentationElement(KEY2ParserState &state, const bool slideInRange)
+  : KEY2XMLElementContextBase(state)
+  , m_slideInRange(slideInRange)
+{
+}
+
+void SlidePresentationElement::attribute(int, const char *)
+{
+  // the version has been taken over from the parser of the presentation
+}
+
+IWORKXMLContextPtr_t SlidePresentationElement::element(const int name)
+{
+  switch (name)
+  {
+  case KEY2Token::NS_URI_KEY | KEY2Token::slide :
+    if (!m_slideInRange)
+      break; // skip the whole slide
+    return std::make_shared<SlideElement>(getState(), false);
+  default:
+    break;
+  }
+
+  return IWORKXMLContextPtr_t();
+}
+
+}
+
+namespace
+{
+
+/// A document consisting of a single slide, cut out of a presentation.
+class SlideDocument : public KEY2XMLElementContextBase
+{
+public:
+  SlideDocument(KEY2ParserState &state, bool slideInRange);
+
+private:
+  IWORKXMLContextPtr_t element(int name) override;
+
+private:
+  const bool m_slideInRange;
+};
+
+SlideDocument::SlideDocument(KEY2ParserState &state, const bool slideInRange)
+  : KEY2XMLElementContextBase(state)
+  , m_slideInRange(slideInRange)
+{
+}
+
+IWORKXMLContextPtr_t SlideDocument::element(const int name)
+{
+  switch (name)
+  {
+  case KEY2Token::NS_URI_KEY | KEY2Token::presentation :
+    return std::make_shared<SlidePresentationElement>(m_state, m_slideInRange);
+  default:
+    break;
+  }
+
+  return IWORKXMLContextPtr_t();
+}
+
+}
+
+namespace
+{
+
 class DiscardContext : public KEY2XMLContextBase<IWORKDiscardContext>
 {
 public:
@@ -1599,15 +1814,157 @@ IWORKXMLContextPtr_t DiscardContext::element(const int name)
 KEY2Parser::KEY2Parser(const RVNGInputStreamPtr_t &input, const RVNGInputStreamPtr_t &package, KEYCollector &collector, KEY2Dictionary &dict)
   : IWORKParser(input, package)
   , m_state(*this, collector, dict)
+  , m_slideParser(false)
+  , m_slideInRange(false)
+  , m_document()
+  , m_structure()
 {
 }
 
+KEY2Parser::KEY2Parser(const KEY2Parser &parent, const RVNGInputStreamPtr_t &package, KEYCollector &collector, KEY2Dictionary &dict)
+  : IWORKParser(RVNGInputStreamPtr_t(), package)
+  , m_state(*this, collector, dict)
+  , m_slideParser(true)
+  , m_slideInRange(false)
+  , m_document()
+  , m_structure()
+{
+  m_state.setVersion(parent.m_state.getVersion());
+  collector.setAccumulateTransformTo(parent.m_state.getVersion() > 2);
+  m_state.m_formatNameMap = parent.m_state.m_formatNameMap;
+  // the parsers must not add table names to the same map
+  *m_state.m_tableNameMap = *parent.m_state.m_tableNameMap;
+}
+
 KEY2Parser::~KEY2Parser()
 {
 }
 
+bool KEY2Parser::parse()
+{
+  separateSlides();
+  return IWORKParser::parse();
+}
+
+void KEY2Parser::parseSeparatedSlides()
+{
+  if (!m_structure)
+    return;
+  const std::unique_ptr<KEY2Structure> structure(std::move(m_structure));
+  const std::vector<unsigned char> document(std::move(m_document));
+  const std::deque<KEY2Structure::Slide> &slides = structure->m_slides;
+
+  KEYCollector &collector = m_state.getCollector();
+  KEY2Dictionary &dict = m_state.getDictionary();
+
+  // skipped slides have no layers
+  std::vector<bool> inRange(slides.size());
+  std::vector<int> layerCounts(slides.size());
+  int layerCount = collector.getLayerCount();
+  std::unordered_map<std::size_t, std::size_t> lastInRange;
+  for (std::size_t i = 0; i < slides.size(); ++i)
+  {
+    inRange[i] = collector.isSlideInRange(unsigned(i));
+    layerCounts[i] = layerCount;
+    if (inRange[i])
+    {
+      layerCount += int(slides[i].m_layerCount);
+      lastInRange[slides[i].m_group] = i;
+    }
+  }
+
+  // groups without a slide in range are not needed at all
+  std::vector<std::vector<std::size_t> > groups;
+  std::unordered_map<std::size_t, std::size_t> groupIndices;
+  for (std::size_t i = 0; i < slides.size(); ++i)
+  {
+    const auto last = lastInRange.find(slides[i].m_group);
+    if ((lastInRange.end() == last) || (last->second < i))
+      continue;
+    const auto index = groupIndices.insert(std::make_pair(slides[i].m_group, groups.size())).first;
+    if (index->second == groups.size())
+      groups.push_back(std::vector<std::size_t>());
+    groups[index->second].push_back(i);
+  }
+
+  // the styles are shared by the slide parsers
+  dict.createListLevelStyles();
+  const RVNGInputStreamPtr_t package(bool(getPackage()) ? std::make_shared<LockedStream>(getPackage()) : RVNGInputStreamPtr_t());
+
+  std::vector<KEYSlidePtr_t> parsedSlides(slides.size());
+  std::atomic<std::size_t> next(0);
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  // every thread takes the next group until there are none left
+  const auto parseSomeGroups = [&]()
+  {
+    try
+    {
+      // the slides are sent to the document by the main collector
+      KEYCollector slideCollector(nullptr);
+      KEY2Dictionary slideDict(dict);
+      KEY2Parser parser(*this, package, slideCollector, slideDict);
+      slideCollector.startSlides();
+      for (std::size_t group = next++; group < groups.size(); group = next++)
+      {
+        for (const std::size_t i : groups[group])
+        {
+          slideDict.m_slides.clear();
+          slideCollector.setLayerCount(layerCounts[i]);
+          parser.parseSlide(document, *structure, i, inRange[i]);
+          if (inRange[i] && !slideDict.m_slides.empty())
+            parsedSlides[i] = slideDict.m_slides.back();
+          if (inRange[i] && (slideCollector.getLayerCount() != layerCounts[i] + int(slides[i].m_layerCount)))
+          {
+            ETONYEK_DEBUG_MSG(("KEY2Parser::parseSeparatedSlides: unexpected number of layers in slide %u\n", unsigned(i)));
+          }
+        }
+      }
+      slideCollector.endSlides();
+    }
+    catch (...)
+    {
+      const std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error)
+        error = std::current_exception();
+      next = groups.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const unsigned threadCount = getThreadCount(groups.size());
+  for (unsigned i = 1; i < threadCount; ++i)
+  {
+    try
+    {
+      threads.emplace_back(parseSomeGroups);
+    }
+    catch (const std::system_error &)
+    {
+      ETONYEK_DEBUG_MSG(("KEY2Parser::parseSeparatedSlides: cannot start more than %u threads\n", i));
+      break;
+    }
+  }
+  parseSomeGroups();
+  for (auto &thread : threads)
+    thread.join();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  collector.setLayerCount(layerCount);
+  for (const auto &slide : parsedSlides)
+  {
+    if (slide)
+      dict.m_slides.push_back(slide);
+  }
+}
+
 IWORKXMLContextPtr_t KEY2Parser::createDocumentContext()
 {
+  if (m_slideParser)
+    return std::make_shared<SlideDocument>(m_state, m_slideInRange);
   return std::make_shared<XMLDocument>(m_state);
 }
 
@@ -1622,6 +1979,58 @@ const IWORKTokenizer &KEY2Parser::getTokenizer() const
   return tokenizer;
 }
 
+void KEY2Parser::separateSlides()
+{
+  // the groups of slides are parsed concurrently, so it only pays off with several cores
+  if ((getThreadCount(2) < 2) || !getInput())
+    return;
+
+  const RVNGInputStreamPtr_t input(getInput());
+  std::vector<unsigned char> document;
+  std::unique_ptr<KEY2Structure> structure(new KEY2Structure());
+  if (!readAll(input, document) || !structure->scan(document.data(), document.size(), getTokenizer()))
+  {
+    input->seek(0, librevenge::RVNG_SEEK_SET);
+    return;
+  }
+
+  std::unordered_set<std::size_t> groups;
+  for (std::size_t i = 0; i < structure->m_slides.size(); ++i)
+  {
+    if (m_state.getCollector().isSlideInRange(unsigned(i)))
+      groups.insert(structure->m_slides[i].m_group);
+  }
+  if (groups.size() < 2)
+  {
+    input->seek(0, librevenge::RVNG_SEEK_SET);
+    return;
+  }
+
+  // the rest of the document, with an empty slide list
+  std::vector<unsigned char> rest(document.begin(), document.begin() + long(structure->m_slideListBegin));
+  rest.insert(rest.end(), document.begin() + long(structure->m_slideListEnd), document.end());
+  setInput(std::make_shared<IWORKMemoryStream>(std::move(rest)));
+
+  m_document.swap(document);
+  m_structure = std::move(structure);
+}
+
+void KEY2Parser::parseSlide(const std::vector<unsigned char> &document, const KEY2Structure &structure, const std::size_t index, const bool inRange)
+{
+  const KEY2Structure::Slide &slide = structure.m_slides[index];
+  const std::string endTag("</" + structure.m_rootName + ">");
+
+  std::vector<unsigned char> slideDocument;
+  slideDocument.reserve(structure.m_rootEnd + (slide.m_end - slide.m_begin) + endTag.size());
+  slideDocument.insert(slideDocument.end(), document.begin(), document.begin() + long(structure.m_rootEnd));
+  slideDocument.insert(slideDocument.end(), document.begin() + long(slide.m_begin), document.begin() + long(slide.m_end));
+  slideDocument.insert(slideDocument.end(), endTag.begin(), endTag.end());
+
+  setInput(std::make_shared<IWORKMemoryStream>(std::move(slideDocument)));
+  m_slideInRange = inRange;
+  IWORKParser::parse();
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
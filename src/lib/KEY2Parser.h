@@ -10,6 +10,9 @@
 #ifndef KEY2PARSER_H_INCLUDED
 #define KEY2PARSER_H_INCLUDED
 
+#include <memory>
+#include <vector>
+
 #include "IWORKParser.h"
 #include "KEY2ParserState.h"
 
@@ -18,6 +21,7 @@ namespace libetonyek
 
 class KEYCollector;
 struct KEY2Dictionary;
+struct KEY2Structure;
 
 class KEY2Parser : public IWORKParser
 {
@@ -25,13 +29,51 @@ public:
   KEY2Parser(const RVNGInputStreamPtr_t &input, const RVNGInputStreamPtr_t &package, KEYCollector &collector, KEY2Dictionary &dict);
   ~KEY2Parser() override;
 
+  /** Parse the presentation.
+    *
+    * If there are several cores, the slides are first cut out of the
+    * document. The rest of it is parsed as usual, which fills the
+    * dictionary, and the slides are then parsed concurrently.
+    */
+  bool parse() override;
+
+  /** Parse the slides cut out of the document, if any.
+    *
+    * This is called at the end of the slide list. The slides are added
+    * to the dictionary in presentation order.
+    */
+  void parseSeparatedSlides();
+
 private:
+  /** Create a parser for a group of slides of the presentation parsed by @c parent.
+    *
+    * The parser starts with a copy of the format and table names of
+    * @c parent. It only gets documents consisting of a single slide.
+    */
+  KEY2Parser(const KEY2Parser &parent, const RVNGInputStreamPtr_t &package, KEYCollector &collector, KEY2Dictionary &dict);
+
   IWORKXMLContextPtr_t createDocumentContext() override;
   IWORKXMLContextPtr_t createDiscardContext() override;
   const IWORKTokenizer &getTokenizer() const override;
 
+  /** Cut the slides out of the input, if it is worth it.
+    *
+    * On success, only the rest of the document is left in the input.
+    */
+  void separateSlides();
+  /** Parse slide @c index of the cut out slides.
+    *
+    * A slide that is not in range only contributes its styles to the
+    * dictionary, as if it were skipped by the slide list.
+    */
+  void parseSlide(const std::vector<unsigned char> &document, const KEY2Structure &structure, std::size_t index, bool inRange);
+
 private:
   KEY2ParserState m_state;
+  const bool m_slideParser; //< parsing single slides for another parser?
+  bool m_slideInRange; //< is the slide parsed by a slide parser in range?
+  std::vector<unsigned char> m_document; //< the whole document, if the slides have been cut out
+  std::unique_ptr<KEY2Structure> m_structure; //< the positions of the cut out slides
 };
 
 }
@@ -21,6 +21,7 @@ namespace libetonyek
 KEY2ParserState::KEY2ParserState(KEY2Parser &parser, KEYCollector &collector, KEY2Dictionary &dict)
   : IWORKXMLParserState(parser, collector, dict)
   , m_version(0)
+  , m_parser(parser)
   , m_dict(dict)
   , m_collector(collector)
   , m_isHeadlineOpened(false)
@@ -40,6 +41,11 @@ unsigned KEY2ParserState::getVersion() const
   return m_version;
 }
 
+KEY2Parser &KEY2ParserState::getParser()
+{
+  return m_parser;
+}
+
 KEY2Dictionary &KEY2ParserState::getDictionary()
 {
   return m_dict;
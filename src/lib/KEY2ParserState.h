@@ -33,6 +33,7 @@ public:
   void setVersion(unsigned version);
   unsigned getVersion() const;
 
+  KEY2Parser &getParser();
   KEY2Dictionary &getDictionary();
   KEYCollector &getCollector();
 
@@ -47,6 +48,7 @@ public:
 
 private:
   unsigned m_version;
+  KEY2Parser &m_parser;
   KEY2Dictionary &m_dict;
   KEYCollector &m_collector;
 
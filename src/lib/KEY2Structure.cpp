@@ -0,0 +1,392 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "KEY2Structure.h"
+
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <libxml/parser.h>
+
+#include "libetonyek_xml.h"
+#include "IWORKToken.h"
+#include "IWORKTokenizer.h"
+#include "KEY2Token.h"
+
+namespace libetonyek
+{
+
+namespace
+{
+
+class Scanner
+{
+  // -Weffc++
+  Scanner(const Scanner &);
+  Scanner &operator=(const Scanner &);
+
+  enum Section
+  {
+    SECTION_BEFORE_SLIDES,
+    SECTION_SLIDES,
+    SECTION_AFTER_SLIDES
+  };
+
+public:
+  Scanner(const unsigned char *data, std::size_t length, const IWORKTokenizer &tokenizer, KEY2Structure &structure);
+
+  bool scan();
+
+  void startElement(const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri, int namespaceCount, int attributeCount, const xmlChar **attributes, long pos);
+  void endElement(long pos);
+
+private:
+  /** Check that the slides of this version can be parsed separately.
+    *
+    * Version 2 slides get an extra layer for their bullets, which
+    * cannot be counted in advance.
+    */
+  bool checkVersion(int attributeCount, const xmlChar **attributes) const;
+  /// Find the start of the tag that contains @c pos.
+  bool findTagStart(long pos, std::size_t &start) const;
+  /// Find the groups of slides that depend on each other.
+  bool groupSlides();
+
+private:
+  const unsigned char *const m_data;
+  const std::size_t m_length;
+  const IWORKTokenizer &m_tokenizer;
+  KEY2Structure &m_structure;
+
+  Section m_section;
+  unsigned m_depth;
+  bool m_valid;
+  /// Names of the open elements.
+  std::vector<int> m_names;
+
+  /// The slide each ID is defined in.
+  std::unordered_map<std::string, std::size_t> m_definitions;
+  /// The first slide that refers to each placeholder.
+  std::unordered_map<std::string, std::size_t> m_placeholders;
+  /// References made from the slides (values of all attributes but IDs).
+  std::vector<std::pair<std::size_t, std::string> > m_references;
+  /// References made after the slide list (values of all attributes but IDs).
+  std::vector<std::string> m_laterReferences;
+  /// Pairs of slides that must be in the same group.
+  std::vector<std::pair<std::size_t, std::size_t> > m_links;
+};
+
+void startElementNs(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri,
+                    int namespaceCount, const xmlChar **, int attributeCount, int, const xmlChar **attributes)
+{
+  const xmlParserCtxtPtr context = static_cast<xmlParserCtxtPtr>(ctx);
+  static_cast<Scanner *>(context->_private)->startElement(localname, prefix, uri, namespaceCount, attributeCount, attributes, xmlByteConsumed(context));
+}
+
+void endElementNs(void *ctx, const xmlChar *, const xmlChar *, const xmlChar *)
+{
+  const xmlParserCtxtPtr context = static_cast<xmlParserCtxtPtr>(ctx);
+  static_cast<Scanner *>(context->_private)->endElement(xmlByteConsumed(context));
+}
+
+Scanner::Scanner(const unsigned char *const data, const std::size_t length, const IWORKTokenizer &tokenizer, KEY2Structure &structure)
+  : m_data(data)
+  , m_length(length)
+  , m_tokenizer(tokenizer)
+  , m_structure(structure)
+  , m_section(SECTION_BEFORE_SLIDES)
+  , m_depth(0)
+  , m_valid(true)
+  , m_names()
+  , m_definitions()
+  , m_placeholders()
+  , m_references()
+  , m_laterReferences()
+  , m_links()
+{
+}
+
+bool Scanner::scan()
+{
+  if ((0 == m_length) || (std::size_t(INT_MAX) < m_length))
+    return false;
+
+  xmlSAXHandler handler;
+  std::memset(&handler, 0, sizeof(handler));
+  handler.initialized = XML_SAX2_MAGIC;
+  handler.startElementNs = startElementNs;
+  handler.endElementNs = endElementNs;
+
+  // without user data, the callbacks get the parser context
+  const std::unique_ptr<xmlParserCtxt, void (*)(xmlParserCtxtPtr)> context(
+    xmlCreatePushParserCtxt(&handler, nullptr, nullptr, 0, nullptr), xmlFreeParserCtxt);
+  if (!context)
+    return false;
+  xmlCtxtUseOptions(context.get(), XML_PARSE_NONET);
+  context->_private = this;
+
+  const int result = xmlParseChunk(context.get(), reinterpret_cast<const char *>(m_data), int(m_length), 1);
+  if ((0 != result) || !context->wellFormed || !m_valid)
+    return false;
+  if ((SECTION_AFTER_SLIDES != m_section) || m_structure.m_slides.empty())
+    return false;
+
+  return groupSlides();
+}
+
+void Scanner::startElement(const xmlChar *const localname, const xmlChar *const prefix, const xmlChar *const uri,
+                           const int namespaceCount, const int attributeCount, const xmlChar **const attributes, const long pos)
+{
+  ++m_depth;
+  const int name = m_tokenizer.getQualifiedId(char_cast(localname), char_cast(uri));
+  m_names.push_back(name);
+  if (!m_valid)
+    return;
+  if ((0 > pos) || (m_length <= std::size_t(pos)))
+  {
+    m_valid = false;
+    return;
+  }
+  const bool isEmpty = '/' == m_data[pos];
+
+  if (1 == m_depth)
+  {
+    m_structure.m_rootName = prefix ? std::string(char_cast(prefix)) + ":" + char_cast(localname) : std::string(char_cast(localname));
+    m_structure.m_rootEnd = std::size_t(pos) + 1;
+    m_valid = !isEmpty && ((KEY2Token::NS_URI_KEY | KEY2Token::presentation) == name) && checkVersion(attributeCount, attributes);
+    return;
+  }
+
+  if ((2 == m_depth) && ((KEY2Token::NS_URI_KEY | KEY2Token::slide_list) == name))
+  {
+    // the slides are cut out with the start tag of the root only, so
+    // they must not depend on namespaces declared by the slide list
+    if ((SECTION_BEFORE_SLIDES != m_section) || isEmpty || (0 != namespaceCount))
+    {
+      m_valid = false;
+      return;
+    }
+    m_section = SECTION_SLIDES;
+    m_structure.m_slideListBegin = std::size_t(pos) + 1;
+    return;
+  }
+
+  if (SECTION_SLIDES == m_section)
+  {
+    if (3 == m_depth)
+    {
+      // anything else would be discarded by the slide list context
+      if ((KEY2Token::NS_URI_KEY | KEY2Token::slide) != name)
+      {
+        m_valid = false;
+        return;
+      }
+      KEY2Structure::Slide slide;
+      m_valid = findTagStart(pos, slide.m_begin);
+      slide.m_group = m_structure.m_slides.size();
+      m_structure.m_slides.push_back(slide);
+      // the ID of the slide itself is not entered into the dictionary
+      return;
+    }
+
+    KEY2Structure::Slide &slide = m_structure.m_slides.back();
+    const std::size_t index = m_structure.m_slides.size() - 1;
+    // only the layers of the page are inserted into the slide
+    if ((6 == m_depth) && ((IWORKToken::NS_URI_SF | IWORKToken::layer) == name)
+        && ((KEY2Token::NS_URI_KEY | KEY2Token::page) == m_names[3]) && ((IWORKToken::NS_URI_SF | IWORKToken::layers) == m_names[4]))
+      ++slide.m_layerCount;
+
+    bool isPlaceholderRef = false;
+    switch (name)
+    {
+    case IWORKToken::NS_URI_SF | IWORKToken::body_placeholder_ref :
+    case IWORKToken::NS_URI_SF | IWORKToken::title_placeholder_ref :
+    case KEY2Token::NS_URI_KEY | KEY2Token::body_placeholder_ref :
+    case KEY2Token::NS_URI_KEY | KEY2Token::title_placeholder_ref :
+      isPlaceholderRef = true;
+      break;
+    default:
+      break;
+    }
+
+    for (int i = 0; i < attributeCount; ++i)
+    {
+      const xmlChar *const *const attribute = attributes + 5 * i;
+      const int attrName = m_tokenizer.getQualifiedId(char_cast(attribute[0]), char_cast(attribute[2]));
+      const std::string value(char_cast(attribute[3]), char_cast(attribute[4]));
+      if ((IWORKToken::NS_URI_SFA | IWORKToken::ID) == attrName)
+      {
+        const auto it = m_definitions.insert(std::make_pair(value, index)).first;
+        if (it->second != index)
+        {
+          // redefined: keep the order of the definitions
+          m_links.push_back(std::make_pair(it->second, index));
+          it->second = index;
+        }
+      }
+      else
+      {
+        // styles are referred to by plain attributes too (e.g., sf:style of a paragraph)
+        m_references.push_back(std::make_pair(index, value));
+        if (isPlaceholderRef && ((IWORKToken::NS_URI_SFA | IWORKToken::IDREF) == attrName))
+        {
+          // drawing a placeholder consumes its text, so the slides must be parsed in order
+          const auto it = m_placeholders.insert(std::make_pair(value, index)).first;
+          if (it->second != index)
+            m_links.push_back(std::make_pair(it->second, index));
+        }
+      }
+    }
+  }
+  else if (SECTION_AFTER_SLIDES == m_section)
+  {
+    for (int i = 0; i < attributeCount; ++i)
+    {
+      const xmlChar *const *const attribute = attributes + 5 * i;
+      if ((IWORKToken::NS_URI_SFA | IWORKToken::ID) != m_tokenizer.getQualifiedId(char_cast(attribute[0]), char_cast(attribute[2])))
+        m_laterReferences.push_back(std::string(char_cast(attribute[3]), char_cast(attribute[4])));
+    }
+  }
+}
+
+void Scanner::endElement(const long pos)
+{
+  if (m_valid && (SECTION_SLIDES == m_section))
+  {
+    if ((0 >= pos) || (m_length < std::size_t(pos)) || ('>' != m_data[pos - 1]))
+    {
+      m_valid = false;
+    }
+    else if (3 == m_depth)
+    {
+      m_structure.m_slides.back().m_end = std::size_t(pos);
+    }
+    else if (2 == m_depth)
+    {
+      m_valid = findTagStart(pos - 1, m_structure.m_slideListEnd);
+      m_section = SECTION_AFTER_SLIDES;
+    }
+  }
+  m_names.pop_back();
+  --m_depth;
+}
+
+bool Scanner::checkVersion(const int attributeCount, const xmlChar **const attributes) const
+{
+  for (int i = 0; i < attributeCount; ++i)
+  {
+    const xmlChar *const *const attribute = attributes + 5 * i;
+    if ((KEY2Token::NS_URI_KEY | KEY2Token::version) != m_tokenizer.getQualifiedId(char_cast(attribute[0]), char_cast(attribute[2])))
+      continue;
+    const std::string value(char_cast(attribute[3]), char_cast(attribute[4]));
+    switch (m_tokenizer.getId(value.c_str()))
+    {
+    case KEY2Token::VERSION_STR_3 :
+    case KEY2Token::VERSION_STR_4 :
+    case KEY2Token::VERSION_STR_5 :
+      return true;
+    default:
+      return false;
+    }
+  }
+  return false;
+}
+
+bool Scanner::findTagStart(const long pos, std::size_t &start) const
+{
+  // '<' cannot occur inside of a tag
+  for (long i = pos; i >= 0; --i)
+  {
+    if ('<' == m_data[i])
+    {
+      start = std::size_t(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Scanner::groupSlides()
+{
+  for (const auto &ref : m_laterReferences)
+  {
+    if (m_definitions.find(ref) != m_definitions.end())
+      return false;
+  }
+
+  std::deque<KEY2Structure::Slide> &slides = m_structure.m_slides;
+  std::vector<std::size_t> groups(slides.size());
+  std::iota(groups.begin(), groups.end(), 0);
+
+  // the group of a slide is the first slide of the group
+  const auto findGroup = [&groups](std::size_t slide)
+  {
+    while (groups[slide] != slide)
+      slide = groups[slide] = groups[groups[slide]];
+    return slide;
+  };
+  const auto join = [&groups, &findGroup](const std::size_t slide1, const std::size_t slide2)
+  {
+    const std::size_t group1 = findGroup(slide1);
+    const std::size_t group2 = findGroup(slide2);
+    if (group1 < group2)
+      groups[group2] = group1;
+    else
+      groups[group1] = group2;
+  };
+
+  for (const auto &ref : m_references)
+  {
+    const auto it = m_definitions.find(ref.second);
+    if ((m_definitions.end() != it) && (it->second != ref.first))
+      join(ref.first, it->second);
+  }
+  for (const auto &link : m_links)
+    join(link.first, link.second);
+
+  for (std::size_t i = 0; i < slides.size(); ++i)
+    slides[i].m_group = findGroup(i);
+
+  return true;
+}
+
+}
+
+KEY2Structure::Slide::Slide()
+  : m_begin(0)
+  , m_end(0)
+  , m_group(0)
+  , m_layerCount(0)
+{
+}
+
+KEY2Structure::KEY2Structure()
+  : m_rootName()
+  , m_rootEnd(0)
+  , m_slideListBegin(0)
+  , m_slideListEnd(0)
+  , m_slides()
+{
+}
+
+bool KEY2Structure::scan(const unsigned char *const data, const std::size_t length, const IWORKTokenizer &tokenizer)
+{
+  m_slides.clear();
+  Scanner scanner(data, length, tokenizer, *this);
+  return scanner.scan();
+}
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
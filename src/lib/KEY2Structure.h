@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef KEY2STRUCTURE_H_INCLUDED
+#define KEY2STRUCTURE_H_INCLUDED
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+namespace libetonyek
+{
+
+class IWORKTokenizer;
+
+/** Positions of the slides of a Keynote 2-5 document.
+  *
+  * They are found by a quick SAX pass over the document, which does not
+  * create any contexts. That allows to cut the slides out of the
+  * document and to parse them separately from the rest of it.
+  */
+struct KEY2Structure
+{
+  struct Slide
+  {
+    Slide();
+
+    std::size_t m_begin; //< offset of the start tag
+    std::size_t m_end; //< offset just past the end tag
+    /** Index of the first slide of the group of this slide.
+      *
+      * Slides refer to entities defined in other slides (or share a
+      * placeholder with them). Such slides form a group, which has to
+      * be parsed in order, by one parser.
+      */
+    std::size_t m_group;
+    unsigned m_layerCount; //< number of layers of the page of the slide
+  };
+
+  KEY2Structure();
+
+  /** Scan a document.
+    *
+    * @arg[in] data the document.
+    * @arg[in] length the length of the document.
+    * @arg[in] tokenizer the tokenizer of the Keynote 2-5 parser.
+    * @returns true if the slides can be parsed separately, i.e., if the
+    *   document is a well-formed presentation of version 3 or later,
+    *   has a slide list containing only slides and nothing after the
+    *   slide list refers to an entity defined in a slide.
+    */
+  bool scan(const unsigned char *data, std::size_t length, const IWORKTokenizer &tokenizer);
+
+  std::string m_rootName; //< qualified name of the root element
+  std::size_t m_rootEnd; //< offset just past the start tag of the root element
+  std::size_t m_slideListBegin; //< offset just past the start tag of the slide list
+  std::size_t m_slideListEnd; //< offset of the end tag of the slide list
+  std::deque<Slide> m_slides;
+};
+
+}
+
+#endif // KEY2STRUCTURE_H_INCLUDED
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -9,9 +9,15 @@
 #include "KEY6Parser.h"
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "IWAMessage.h"
 #include "IWAObjectType.h"
@@ -34,12 +40,33 @@ using std::for_each;
 using std::make_shared;
 using std::string;
 
+namespace
+{
+
+/// Get the number of threads to parse @c count slides with.
+unsigned getThreadCount(const std::size_t count)
+{
+  const unsigned cores = std::thread::hardware_concurrency();
+  return unsigned((std::min)(count, std::size_t(cores > 0 ? cores : 1)));
+}
+
+}
+
 KEY6Parser::KEY6Parser(const RVNGInputStreamPtr_t &fragments, const RVNGInputStreamPtr_t &package, KEYCollector &collector)
   : IWAParser(fragments, package, collector)
   , m_collector(collector)
   , m_masterSlides()
   , m_slides()
-  , m_slideStyles()
+  , m_slideStyles(make_shared<StyleMap_t>())
+{
+}
+
+KEY6Parser::KEY6Parser(const KEY6Parser &parent, KEYCollector &collector)
+  : IWAParser(parent, collector)
+  , m_collector(collector)
+  , m_masterSlides(parent.m_masterSlides)
+  , m_slides()
+  , m_slideStyles(parent.m_slideStyles)
 {
 }
 
@@ -69,17 +96,20 @@ bool KEY6Parser::parsePresentation(const unsigned id)
   bool success = true;
   if (get(msg).message(3))
   {
+    deque<unsigned> slideRefs;
     optional<unsigned> slideListRef;
     slideListRef = readRef(get(msg).message(3).get(), 1);
     if (slideListRef)
     {
-      success = parseSlideList(get(slideListRef));
+      success = readSlideList(get(slideListRef), slideRefs);
     }
     else
     {
       const deque<unsigned> &slideListRefs = readRefs(get(get(msg).message(3)), 2);
-      for_each(slideListRefs.begin(), slideListRefs.end(), bind(&KEY6Parser::parseSlideList, this, _1));
+      for (auto it : slideListRefs)
+        readSlideList(it, slideRefs);
     }
+    parseSlides(slideRefs);
   }
   m_collector.endSlides();
 
@@ -88,19 +118,120 @@ bool KEY6Parser::parsePresentation(const unsigned id)
   return success;
 }
 
-bool KEY6Parser::parseSlideList(const unsigned id)
+bool KEY6Parser::readSlideList(const unsigned id, deque<unsigned> &slideRefs)
 {
   const ObjectMessage msg(*this, id, KEY6ObjectType::SlideList);
   if (!msg)
     return false;
 
   const deque<unsigned> &slideListRefs = readRefs(get(msg), 1);
-  for_each(slideListRefs.begin(), slideListRefs.end(), bind(&KEY6Parser::parseSlideList, this, _1));
-  const deque<unsigned> &slideRefs = readRefs(get(msg), 2);
-  for_each(slideRefs.begin(), slideRefs.end(), bind(&KEY6Parser::parseSlide, this, _1, false));
+  for (auto it : slideListRefs)
+    readSlideList(it, slideRefs);
+  const deque<unsigned> &refs = readRefs(get(msg), 2);
+  slideRefs.insert(slideRefs.end(), refs.begin(), refs.end());
   return true;
 }
 
+void KEY6Parser::parseSlides(const deque<unsigned> &slideRefs)
+{
+  // slides outside of the requested range (and their masters) are never looked up
+  deque<unsigned> slideIds;
+  for (deque<unsigned>::size_type i = 0; i < slideRefs.size(); ++i)
+  {
+    if (m_collector.isSlideInRange(unsigned(i)))
+      slideIds.push_back(slideRefs[i]);
+  }
+
+  // the master slides are shared, so parse them before the slides
+  for (auto id : slideIds)
+  {
+    const ObjectMessage msg(*this, id, KEY6ObjectType::Slide);
+    if (msg)
+    {
+      const optional<unsigned> &masterRef = readRef(get(msg), 17);
+      if (masterRef)
+        queryMasterSlide(get(masterRef));
+    }
+  }
+
+  const unsigned threadCount = getThreadCount(slideIds.size());
+  if (threadCount <= 1)
+  {
+    for (auto id : slideIds)
+      parseSlide(id, false);
+    return;
+  }
+
+  std::vector<KEYSlidePtr_t> slides(slideIds.size());
+  std::atomic<std::size_t> next(0);
+  // every slide has a single layer
+  const int layerCount = m_collector.getLayerCount();
+  std::mutex errorMutex;
+  std::exception_ptr error;
+
+  // every thread takes the next slide until there are none left
+  const auto parseSomeSlides = [&]()
+  {
+    try
+    {
+      // the slides are sent to the document by the main collector
+      KEYCollector collector(nullptr);
+      KEY6Parser parser(*this, collector);
+      collector.startSlides();
+      for (std::size_t i = next++; i < slides.size(); i = next++)
+      {
+        collector.setLayerCount(layerCount + int(i));
+        slides[i] = parser.parseSlide(slideIds[i], false);
+      }
+      collector.endSlides();
+    }
+    catch (...)
+    {
+      const std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error)
+        error = std::current_exception();
+      next = slides.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+  {
+    try
+    {
+      threads.emplace_back(parseSomeSlides);
+    }
+    catch (const std::system_error &)
+    {
+      ETONYEK_DEBUG_MSG(("KEY6Parser::parseSlides: cannot start more than %u threads\n", i));
+      break;
+    }
+  }
+  parseSomeSlides();
+  for (auto &thread : threads)
+    thread.join();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  m_collector.setLayerCount(layerCount + int(slides.size()));
+  for (const auto &slide : slides)
+  {
+    if (slide)
+      m_slides.push_back(slide);
+  }
+}
+
+const KEYSlidePtr_t KEY6Parser::queryMasterSlide(const unsigned id)
+{
+  const auto it = m_masterSlides.find(id);
+  if (it != m_masterSlides.end())
+    return it->second;
+  const KEYSlidePtr_t slide = parseSlide(id, true);
+  m_masterSlides[id] = slide;
+  return slide;
+}
+
 KEYSlidePtr_t KEY6Parser::parseSlide(const unsigned id, const bool master)
 {
   const ObjectMessage msg(*this, id, KEY6ObjectType::Slide);
@@ -109,12 +240,7 @@ KEYSlidePtr_t KEY6Parser::parseSlide(const unsigned id, const bool master)
   const optional<unsigned> &masterRef = readRef(get(msg), 17);
   KEYSlidePtr_t masterSlide;
   if (!master && masterRef)
-  {
-    if (m_masterSlides.find(get(masterRef))!=m_masterSlides.end())
-      masterSlide=m_masterSlides.find(get(masterRef))->second;
-    else
-      masterSlide=parseSlide(get(masterRef), true);
-  }
+    masterSlide = queryMasterSlide(get(masterRef));
 
   m_collector.startPage();
   m_collector.startLayer();
@@ -153,8 +279,6 @@ KEYSlidePtr_t KEY6Parser::parseSlide(const unsigned id, const bool master)
     slide->m_masterSlide=masterSlide;
     if (!master)
       m_slides.push_back(slide);
-    else
-      m_masterSlides[id]=slide;
   }
   return slide;
 }
@@ -270,7 +394,7 @@ bool KEY6Parser::parseStickyNote(const IWAMessage &msg)
 
 const IWORKStylePtr_t KEY6Parser::querySlideStyle(const unsigned id) const
 {
-  return queryStyle(id, m_slideStyles, bind(&KEY6Parser::parseSlideStyle, const_cast<KEY6Parser *>(this), _1, _2));
+  return queryStyle(id, *m_slideStyles, bind(&KEY6Parser::parseSlideStyle, const_cast<KEY6Parser *>(this), _1, _2));
 }
 
 void KEY6Parser::parseSlideStyle(const unsigned id, IWORKStylePtr_t &style)
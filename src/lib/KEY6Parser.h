@@ -25,11 +25,29 @@ public:
   KEY6Parser(const RVNGInputStreamPtr_t &fragments, const RVNGInputStreamPtr_t &package, KEYCollector &collector);
 
 private:
+  /** Create a parser for the slides of the presentation parsed by @c parent.
+    *
+    * The parser shares the object index and the styles with @c parent
+    * and gets a copy of the already parsed master slides.
+    */
+  KEY6Parser(const KEY6Parser &parent, KEYCollector &collector);
+
   bool parseDocument() override;
 
   bool parsePresentation(unsigned id);
-  bool parseSlideList(unsigned id);
+  /** Append the slides of a (possibly nested) slide list to @c slideRefs.
+    *
+    * Slides are added in presentation order.
+    */
+  bool readSlideList(unsigned id, std::deque<unsigned> &slideRefs);
+  /** Parse the slides in range.
+    *
+    * The slides are parsed concurrently, each into its own output,
+    * and added to the presentation in order.
+    */
+  void parseSlides(const std::deque<unsigned> &slideRefs);
   KEYSlidePtr_t parseSlide(unsigned id, bool master);
+  const KEYSlidePtr_t queryMasterSlide(unsigned id);
   bool parsePlaceholder(unsigned id);
   void parseNotes(unsigned id);
 
@@ -42,9 +60,11 @@ private:
 private:
   KEYCollector &m_collector;
 
+  /// Parsed master slides. A failed master is stored as an empty pointer.
   mutable std::unordered_map<unsigned, KEYSlidePtr_t> m_masterSlides;
   mutable std::deque<KEYSlidePtr_t> m_slides;
-  mutable StyleMap_t m_slideStyles;
+  /// Shared with the slide parsers, guarded by the lock of the style cache.
+  const std::shared_ptr<StyleMap_t> m_slideStyles;
 };
 
 }
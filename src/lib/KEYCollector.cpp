@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <set>
 
@@ -42,6 +43,8 @@ KEYCollector::KEYCollector(IWORKDocumentInterface *const document)
   , m_pageOpened(false)
   , m_layerOpened(false)
   , m_layerCount(0)
+  , m_firstSlide(0)
+  , m_slideCount(std::numeric_limits<unsigned>::max())
 {
   assert(!m_inSlides);
 }
@@ -353,6 +356,27 @@ void KEYCollector::endLayer()
   m_layerOpened = false;
 }
 
+void KEYCollector::setSlideRange(const unsigned first, const unsigned count)
+{
+  m_firstSlide = first;
+  m_slideCount = count;
+}
+
+bool KEYCollector::isSlideInRange(const unsigned index) const
+{
+  return (index >= m_firstSlide) && (index - m_firstSlide < m_slideCount);
+}
+
+void KEYCollector::setLayerCount(const int count)
+{
+  m_layerCount = count;
+}
+
+int KEYCollector::getLayerCount() const
+{
+  return m_layerCount;
+}
+
 void KEYCollector::drawTable()
 {
   assert(bool(m_currentTable));
@@ -60,6 +60,23 @@ public:
   void startLayer();
   void endLayer();
 
+  /** Restrict the output to @c count slides starting at @c first.
+    *
+    * Slides are counted from 0, in presentation order (master slides do
+    * not count). Parsers should skip slides outside of the range
+    * without looking at their content.
+    */
+  void setSlideRange(unsigned first, unsigned count);
+  bool isSlideInRange(unsigned index) const;
+
+  /** Continue the numbering of layers of another collector.
+    *
+    * This keeps the layer ids unique if the slides are collected by
+    * several collectors.
+    */
+  void setLayerCount(int count);
+  int getLayerCount() const;
+
 protected:
   bool m_inSlides;
 
@@ -84,6 +101,9 @@ private:
   bool m_pageOpened;
   bool m_layerOpened;
   int m_layerCount;
+
+  unsigned m_firstSlide;
+  unsigned m_slideCount;
 };
 
 } // namespace libetonyek
@@ -86,7 +86,8 @@ bool NUM3Parser::parseDocument()
   const ObjectMessage msg(*this, 1, NUM3ObjectType::Document);
   if (!msg) return false;
 
-  m_collector.startDocument();
+  // there are no metadata in this format, so the sheets can be written as soon as they are finished
+  m_collector.startDocument(true);
   auto info=get(msg).message(8);
   if (info)
   {
@@ -9,6 +9,8 @@
 
 #include "NUMCollector.h"
 
+#include <functional>
+
 #include "IWORKDocumentInterface.h"
 #include "IWORKLanguageManager.h"
 #include "IWORKProperties.h"
@@ -27,7 +29,7 @@ NUMCollector::NUMCollector(IWORKDocumentInterface *const document)
 {
 }
 
-void NUMCollector::startDocument()
+void NUMCollector::startDocument(const bool directOutput)
 {
   librevenge::RVNGPropertyList calcSettings;
   calcSettings.insert("librevenge:type","table:calculation-settings");
@@ -37,16 +39,26 @@ void NUMCollector::startDocument()
   librevenge::RVNGPropertyList props;
   props.insert("librevenge:childs", pVect);
   IWORKCollector::startDocument(props);
+  if (directOutput && m_document)
+    getOutputManager().getCurrent() = IWORKOutputElements(m_document, std::bind(&NUMCollector::writeMetadata, this));
 }
 
 void NUMCollector::endDocument()
+{
+  IWORKOutputElements &elements = getOutputManager().getCurrent();
+  // in direct mode, the metadata have been written before the first sheet
+  if (!elements.isDirect() || elements.empty())
+    writeMetadata();
+  elements.write(m_document);
+
+  IWORKCollector::endDocument();
+}
+
+void NUMCollector::writeMetadata()
 {
   librevenge::RVNGPropertyList metadata;
   fillMetadata(metadata);
   m_document->setDocumentMetaData(metadata);
-  getOutputManager().getCurrent().write(m_document);
-
-  IWORKCollector::endDocument();
 }
 
 void NUMCollector::startWorkSpace(boost::optional<std::string> const &name)
@@ -124,6 +136,8 @@ void NUMCollector::endWorkSpace(IWORKTableNameMapPtr_t tableNameMap)
     getOutputManager().getCurrent().append(tableElements);
   }
   m_tableElementLists.clear();
+  // the formulas of the next sheets are unlikely to be the same
+  getOutputManager().getCurrent().clearFormulaCache();
   m_workSpaceOpened = false;
   m_workSpaceName = boost::none;
   m_workSpaceCreateGraphic = false;
@@ -25,7 +25,13 @@ public:
   // collector functions
 
   // helper functions
-  void startDocument();
+  /** Start the document.
+    *
+    * If @c directOutput is set, each sheet is passed to the document as
+    * soon as it is finished. That must only be used if no metadata are
+    * going to be collected, because they have to be written first.
+    */
+  void startDocument(bool directOutput = false);
   void endDocument();
 
   void startWorkSpace(boost::optional<std::string> const &name);
@@ -37,6 +43,8 @@ public:
 
   void collectStickyNote() final;
 private:
+  void writeMetadata();
+
   void drawTable() final;
   void drawMedia(double x, double y, const librevenge::RVNGPropertyList &data) final;
   void fillShapeProperties(librevenge::RVNGPropertyList &props) final;
@@ -643,6 +643,7 @@ private:
   optional<int> m_page;
   optional<int> m_rpage;
   bool m_opened;
+  bool m_skipped;
 };
 
 PageGroupElement::PageGroupElement(PAG1ParserState &state)
@@ -650,6 +651,7 @@ PageGroupElement::PageGroupElement(PAG1ParserState &state)
   , m_page()
   , m_rpage()
   , m_opened(false)
+  , m_skipped(false)
 {
 }
 
@@ -673,6 +675,8 @@ IWORKXMLContextPtr_t PageGroupElement::element(const int name)
 {
   if (!m_opened)
     open();
+  if (m_skipped)
+    return IWORKXMLContextPtr_t();
 
   switch (name)
   {
@@ -699,7 +703,7 @@ void PageGroupElement::endOfElement()
 {
   if (isCollector())
   {
-    if (!m_opened || !m_page) // ignore empty group
+    if (!m_opened || !m_page || m_skipped) // ignore empty group
       return;
     getCollector().closePageGroup();
   }
@@ -711,7 +715,10 @@ void PageGroupElement::open()
   {
     if (!m_page && m_rpage)
       m_page = get(m_rpage) + 1;
-    if (m_page)
+    // the objects of skipped pages are not parsed at all
+    if (m_page && !getCollector().isPageInRange(get(m_page)))
+      m_skipped = true;
+    else if (m_page)
       getCollector().openPageGroup(m_page);
   }
   m_opened = true;
@@ -52,7 +52,11 @@ bool PAG5Parser::parseGroupRef(unsigned id)
       ETONYEK_DEBUG_MSG(("PAG5Parser::parseGroupRef: can not find a page\n"));
       continue;
     }
-    m_collector.openPageGroup(int(get(pIt.uint32(1)))+1);
+    const int page = int(get(pIt.uint32(1))) + 1;
+    // the objects of skipped pages are never looked up
+    if (!m_collector.isPageInRange(page))
+      continue;
+    m_collector.openPageGroup(page);
     std::deque<unsigned> shapeRefs;
     const std::deque<IWAMessage> &objs = pIt.message(4).repeated();
     for (const auto &obj : objs)
@@ -152,16 +156,22 @@ bool PAG5Parser::parseDocument()
     {
       m_currentText = m_collector.createText(m_langManager);
       bool opened=false;
+      unsigned sections=0;
       parseText(get(textRef), m_collector.getFootnoteKind() == PAG_FOOTNOTE_KIND_FOOTNOTE,
-                [this,&opened](unsigned pos, IWORKStylePtr_t style)
+                [this,&opened,&sections](unsigned pos, IWORKStylePtr_t style)
       {
+        // the text after the last needed section is skipped
+        if (!m_collector.isSectionInRange(sections))
+          return false;
+        ++sections;
         if (pos && opened)
         {
           m_collector.collectText(m_currentText);
           m_collector.closeSection();
         }
-        m_collector.openSection(style);
+        m_collector.openSection(style, m_currentText);
         opened=true;
+        return true;
       });
       m_collector.collectText(m_currentText);
       m_currentText.reset();
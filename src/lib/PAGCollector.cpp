@@ -10,6 +10,8 @@
 #include "PAGCollector.h"
 
 #include <cassert>
+#include <functional>
+#include <limits>
 #include <memory>
 
 #include "IWORKDocumentInterface.h"
@@ -95,9 +97,12 @@ PAGCollector::PAGCollector(IWORKDocumentInterface *const document)
   , m_pageDimensions()
   , m_currentSectionStyle()
   , m_firstPageSpan(true)
+  , m_pageSpanOpened(false)
   , m_pubInfo()
   , m_pageGroups()
   , m_page(0)
+  , m_firstPage(0)
+  , m_pageCount(std::numeric_limits<unsigned>::max())
   , m_attachmentPosition()
   , m_annotations()
 {
@@ -172,9 +177,11 @@ void PAGCollector::openSection(const std::string &style)
   }
 }
 
-void PAGCollector::openSection(const IWORKStylePtr_t &style)
+void PAGCollector::openSection(const IWORKStylePtr_t &style, const IWORKTextPtr_t &text)
 {
   m_currentSectionStyle=style;
+  if (bool(text) && m_document)
+    text->setDirectOutput(m_document, std::bind(&PAGCollector::openPageSpan, this));
 }
 
 void PAGCollector::closeSection()
@@ -362,8 +369,11 @@ void PAGCollector::drawTextBox(const IWORKTextPtr_t &text, const glm::dmat3 &tra
   elements.addCloseFrame();
 }
 
-void PAGCollector::flushPageSpan(const bool writeEmpty)
+void PAGCollector::openPageSpan()
 {
+  if (m_pageSpanOpened)
+    return;
+
   if (m_firstPageSpan)
   {
     RVNGPropertyList metadata;
@@ -393,7 +403,7 @@ void PAGCollector::flushPageSpan(const bool writeEmpty)
         props.insert("style:print-orientation", "landscape");
         break;
       default:
-        ETONYEK_DEBUG_MSG(("PAGCollector::flushPageSpan: unexpected orientation\n"));
+        ETONYEK_DEBUG_MSG(("PAGCollector::openPageSpan: unexpected orientation\n"));
         break;
       }
     }
@@ -415,10 +425,23 @@ void PAGCollector::flushPageSpan(const bool writeEmpty)
       props.insert("fo:background-color", fillProps["draw:fill-color"]->clone());
     else
     {
-      ETONYEK_DEBUG_MSG(("PAGCollector::flushPageSpan: unimplemented background\n"));
+      ETONYEK_DEBUG_MSG(("PAGCollector::openPageSpan: unimplemented background\n"));
     }
   }
 
+  m_document->openPageSpan(props);
+  if (m_currentSectionStyle)
+  {
+    writeHeadersFooters(m_document, m_currentSectionStyle, m_headers, pickHeader,
+                        &IWORKDocumentInterface::openHeader, &IWORKDocumentInterface::closeHeader);
+    writeHeadersFooters(m_document, m_currentSectionStyle, m_footers, pickFooter,
+                        &IWORKDocumentInterface::openFooter, &IWORKDocumentInterface::closeFooter);
+  }
+  m_pageSpanOpened = true;
+}
+
+void PAGCollector::flushPageSpan(const bool writeEmpty)
+{
   IWORKOutputElements text;
   if (bool(m_currentText))
   {
@@ -426,25 +449,25 @@ void PAGCollector::flushPageSpan(const bool writeEmpty)
     m_currentText.reset();
   }
 
-  if (!text.empty() || writeEmpty)
+  // the page span is already open if the text has been passed directly
+  if (!m_pageSpanOpened)
   {
-    m_document->openPageSpan(props);
-    if (m_currentSectionStyle)
+    if (text.empty() && !writeEmpty)
     {
-      writeHeadersFooters(m_document, m_currentSectionStyle, m_headers, pickHeader,
-                          &IWORKDocumentInterface::openHeader, &IWORKDocumentInterface::closeHeader);
-      writeHeadersFooters(m_document, m_currentSectionStyle, m_footers, pickFooter,
-                          &IWORKDocumentInterface::openFooter, &IWORKDocumentInterface::closeFooter);
+      m_currentSectionStyle.reset();
+      return;
     }
+    openPageSpan();
     if (text.empty())
     {
       // let force an empty paragraph to be inserted
       text.addOpenParagraph(librevenge::RVNGPropertyList());
       text.addCloseParagraph();
     }
-    text.write(m_document);
-    m_document->closePageSpan();
   }
+  text.write(m_document);
+  m_document->closePageSpan();
+  m_pageSpanOpened = false;
 
   m_currentSectionStyle.reset();
 }
@@ -460,6 +483,25 @@ PAGFootnoteKind PAGCollector::getFootnoteKind() const
   return m_pubInfo.m_footnoteKind;
 }
 
+void PAGCollector::setPageRange(const unsigned first, const unsigned count)
+{
+  m_firstPage = first;
+  m_pageCount = count;
+}
+
+bool PAGCollector::isPageInRange(const int page) const
+{
+  if (page < 1) // not a valid page: keep it, as without a range
+    return true;
+  const unsigned index = unsigned(page - 1);
+  return (index >= m_firstPage) && (index - m_firstPage < m_pageCount);
+}
+
+bool PAGCollector::isSectionInRange(const unsigned index) const
+{
+  return (index < m_firstPage) || (index - m_firstPage < m_pageCount);
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -46,13 +46,37 @@ public:
   void setPageDimensions(const IWORKPrintInfo &dimensions);
 
   void openSection(const std::string &style); // probably better to look for the style in the calling function
-  void openSection(const IWORKStylePtr_t &style);
+  /** Open a section with style @c style.
+    *
+    * If @c text is set, its content is passed directly to the document
+    * as it is being collected, instead of being buffered until the
+    * section is closed. The page span is opened just before the first
+    * content is passed.
+    */
+  void openSection(const IWORKStylePtr_t &style, const IWORKTextPtr_t &text = IWORKTextPtr_t());
   void closeSection();
 
   void sendAnnotation(const std::string &name);
 
   PAGFootnoteKind getFootnoteKind() const;
 
+  /** Restrict the output to @c count pages starting at @c first.
+    *
+    * Pages are counted from 0. Parsers should skip page groups and body
+    * text sections outside of the range without looking at their
+    * content.
+    */
+  void setPageRange(unsigned first, unsigned count);
+  /// Check if the page group of page @c page (counted from 1) is in the range.
+  bool isPageInRange(int page) const;
+  /** Check if the body text section @c index (counted from 0) is needed.
+    *
+    * Every section starts on a new page, so a section can only reach
+    * into the range if it is one of the first @c first + @c count
+    * sections.
+    */
+  bool isSectionInRange(unsigned index) const;
+
 private:
   void drawTable() override;
   void drawMedia(double x, double y, const librevenge::RVNGPropertyList &data) override;
@@ -63,6 +87,7 @@ private:
   }
   void drawTextBox(const IWORKTextPtr_t &text, const glm::dmat3 &trafo, const IWORKGeometryPtr_t &boundingBox, const librevenge::RVNGPropertyList &style) override;
 
+  void openPageSpan();
   void flushPageSpan(bool writeEmpty = true);
   void writePageGroupsObjects();
 
@@ -70,12 +95,16 @@ private:
   boost::optional<IWORKPrintInfo> m_pageDimensions;
   IWORKStylePtr_t m_currentSectionStyle;
   bool m_firstPageSpan;
+  bool m_pageSpanOpened;
 
   PAGPublicationInfo m_pubInfo;
 
   PageGroupsMap_t m_pageGroups;
   int m_page;
 
+  unsigned m_firstPage;
+  unsigned m_pageCount;
+
   // FIXME: This is a clumsy workaround.
   boost::optional<IWORKPosition> m_attachmentPosition;
   PAGAnnotationMap_t m_annotations;
@@ -9,6 +9,8 @@
 
 #include "IWORKColorElement.h"
 
+#include <atomic>
+
 #include <boost/lexical_cast.hpp>
 
 #include "IWORKCollector.h"
@@ -90,11 +92,10 @@ IWORKXMLContextPtr_t IWORKColorElement::element(int name)
   {
   case IWORKToken::custom_space_color | IWORKToken::NS_URI_SFA :
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
       ETONYEK_DEBUG_MSG(("IWORKColorElement::element: found a custom color element\n"));
-      first=false;
     }
     return IWORKXMLContextPtr_t();
   }
@@ -9,6 +9,8 @@
 
 #include "IWORKFormulaElement.h"
 
+#include <atomic>
+
 #include "libetonyek_xml.h"
 #include "IWORKDictionary.h"
 #include "IWORKFormula.h"
@@ -39,11 +41,10 @@ FmElement::FmElement(IWORKXMLParserState &state)
 IWORKXMLContextPtr_t FmElement::element(int /*name*/)
 {
   // TODO: sfa:pair as child
-  static bool first=true;
-  if (first)
+  static std::atomic<bool> first(true);
+  if (first.exchange(false))
   {
     ETONYEK_DEBUG_MSG(("FmElement::element: found some elements, ignored\n"));
-    first=false;
   }
 
   return IWORKXMLContextPtr_t();
@@ -199,7 +200,7 @@ void IWORKFoElement::endOfElement()
   if (!m_formula) return;
 
   IWORKFormulaPtr_t formula(new IWORKFormula(m_hc));
-  if (!formula->parse(get(m_formula)))
+  if (!formula->parse(get(m_formula), &getState().m_formulaCache))
     return;
   getState().m_tableData->m_formula = formula;
   getState().m_tableData->m_formulaHC = m_hc;
@@ -311,7 +312,7 @@ void IWORKFormulaElement::endOfElement()
   if (!m_formula) return;
 
   IWORKFormulaPtr_t formula(new IWORKFormula(getState().m_tableData->m_formulaHC));
-  if (!formula->parse(get(m_formula)))
+  if (!formula->parse(get(m_formula), &getState().m_formulaCache))
     return;
   getState().m_tableData->m_formula = formula;
   if (getId())
@@ -367,7 +368,7 @@ void IWORKTableCellFormulaElement::endOfElement()
   if (!m_formula) return;
 
   IWORKFormulaPtr_t formula(new IWORKFormula(getState().m_tableData->m_formulaHC));
-  if (!formula->parse(get(m_formula)))
+  if (!formula->parse(get(m_formula), &getState().m_formulaCache))
     return;
   getState().m_tableData->m_formula = formula;
   if (getId())
@@ -9,6 +9,7 @@
 
 #include "IWORKImageElement.h"
 
+#include <atomic>
 #include <memory>
 
 #include "libetonyek_xml.h"
@@ -103,11 +104,10 @@ IWORKXMLContextPtr_t IWORKImageElement::element(const int name)
     return std::make_shared<IWORKGeometryElement>(getState());
   case IWORKToken::NS_URI_SF | IWORKToken::masking_shape_path_source :
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
       ETONYEK_DEBUG_MSG(("IWORKImageElement::element: find some masking shape's paths\n"));
-      first=false;
     }
     break;
   }
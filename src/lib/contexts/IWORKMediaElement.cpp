@@ -10,6 +10,7 @@
 #include "IWORKMediaElement.h"
 
 #include <boost/optional.hpp>
+#include <atomic>
 #include <memory>
 
 #include "libetonyek_xml.h"
@@ -372,11 +373,10 @@ IWORKXMLContextPtr_t IWORKMediaElement::element(const int name)
     return std::make_shared<IWORKGeometryElement>(getState());
   case IWORKToken::NS_URI_SF | IWORKToken::masking_shape_path_source :
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
       ETONYEK_DEBUG_MSG(("IWORKMediaElement::element: find some masking shape's paths\n"));
-      first=false;
     }
     break;
   }
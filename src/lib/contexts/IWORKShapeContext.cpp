@@ -9,6 +9,7 @@
 
 #include "IWORKShapeContext.h"
 
+#include <atomic>
 #include <cassert>
 
 #include <boost/optional.hpp>
@@ -57,10 +58,9 @@ void IWORKShapeContext::attribute(const int name, const char *const value)
   default :
   {
     // find also can-autosize-h, can-autosize-v, key:inheritance, key:tag
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
-      first=false;
       ETONYEK_DEBUG_MSG(("IWORKShapeContext::attribute: find some unknown attributes\n"));
     }
     IWORKXMLElementContextBase::attribute(name, value);
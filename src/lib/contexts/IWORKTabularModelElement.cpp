@@ -9,6 +9,7 @@
 
 #include "IWORKTabularModelElement.h"
 
+#include <atomic>
 #include <cassert>
 #include <ctime>
 #include <memory>
@@ -421,11 +422,10 @@ IWORKXMLContextPtr_t GridColumnElement::element(const int name)
   {
   case IWORKToken::grouping_display | IWORKToken::NS_URI_SF :
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
       ETONYEK_DEBUG_MSG(("GridColumnElement::element: find some grouping-display\n"));
-      first=false;
     }
     return IWORKXMLContextPtr_t();
   }
@@ -892,10 +892,9 @@ IWORKXMLContextPtr_t GroupingElement::element(int name)
   {
   case IWORKToken::groupings_element | IWORKToken::NS_URI_SF :
   {
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
-      first=false;
       ETONYEK_DEBUG_MSG(("GroupingElement::element: oops, find some grouping elements\n"));
     }
     return IWORKXMLContextPtr_t();
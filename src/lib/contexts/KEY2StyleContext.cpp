@@ -9,6 +9,7 @@
 
 #include "KEY2StyleContext.h"
 
+#include <atomic>
 #include <string>
 
 #include <boost/optional.hpp>
@@ -88,10 +89,9 @@ void TransitionAttributesElement::attribute(int name, const char *value)
     {
       get(m_transition).m_type=KEY_TRANSITION_STYLE_TYPE_NAMED;
       get(m_transition).m_name=value;
-      static bool first=true;
-      if (first)
+      static std::atomic<bool> first(true);
+      if (first.exchange(false))
       {
-        first=false;
         ETONYEK_DEBUG_MSG(("TransitionAttributesElement::attribute[KEY2StyleContext.cpp]: find some unexpected type=%s\n", value));
       }
     }
@@ -130,10 +130,9 @@ IWORKXMLContextPtr_t TransitionAttributesElement::element(const int name)
        <key:com.apple.iWork.Keynote.KLNSparkle.color>
        <key:com.apple.iWork.Keynote.KLNSwap.angle>
        <key:com.apple.iWork.Keynote.KLNSwap.spacing*/
-    static bool first=true;
-    if (first)
+    static std::atomic<bool> first(true);
+    if (first.exchange(false))
     {
-      first=false;
       ETONYEK_DEBUG_MSG(("TransitionAttributesElement::element[KEY2StyleContext.cpp]: found some unexpected element\n"));
     }
     break;
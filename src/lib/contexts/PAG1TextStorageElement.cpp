@@ -790,11 +790,13 @@ private:
 
 private:
   ContainerFrame m_containerFrame;
+  unsigned m_sections;
 };
 
 TextBodyElement::TextBodyElement(PAG1ParserState &state)
   : PAG1XMLContextBase<IWORKTextBodyElement>(state)
   , m_containerFrame()
+  , m_sections(0)
 {
 }
 
@@ -807,6 +809,9 @@ IWORKXMLContextPtr_t TextBodyElement::element(const int name)
   case IWORKToken::NS_URI_SF | IWORKToken::p : // for footnotes
     return std::make_shared<PElement>(getState());
   case IWORKToken::NS_URI_SF | IWORKToken::section :
+    // the sections after the last needed one are not parsed at all
+    if (isCollector() && !getCollector().isSectionInRange(m_sections++))
+      return IWORKXMLContextPtr_t();
     return std::make_shared<SectionElement>(getState());
   default:
     break;
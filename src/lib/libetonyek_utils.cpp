@@ -9,6 +9,7 @@
 
 #include "libetonyek_utils.h"
 
+#include <atomic>
 #include <cmath>
 #include <cstdarg>
 #include <cstdint>
@@ -17,6 +18,9 @@
 #include <limits>
 #include <stdexcept>
 
+#include <boost/spirit/include/qi_numeric.hpp>
+#include <boost/spirit/include/qi_parse.hpp>
+
 #include "IWORKTypes.h"
 
 namespace libetonyek
@@ -250,6 +254,16 @@ double rad2deg(double value)
   return value / etonyek_pi * 180;
 }
 
+bool parseDouble(const char *&pos, const char *const end, double &value)
+{
+  // qi::double_ can move the iterator even if it fails
+  const char *p = pos;
+  if (!boost::spirit::qi::parse(p, end, boost::spirit::qi::double_, value))
+    return false;
+  pos = p;
+  return true;
+}
+
 librevenge::RVNGString makeColor(const IWORKColor &color)
 {
   // TODO: alpha
@@ -371,11 +385,10 @@ try
     return std::string("image/bmp");
 
   // FIXME: add code to detect apple pict file, ie. MathType can generate some
-  static bool first=true;
-  if (first)
+  static std::atomic<bool> first(true);
+  if (first.exchange(false))
   {
     ETONYEK_DEBUG_MSG(("detectMimetype[libetonyek_util.cpp]: can not detect some stream types\n"));
-    first=false;
   }
   return std::string();
 }
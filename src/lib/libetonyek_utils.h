@@ -137,6 +137,18 @@ double deg2rad(double value);
   */
 double rad2deg(double value);
 
+/** Parse a floating point number at the start of [pos, end).
+  *
+  * This is boost::spirit::qi::double_, without the overhead of a grammar
+  * or a skipper.
+  *
+  * @arg[in,out] pos the start of the number; moved past it on success
+  * @arg[in] end the end of the input
+  * @arg[out] value the number
+  * @returns true if a number has been parsed
+  */
+bool parseDouble(const char *&pos, const char *end, double &value);
+
 librevenge::RVNGString makeColor(const IWORKColor &color);
 /** Compute the average color of a gradient and return it as a string.
    */
@@ -7,6 +7,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <limits>
 #include <string>
 
 #include <cppunit/TestFixture.h>
@@ -14,6 +15,7 @@
 
 #include <libetonyek/libetonyek.h>
 
+#include <librevenge/librevenge.h>
 #include <librevenge-stream/librevenge-stream.h>
 
 #if !defined ETONYEK_DETECTION_TEST_DIR
@@ -61,6 +63,113 @@ void assertUnsupportedPackage(const string &name)
   assertDetection<librevenge::RVNGDirectoryStream>(name, EtonyekDocument::CONFIDENCE_NONE);
 }
 
+/// Records the text and the page spans of a text document.
+class TextRecorder : public librevenge::RVNGTextInterface
+{
+public:
+  TextRecorder();
+
+  const string &get() const;
+
+  void setDocumentMetaData(const librevenge::RVNGPropertyList &) {}
+  void defineEmbeddedFont(const librevenge::RVNGPropertyList &) {}
+  void startDocument(const librevenge::RVNGPropertyList &) {}
+  void endDocument() {}
+  void definePageStyle(const librevenge::RVNGPropertyList &) {}
+  void openPageSpan(const librevenge::RVNGPropertyList &);
+  void closePageSpan();
+  void openHeader(const librevenge::RVNGPropertyList &) {}
+  void closeHeader() {}
+  void openFooter(const librevenge::RVNGPropertyList &) {}
+  void closeFooter() {}
+  void defineParagraphStyle(const librevenge::RVNGPropertyList &) {}
+  void openParagraph(const librevenge::RVNGPropertyList &) {}
+  void closeParagraph() {}
+  void defineCharacterStyle(const librevenge::RVNGPropertyList &) {}
+  void openSpan(const librevenge::RVNGPropertyList &) {}
+  void closeSpan() {}
+  void openLink(const librevenge::RVNGPropertyList &) {}
+  void closeLink() {}
+  void defineSectionStyle(const librevenge::RVNGPropertyList &) {}
+  void openSection(const librevenge::RVNGPropertyList &) {}
+  void closeSection() {}
+  void insertTab() {}
+  void insertSpace() {}
+  void insertText(const librevenge::RVNGString &text);
+  void insertLineBreak() {}
+  void insertField(const librevenge::RVNGPropertyList &) {}
+  void openOrderedListLevel(const librevenge::RVNGPropertyList &) {}
+  void openUnorderedListLevel(const librevenge::RVNGPropertyList &) {}
+  void closeOrderedListLevel() {}
+  void closeUnorderedListLevel() {}
+  void openListElement(const librevenge::RVNGPropertyList &) {}
+  void closeListElement() {}
+  void openFootnote(const librevenge::RVNGPropertyList &) {}
+  void closeFootnote() {}
+  void openEndnote(const librevenge::RVNGPropertyList &) {}
+  void closeEndnote() {}
+  void openComment(const librevenge::RVNGPropertyList &) {}
+  void closeComment() {}
+  void openTextBox(const librevenge::RVNGPropertyList &) {}
+  void closeTextBox() {}
+  void openTable(const librevenge::RVNGPropertyList &) {}
+  void openTableRow(const librevenge::RVNGPropertyList &) {}
+  void closeTableRow() {}
+  void openTableCell(const librevenge::RVNGPropertyList &) {}
+  void closeTableCell() {}
+  void insertCoveredTableCell(const librevenge::RVNGPropertyList &) {}
+  void closeTable() {}
+  void openFrame(const librevenge::RVNGPropertyList &) {}
+  void closeFrame() {}
+  void insertBinaryObject(const librevenge::RVNGPropertyList &) {}
+  void insertEquation(const librevenge::RVNGPropertyList &) {}
+  void openGroup(const librevenge::RVNGPropertyList &) {}
+  void closeGroup() {}
+  void defineGraphicStyle(const librevenge::RVNGPropertyList &) {}
+  void drawRectangle(const librevenge::RVNGPropertyList &) {}
+  void drawEllipse(const librevenge::RVNGPropertyList &) {}
+  void drawPolygon(const librevenge::RVNGPropertyList &) {}
+  void drawPolyline(const librevenge::RVNGPropertyList &) {}
+  void drawPath(const librevenge::RVNGPropertyList &) {}
+  void drawConnector(const librevenge::RVNGPropertyList &) {}
+
+private:
+  string m_record;
+};
+
+TextRecorder::TextRecorder()
+  : m_record()
+{
+}
+
+const string &TextRecorder::get() const
+{
+  return m_record;
+}
+
+void TextRecorder::openPageSpan(const librevenge::RVNGPropertyList &)
+{
+  m_record += "[";
+}
+
+void TextRecorder::closePageSpan()
+{
+  m_record += "]";
+}
+
+void TextRecorder::insertText(const librevenge::RVNGString &text)
+{
+  m_record += text.cstr();
+}
+
+string parsePages(const string &name, const unsigned firstPage, const unsigned pageCount)
+{
+  librevenge::RVNGFileStream input((string(ETONYEK_DETECTION_TEST_DIR) + "/" + name).c_str());
+  TextRecorder recorder;
+  CPPUNIT_ASSERT(EtonyekDocument::parse(&input, &recorder, firstPage, pageCount));
+  return recorder.get();
+}
+
 static const EtonyekDocument::Confidence EXCELLENT = EtonyekDocument::CONFIDENCE_EXCELLENT;
 static const EtonyekDocument::Confidence SUPPORTED_PART = EtonyekDocument::CONFIDENCE_SUPPORTED_PART;
 
@@ -78,6 +187,8 @@ private:
   CPPUNIT_TEST(testDetectNumbers);
   CPPUNIT_TEST(testDetectPages);
   CPPUNIT_TEST(testUnsupported);
+  CPPUNIT_TEST(testPreview);
+  CPPUNIT_TEST(testPageRange);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -85,6 +196,8 @@ private:
   void testDetectNumbers();
   void testDetectPages();
   void testUnsupported();
+  void testPreview();
+  void testPageRange();
 };
 
 void EtonyekDocumentTest::setUp()
@@ -153,6 +266,50 @@ void EtonyekDocumentTest::testUnsupported()
   assertUnsupportedFile("unsupported.zip");
 }
 
+void EtonyekDocumentTest::testPreview()
+{
+  librevenge::RVNGBinaryData data;
+  librevenge::RVNGString mimeType;
+
+  {
+    // the QuickLook thumbnail is preferred to the micro preview, and
+    // the broken preview.jpg is skipped
+    librevenge::RVNGDirectoryStream input((string(ETONYEK_DETECTION_TEST_DIR) + "/preview.package").c_str());
+    CPPUNIT_ASSERT(EtonyekDocument::getPreview(&input, data, mimeType));
+    CPPUNIT_ASSERT_EQUAL(string("image/jpeg"), string(mimeType.cstr()));
+    CPPUNIT_ASSERT_EQUAL(22ul, data.size());
+  }
+
+  {
+    librevenge::RVNGDirectoryStream input((string(ETONYEK_DETECTION_TEST_DIR) + "/keynote6-package.key").c_str());
+    CPPUNIT_ASSERT(!EtonyekDocument::getPreview(&input, data, mimeType));
+  }
+
+  {
+    librevenge::RVNGFileStream input((string(ETONYEK_DETECTION_TEST_DIR) + "/keynote4.apxl").c_str());
+    CPPUNIT_ASSERT(!EtonyekDocument::getPreview(&input, data, mimeType));
+  }
+}
+
+void EtonyekDocumentTest::testPageRange()
+{
+  const unsigned all = std::numeric_limits<unsigned>::max();
+  const string text("[My hovercraft is full of eels.M\xc3\xa9 vzn\xc3\xa1\xc5\xa1" "edlo je pln\xc3\xa9 \xc3\xba" "ho\xc5\x99\xc5\xaf.M\xc3\xb3j poduszkowiec jest pe\xc5\x82" "en w\xc4\x99gorzy.]");
+
+  {
+    librevenge::RVNGFileStream input((string(ETONYEK_DETECTION_TEST_DIR) + "/pages5-file.pages").c_str());
+    TextRecorder recorder;
+    CPPUNIT_ASSERT(EtonyekDocument::parse(&input, &recorder));
+    CPPUNIT_ASSERT_EQUAL(text, recorder.get());
+  }
+
+  CPPUNIT_ASSERT_EQUAL(text, parsePages("pages5-file.pages", 0, all));
+  CPPUNIT_ASSERT_EQUAL(text, parsePages("pages5-file.pages", 0, 1));
+  // the only section starts before the range, so it is kept
+  CPPUNIT_ASSERT_EQUAL(text, parsePages("pages5-file.pages", 1, 1));
+  CPPUNIT_ASSERT_EQUAL(string("[]"), parsePages("pages5-file.pages", 0, 0));
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(EtonyekDocumentTest);
 
 }
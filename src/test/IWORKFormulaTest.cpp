@@ -36,6 +36,10 @@ private:
   CPPUNIT_TEST(testFunctions);
   CPPUNIT_TEST(testExpressions);
   CPPUNIT_TEST(testInvalid);
+  CPPUNIT_TEST(testSyntax);
+  CPPUNIT_TEST(testBuilder);
+  CPPUNIT_TEST(testCache);
+  CPPUNIT_TEST(testWriteCache);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -46,6 +50,10 @@ private:
   void testFunctions();
   void testExpressions();
   void testInvalid();
+  void testSyntax();
+  void testBuilder();
+  void testCache();
+  void testWriteCache();
 };
 
 void IWORKFormulaTest::setUp()
@@ -67,6 +75,24 @@ void IWORKFormulaTest::testNumbers()
     CPPUNIT_ASSERT_EQUAL(testFormula, formula.str(none));
   }
 
+  // fractions and exponents
+  CPPUNIT_ASSERT(formula.parse("=.5"));
+  CPPUNIT_ASSERT_EQUAL(string("=0.5"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=2.5E3"));
+  CPPUNIT_ASSERT_EQUAL(string("=2500"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=385."));
+  CPPUNIT_ASSERT_EQUAL(string("=385"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=1.7976931348623157E308"));
+  CPPUNIT_ASSERT_EQUAL(string("=1.79769e+308"), formula.str(none));
+
+  // numbers out of the range of double are rejected; the former
+  // Spirit grammar dropped them from the expression instead (found by
+  // comparing both parsers on random formulas)
+  CPPUNIT_ASSERT(!formula.parse("=1E400"));
+  CPPUNIT_ASSERT(!formula.parse("=08e330+\"s3\"+\"s8\"=\"s1\""));
+  CPPUNIT_ASSERT(!formula.parse("=-5.e+400+\"s7\"^2"));
+  CPPUNIT_ASSERT(!formula.parse("=(-.01E-1000+(SUM(.55)/385.))"));
+  CPPUNIT_ASSERT(!formula.parse("=" + string(400, '9') + "+1"));
 }
 
 void IWORKFormulaTest::testStrings()
@@ -249,6 +275,158 @@ void IWORKFormulaTest::testInvalid()
   CPPUNIT_ASSERT(!formula.parse("=SUM(9:B)"));
 }
 
+void IWORKFormulaTest::testSyntax()
+{
+  IWORKFormula formula(none);
+
+  // spaces are allowed around the formula and before an expression
+  CPPUNIT_ASSERT(formula.parse(" = A1+ B1 "));
+  CPPUNIT_ASSERT_EQUAL(string("=[.A1]+[.B1]"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=SUM(A1, B2)"));
+  CPPUNIT_ASSERT_EQUAL(string("=SUM([.A1];[.B2])"), formula.str(none));
+  CPPUNIT_ASSERT(!formula.parse("=A1 +B1"));
+
+  // number formats
+  CPPUNIT_ASSERT(formula.parse("=.5+1e3"));
+  CPPUNIT_ASSERT_EQUAL(string("=0.5+1000"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=--5"));
+  CPPUNIT_ASSERT_EQUAL(string("=--5"), formula.str(none));
+  CPPUNIT_ASSERT(!formula.parse("=2e"));
+
+  // TRUE without parentheses
+  CPPUNIT_ASSERT(formula.parse("=TRUE"));
+  CPPUNIT_ASSERT_EQUAL(string("=TRUE()"), formula.str(none));
+
+  // row range and table with spaces
+  CPPUNIT_ASSERT(formula.parse("=SUM(1:5)"));
+  CPPUNIT_ASSERT_EQUAL(string("=SUM([.1:.5])"), formula.str(none));
+  CPPUNIT_ASSERT(formula.parse("=SFTGlobalID_ab :: 3:SFTGlobalID_ab::7"));
+  CPPUNIT_ASSERT_EQUAL(string("=[ab.3:ab.7]"), formula.str(none));
+
+  // non-ASCII text in a string
+  CPPUNIT_ASSERT(formula.parse("=\"\xc3\xa9\""));
+  CPPUNIT_ASSERT_EQUAL(string("=\xc3\xa9"), formula.str(none));
+}
+
+void IWORKFormulaTest::testBuilder()
+{
+  IWORKFormula formula(none);
+  IWORKFormula::Builder builder;
+
+  IWORKFormula::Address address;
+  IWORKFormula::Coord coord;
+  coord.m_coord = 2;
+  address.m_column = coord;
+  coord.m_absolute = true;
+  address.m_row = coord;
+  address.m_table = std::make_shared<const string>("Abcd");
+
+  // Sum(1;;[Abcd.B$2])
+  builder.pushNumber(1);
+  builder.pushEmpty();
+  builder.pushAddress(address);
+  CPPUNIT_ASSERT(builder.applyFunction("Sum", 3));
+  CPPUNIT_ASSERT(builder.build(formula));
+  CPPUNIT_ASSERT_EQUAL(string("=Sum(1;;[Abcd.B$2])"), formula.str(none));
+
+  // -(2;abc)%&True()
+  builder.pushNumber(2);
+  builder.pushString("abc");
+  CPPUNIT_ASSERT(builder.applyParentheses(2));
+  CPPUNIT_ASSERT(builder.applyPostfixOp('%'));
+  CPPUNIT_ASSERT(builder.applyPrefixOp('-'));
+  builder.pushBool(true);
+  CPPUNIT_ASSERT(builder.applyInfixOp("&"));
+  CPPUNIT_ASSERT(builder.build(formula));
+  CPPUNIT_ASSERT_EQUAL(string("=-(2;abc)%&True()"), formula.str(none));
+
+  // not enough arguments
+  builder.pushNumber(1);
+  CPPUNIT_ASSERT(!builder.applyInfixOp("+"));
+  CPPUNIT_ASSERT(!builder.applyFunction("Sum", 2));
+  // too many expressions
+  builder.pushNumber(1);
+  CPPUNIT_ASSERT(!builder.build(formula));
+  // the stack is empty after a failure
+  CPPUNIT_ASSERT(!builder.build(formula));
+  CPPUNIT_ASSERT_EQUAL(string("=-(2;abc)%&True()"), formula.str(none));
+}
+
+void IWORKFormulaTest::testCache()
+{
+  IWORKFormula::Cache cache;
+
+  IWORKFormula formula1(0x101u);
+  CPPUNIT_ASSERT(formula1.parse("=A1+$B$2", &cache));
+  CPPUNIT_ASSERT_EQUAL(0u, cache.getHits());
+  CPPUNIT_ASSERT_EQUAL(1u, cache.getMisses());
+
+  // the same text in another host cell
+  IWORKFormula formula2(0x202u);
+  CPPUNIT_ASSERT(formula2.parse("=A1+$B$2", &cache));
+  CPPUNIT_ASSERT_EQUAL(1u, cache.getHits());
+  CPPUNIT_ASSERT_EQUAL(1u, cache.getMisses());
+  CPPUNIT_ASSERT_EQUAL(formula1.str(0x101u), formula2.str(0x202u));
+  CPPUNIT_ASSERT_EQUAL(string("=[.A1]+[.$B$2]"), formula1.str(0x101u));
+  CPPUNIT_ASSERT_EQUAL(string("=[.B2]+[.$B$2]"), formula1.str(0x202u));
+
+  // invalid formulas are remembered too
+  IWORKFormula formula3(none);
+  CPPUNIT_ASSERT(!formula3.parse("=A1+", &cache));
+  CPPUNIT_ASSERT(!formula3.parse("=A1+", &cache));
+  CPPUNIT_ASSERT_EQUAL(2u, cache.getHits());
+  CPPUNIT_ASSERT_EQUAL(2u, cache.getMisses());
+}
+
+void IWORKFormulaTest::testWriteCache()
+{
+  IWORKFormula::WriteCache cache;
+  const libetonyek::IWORKTableNameMapPtr_t tableNameMap;
+
+  IWORKFormula formula(0x101u);
+  CPPUNIT_ASSERT(formula.parse("=A1+$B$2"));
+
+  librevenge::RVNGPropertyListVector props1;
+  formula.write(0x101u, props1, tableNameMap, &cache);
+  CPPUNIT_ASSERT_EQUAL(3ul, props1.count());
+  CPPUNIT_ASSERT_EQUAL(0, props1[0]["librevenge:column"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(0, props1[0]["librevenge:row"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(1, props1[2]["librevenge:column"]->getInt());
+
+  // only the relative coordinates change in another cell
+  librevenge::RVNGPropertyListVector props2;
+  formula.write(0x202u, props2, tableNameMap, &cache);
+  CPPUNIT_ASSERT_EQUAL(3ul, props2.count());
+  CPPUNIT_ASSERT_EQUAL(1, props2[0]["librevenge:column"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(1, props2[0]["librevenge:row"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(1, props2[2]["librevenge:column"]->getInt());
+
+  // a reference out of the table loses its coordinate
+  librevenge::RVNGPropertyListVector props3;
+  formula.write(0x100u, props3, tableNameMap, &cache);
+  CPPUNIT_ASSERT(!props3[0]["librevenge:column"]);
+  CPPUNIT_ASSERT_EQUAL(0, props3[0]["librevenge:row"]->getInt());
+
+  // the same as without the cache
+  librevenge::RVNGPropertyListVector props4;
+  formula.write(0x202u, props4, tableNameMap);
+  CPPUNIT_ASSERT_EQUAL(props2.count(), props4.count());
+  CPPUNIT_ASSERT_EQUAL(props2[0]["librevenge:column"]->getInt(), props4[0]["librevenge:column"]->getInt());
+  CPPUNIT_ASSERT_EQUAL(props2[0]["librevenge:row"]->getInt(), props4[0]["librevenge:row"]->getInt());
+
+  // the sheet names come from the current content of the table name map
+  const libetonyek::IWORKTableNameMapPtr_t names = std::make_shared<libetonyek::IWORKTableNameMap_t>();
+  IWORKFormula formula2(0x101u);
+  CPPUNIT_ASSERT(formula2.parse("=SFTGlobalID_Abcd::B2"));
+  librevenge::RVNGPropertyListVector props5;
+  formula2.write(0x101u, props5, names, &cache);
+  CPPUNIT_ASSERT_EQUAL(string("SFTGlobalID_Abcd"), string(props5[0]["librevenge:sheet-name"]->getStr().cstr()));
+  (*names)["SFTGlobalID_Abcd"] = "Sheet 1";
+  librevenge::RVNGPropertyListVector props6;
+  formula2.write(0x101u, props6, names, &cache);
+  CPPUNIT_ASSERT_EQUAL(string("Sheet 1"), string(props6[0]["librevenge:sheet-name"]->getStr().cstr()));
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKFormulaTest);
 
 }
@@ -11,11 +11,16 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "IWORKLanguageManager.h"
+#include "IWORKProperties.h"
+#include "IWORKStyle.h"
 
 namespace test
 {
 
 using libetonyek::IWORKLanguageManager;
+using libetonyek::IWORKStylePtr_t;
+
+namespace property = libetonyek::property;
 
 using librevenge::RVNGPropertyList;
 using librevenge::RVNGString;
@@ -44,11 +49,13 @@ private:
   CPPUNIT_TEST_SUITE(IWORKLanguageManagerTest);
   CPPUNIT_TEST(testTagToProps);
   CPPUNIT_TEST(testLanguageToProps);
+  CPPUNIT_TEST(testLanguageStyle);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testTagToProps();
   void testLanguageToProps();
+  void testLanguageStyle();
 };
 
 void IWORKLanguageManagerTest::setUp()
@@ -130,6 +137,34 @@ void IWORKLanguageManagerTest::testLanguageToProps()
   }
 }
 
+void IWORKLanguageManagerTest::testLanguageStyle()
+{
+  IWORKLanguageManager mgr;
+
+  {
+    const IWORKStylePtr_t style(mgr.getLanguageStyle("cs-CZ"));
+    CPPUNIT_ASSERT(bool(style));
+    CPPUNIT_ASSERT(style->has<property::Language>());
+    CPPUNIT_ASSERT_EQUAL(mgr.addTag("cs-CZ"), style->get<property::Language>());
+    CPPUNIT_ASSERT_EQUAL(style, mgr.getLanguageStyle("cs-CZ"));
+  }
+
+  {
+    // tags with the same canonical form share the style
+    const string tag(mgr.addTag("cs"));
+    if (tag != "cs")
+      CPPUNIT_ASSERT_EQUAL(mgr.getLanguageStyle(tag), mgr.getLanguageStyle("cs"));
+  }
+
+  {
+    // empty and invalid tags clear the language
+    const IWORKStylePtr_t style(mgr.getLanguageStyle(""));
+    CPPUNIT_ASSERT(bool(style));
+    CPPUNIT_ASSERT(!style->has<property::Language>());
+    CPPUNIT_ASSERT_EQUAL(style, mgr.getLanguageStyle("13c"));
+  }
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKLanguageManagerTest);
 
 }
@@ -0,0 +1,319 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <zlib.h>
+
+#include "IWORKMappedPackageStream.h"
+#include "IWORKMemoryStream.h"
+#include "libetonyek_utils.h"
+
+#if !defined ETONYEK_STREAMS_TEST_DIR
+#error ETONYEK_STREAMS_TEST_DIR not defined, cannot test
+#endif
+
+namespace test
+{
+
+using libetonyek::GenericException;
+using libetonyek::getLength;
+using libetonyek::IWORKMappedPackageStream;
+using libetonyek::IWORKMemoryStream;
+using libetonyek::RVNGInputStreamPtr_t;
+
+using std::string;
+
+namespace
+{
+
+struct Member
+{
+  Member(const string &name, const string &content, bool deflate = false);
+
+  string m_name;
+  string m_content;
+  bool m_deflate;
+};
+
+Member::Member(const string &name, const string &content, const bool deflate)
+  : m_name(name)
+  , m_content(content)
+  , m_deflate(deflate)
+{
+}
+
+void putU16(string &data, const unsigned value)
+{
+  data += char(value & 0xff);
+  data += char((value >> 8) & 0xff);
+}
+
+void putU32(string &data, const unsigned long value)
+{
+  putU16(data, unsigned(value & 0xffff));
+  putU16(data, unsigned((value >> 16) & 0xffff));
+}
+
+string deflate(const string &content)
+{
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  CPPUNIT_ASSERT_EQUAL(Z_OK, deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+  std::vector<unsigned char> out(deflateBound(&strm, uLong(content.size())));
+  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(content.data()));
+  strm.avail_in = uInt(content.size());
+  strm.next_out = &out[0];
+  strm.avail_out = uInt(out.size());
+  CPPUNIT_ASSERT_EQUAL(Z_STREAM_END, ::deflate(&strm, Z_FINISH));
+  out.resize(strm.total_out);
+  deflateEnd(&strm);
+  return string(out.begin(), out.end());
+}
+
+/// Create a minimal zip file.
+string makeZip(const std::vector<Member> &members)
+{
+  string data;
+  string directory;
+  for (const auto &member : members)
+  {
+    const string content(member.m_deflate ? deflate(member.m_content) : member.m_content);
+    const auto crc = crc32(0, reinterpret_cast<const Bytef *>(member.m_content.data()), uInt(member.m_content.size()));
+
+    string common;
+    putU16(common, 20); // version needed
+    putU16(common, 0); // flags
+    putU16(common, member.m_deflate ? 8 : 0);
+    putU32(common, 0); // time and date
+    putU32(common, crc);
+    putU32(common, content.size());
+    putU32(common, member.m_content.size());
+    putU16(common, unsigned(member.m_name.size()));
+    putU16(common, 0); // extra field
+
+    putU32(directory, 0x02014b50);
+    putU16(directory, 20); // version made by
+    directory += common;
+    putU16(directory, 0); // comment
+    putU16(directory, 0); // disk
+    putU16(directory, 0); // internal attributes
+    putU32(directory, 0); // external attributes
+    putU32(directory, data.size());
+    directory += member.m_name;
+
+    putU32(data, 0x04034b50);
+    data += common + member.m_name + content;
+  }
+
+  const auto offset = data.size();
+  data += directory;
+  putU32(data, 0x06054b50);
+  putU32(data, 0); // disks
+  putU16(data, unsigned(members.size()));
+  putU16(data, unsigned(members.size()));
+  putU32(data, directory.size());
+  putU32(data, offset);
+  putU16(data, 0); // comment
+  return data;
+}
+
+/// Create a package reading @c data in place.
+std::shared_ptr<IWORKMappedPackageStream> makePackage(const std::shared_ptr<const string> &data)
+{
+  return std::make_shared<IWORKMappedPackageStream>(data, reinterpret_cast<const unsigned char *>(data->data()), data->size());
+}
+
+const unsigned char *readAll(const RVNGInputStreamPtr_t &stream, unsigned long &length)
+{
+  length = getLength(stream);
+  stream->seek(0, librevenge::RVNG_SEEK_SET);
+  unsigned long numBytesRead = 0;
+  const unsigned char *const data = stream->read(length, numBytesRead);
+  CPPUNIT_ASSERT_EQUAL(length, numBytesRead);
+  return data;
+}
+
+string readString(const RVNGInputStreamPtr_t &stream)
+{
+  unsigned long length = 0;
+  const unsigned char *const data = readAll(stream, length);
+  return data ? string(reinterpret_cast<const char *>(data), length) : string();
+}
+
+}
+
+class IWORKMappedPackageStreamTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(IWORKMappedPackageStreamTest);
+  CPPUNIT_TEST(testStored);
+  CPPUNIT_TEST(testDeflated);
+  CPPUNIT_TEST(testNested);
+  CPPUNIT_TEST(testInput);
+  CPPUNIT_TEST(testFile);
+  CPPUNIT_TEST(testInvalid);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testStored();
+  void testDeflated();
+  void testNested();
+  void testInput();
+  void testFile();
+  void testInvalid();
+};
+
+void IWORKMappedPackageStreamTest::setUp()
+{
+}
+
+void IWORKMappedPackageStreamTest::tearDown()
+{
+}
+
+void IWORKMappedPackageStreamTest::testStored()
+{
+  const std::shared_ptr<const string> data(std::make_shared<string>(makeZip({Member("a", "hello"), Member("dir/", ""), Member("dir/b", "world")})));
+  const std::shared_ptr<IWORKMappedPackageStream> package(makePackage(data));
+
+  CPPUNIT_ASSERT(package->isStructured());
+  CPPUNIT_ASSERT_EQUAL(3u, package->subStreamCount());
+  CPPUNIT_ASSERT_EQUAL(string("a"), string(package->subStreamName(0)));
+  CPPUNIT_ASSERT_EQUAL(string("dir/"), string(package->subStreamName(1)));
+  CPPUNIT_ASSERT_EQUAL(string("dir/b"), string(package->subStreamName(2)));
+  CPPUNIT_ASSERT(!package->subStreamName(3));
+  CPPUNIT_ASSERT(package->existsSubStream("dir/b"));
+  CPPUNIT_ASSERT(!package->existsSubStream("b"));
+  CPPUNIT_ASSERT(!package->getSubStreamByName("b"));
+
+  const RVNGInputStreamPtr_t member(package->getSubStreamByName("dir/b"));
+  CPPUNIT_ASSERT(bool(member));
+  CPPUNIT_ASSERT(!member->isStructured());
+  CPPUNIT_ASSERT_EQUAL(string("world"), readString(member));
+  CPPUNIT_ASSERT_EQUAL(string("hello"), readString(RVNGInputStreamPtr_t(package->getSubStreamById(0))));
+
+  // the member is read in place
+  unsigned long length = 0;
+  const unsigned char *const bytes = readAll(member, length);
+  CPPUNIT_ASSERT(bytes == reinterpret_cast<const unsigned char *>(data->data() + data->rfind("world")));
+
+  // the package itself is readable too
+  CPPUNIT_ASSERT_EQUAL(*data, readString(package));
+}
+
+void IWORKMappedPackageStreamTest::testDeflated()
+{
+  const string content("hello hello hello hello hello");
+  const std::shared_ptr<const string> data(std::make_shared<string>(makeZip({Member("a", content, true), Member("empty", "", true)})));
+  CPPUNIT_ASSERT(data->find(content) == string::npos);
+  const std::shared_ptr<IWORKMappedPackageStream> package(makePackage(data));
+
+  CPPUNIT_ASSERT_EQUAL(content, readString(RVNGInputStreamPtr_t(package->getSubStreamByName("a"))));
+  const RVNGInputStreamPtr_t empty(package->getSubStreamByName("empty"));
+  CPPUNIT_ASSERT(bool(empty));
+  CPPUNIT_ASSERT_EQUAL(0ul, getLength(empty));
+}
+
+void IWORKMappedPackageStreamTest::testNested()
+{
+  const string inner(makeZip({Member("Index/Document.iwa", "document")}));
+  const std::shared_ptr<const string> data(std::make_shared<string>(makeZip({Member("Index.zip", inner), Member("Deflated.zip", inner, true)})));
+  const std::shared_ptr<IWORKMappedPackageStream> package(makePackage(data));
+
+  for (const char *const name : {"Index.zip", "Deflated.zip"})
+  {
+    const RVNGInputStreamPtr_t index(package->getSubStreamByName(name));
+    CPPUNIT_ASSERT(bool(index));
+    CPPUNIT_ASSERT(index->isStructured());
+    CPPUNIT_ASSERT(index->existsSubStream("Index/Document.iwa"));
+    CPPUNIT_ASSERT_EQUAL(string("document"), readString(RVNGInputStreamPtr_t(index->getSubStreamByName("Index/Document.iwa"))));
+    CPPUNIT_ASSERT_EQUAL(inner, readString(index));
+  }
+}
+
+void IWORKMappedPackageStreamTest::testInput()
+{
+  const string data(makeZip({Member("a", "hello"), Member("b", "world", true)}));
+  const RVNGInputStreamPtr_t input(new IWORKMemoryStream(reinterpret_cast<const unsigned char *>(data.data()), unsigned(data.size())));
+  input->seek(3, librevenge::RVNG_SEEK_SET);
+  IWORKMappedPackageStream package(input);
+
+  CPPUNIT_ASSERT_EQUAL(2u, package.subStreamCount());
+  CPPUNIT_ASSERT_EQUAL(string("hello"), readString(RVNGInputStreamPtr_t(package.getSubStreamByName("a"))));
+  CPPUNIT_ASSERT_EQUAL(string("world"), readString(RVNGInputStreamPtr_t(package.getSubStreamByName("b"))));
+}
+
+void IWORKMappedPackageStreamTest::testFile()
+{
+  {
+    // stored members
+    IWORKMappedPackageStream package(ETONYEK_STREAMS_TEST_DIR "/pages5.zip");
+    CPPUNIT_ASSERT_EQUAL(8u, package.subStreamCount());
+    CPPUNIT_ASSERT(package.existsSubStream("Index/Document.iwa"));
+    const RVNGInputStreamPtr_t document(package.getSubStreamByName("Index/Document.iwa"));
+    CPPUNIT_ASSERT(bool(document));
+    CPPUNIT_ASSERT_EQUAL(3816ul, getLength(document));
+  }
+
+  {
+    // deflated members
+    IWORKMappedPackageStream package(ETONYEK_STREAMS_TEST_DIR "/keynote5-file.key");
+    CPPUNIT_ASSERT(package.existsSubStream("index.apxl"));
+    CPPUNIT_ASSERT_EQUAL(string("????????"), readString(RVNGInputStreamPtr_t(package.getSubStreamByName("Contents/PkgInfo"))));
+    const RVNGInputStreamPtr_t index(package.getSubStreamByName("index.apxl"));
+    CPPUNIT_ASSERT(bool(index));
+    CPPUNIT_ASSERT_EQUAL(1962436ul, getLength(index));
+    CPPUNIT_ASSERT_EQUAL(string("<?xml"), readString(index).substr(0, 5));
+  }
+}
+
+void IWORKMappedPackageStreamTest::testInvalid()
+{
+  const string data(makeZip({Member("a", "hello")}));
+
+  // not a zip file
+  const std::shared_ptr<const string> text(std::make_shared<string>("hello world, this is not a zip file"));
+  CPPUNIT_ASSERT_THROW(makePackage(text), GenericException);
+  CPPUNIT_ASSERT_THROW(IWORKMappedPackageStream(ETONYEK_STREAMS_TEST_DIR "/keynote4.apxl"), GenericException);
+  CPPUNIT_ASSERT_THROW(IWORKMappedPackageStream(ETONYEK_STREAMS_TEST_DIR "/nonexistent.zip"), GenericException);
+  // no central directory
+  CPPUNIT_ASSERT_THROW(makePackage(std::make_shared<string>(data.substr(0, data.size() - 4))), GenericException);
+  CPPUNIT_ASSERT_THROW(makePackage(std::make_shared<string>(data.substr(0, 40))), GenericException);
+
+  // a broken central directory
+  string broken(data);
+  broken[broken.size() - 6] = 0x10;
+  CPPUNIT_ASSERT_THROW(makePackage(std::make_shared<string>(broken)), GenericException);
+
+  // a member that is not in the file
+  broken = data;
+  broken[broken.find("PK\1\2") + 42] = 0x7f;
+  const std::shared_ptr<IWORKMappedPackageStream> package(makePackage(std::make_shared<string>(broken)));
+  CPPUNIT_ASSERT(package->existsSubStream("a"));
+  CPPUNIT_ASSERT(!package->getSubStreamByName("a"));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IWORKMappedPackageStreamTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
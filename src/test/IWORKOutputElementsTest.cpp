@@ -0,0 +1,364 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "IWORKDocumentInterface.h"
+#include "IWORKOutputElements.h"
+
+namespace test
+{
+
+using libetonyek::IWORKDocumentInterface;
+using libetonyek::IWORKOutputElements;
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+#define RECORD(name) \
+  void name() override \
+  { \
+    m_calls.push_back(#name); \
+  }
+
+#define RECORD_PROPS(name) \
+  void name(const librevenge::RVNGPropertyList &) override \
+  { \
+    m_calls.push_back(#name); \
+  }
+
+class RecordingInterface : public IWORKDocumentInterface
+{
+public:
+  RecordingInterface()
+    : m_calls()
+  {
+  }
+
+  const string calls() const
+  {
+    string result;
+    for (const auto &call : m_calls)
+    {
+      if (!result.empty())
+        result += ' ';
+      result += call;
+    }
+    return result;
+  }
+
+  void insertText(const librevenge::RVNGString &text) override
+  {
+    m_calls.push_back(string("insertText:") + text.cstr());
+  }
+
+  RECORD_PROPS(setDocumentMetaData)
+  RECORD_PROPS(startDocument)
+  RECORD(endDocument)
+  RECORD_PROPS(definePageStyle)
+  RECORD_PROPS(defineEmbeddedFont)
+  RECORD_PROPS(openPageSpan)
+  RECORD(closePageSpan)
+  RECORD_PROPS(startSlide)
+  RECORD(endSlide)
+  RECORD_PROPS(startMasterSlide)
+  RECORD(endMasterSlide)
+  RECORD_PROPS(setStyle)
+  RECORD_PROPS(startLayer)
+  RECORD(endLayer)
+  RECORD_PROPS(openHeader)
+  RECORD(closeHeader)
+  RECORD_PROPS(openFooter)
+  RECORD(closeFooter)
+  RECORD_PROPS(defineParagraphStyle)
+  RECORD_PROPS(openParagraph)
+  RECORD(closeParagraph)
+  RECORD_PROPS(defineCharacterStyle)
+  RECORD_PROPS(openSpan)
+  RECORD(closeSpan)
+  RECORD_PROPS(openLink)
+  RECORD(closeLink)
+  RECORD_PROPS(defineSectionStyle)
+  RECORD_PROPS(openSection)
+  RECORD(closeSection)
+  RECORD(insertTab)
+  RECORD(insertSpace)
+  RECORD(insertLineBreak)
+  RECORD_PROPS(insertField)
+  RECORD_PROPS(openOrderedListLevel)
+  RECORD_PROPS(openUnorderedListLevel)
+  RECORD(closeOrderedListLevel)
+  RECORD(closeUnorderedListLevel)
+  RECORD_PROPS(openListElement)
+  RECORD(closeListElement)
+  RECORD_PROPS(openFootnote)
+  RECORD(closeFootnote)
+  RECORD_PROPS(openEndnote)
+  RECORD(closeEndnote)
+  RECORD_PROPS(openComment)
+  RECORD(closeComment)
+  RECORD_PROPS(openTextBox)
+  RECORD(closeTextBox)
+  RECORD_PROPS(defineSheetNumberingStyle)
+  RECORD_PROPS(openTable)
+  RECORD_PROPS(openTableRow)
+  RECORD(closeTableRow)
+  RECORD_PROPS(openTableCell)
+  RECORD(closeTableCell)
+  RECORD_PROPS(insertCoveredTableCell)
+  RECORD(closeTable)
+  RECORD_PROPS(openFrame)
+  RECORD(closeFrame)
+  RECORD_PROPS(insertBinaryObject)
+  RECORD_PROPS(insertEquation)
+  RECORD_PROPS(openGroup)
+  RECORD(closeGroup)
+  RECORD_PROPS(defineGraphicStyle)
+  RECORD_PROPS(drawRectangle)
+  RECORD_PROPS(drawEllipse)
+  RECORD_PROPS(drawPolygon)
+  RECORD_PROPS(drawPolyline)
+  RECORD_PROPS(drawPath)
+  RECORD_PROPS(drawGraphicObject)
+  RECORD_PROPS(drawConnector)
+  RECORD_PROPS(startTextObject)
+  RECORD(endTextObject)
+  RECORD_PROPS(startNotes)
+  RECORD(endNotes)
+  RECORD_PROPS(defineChartStyle)
+  RECORD_PROPS(openChart)
+  RECORD(closeChart)
+  RECORD_PROPS(openChartTextObject)
+  RECORD(closeChartTextObject)
+  RECORD_PROPS(openChartPlotArea)
+  RECORD(closeChartPlotArea)
+  RECORD_PROPS(insertChartAxis)
+  RECORD_PROPS(openChartSeries)
+  RECORD(closeChartSeries)
+  RECORD_PROPS(openAnimationSequence)
+  RECORD(closeAnimationSequence)
+  RECORD_PROPS(openAnimationGroup)
+  RECORD(closeAnimationGroup)
+  RECORD_PROPS(openAnimationIteration)
+  RECORD(closeAnimationIteration)
+  RECORD_PROPS(insertMotionAnimation)
+  RECORD_PROPS(insertColorAnimation)
+  RECORD_PROPS(insertAnimation)
+  RECORD_PROPS(insertEffect)
+
+private:
+  vector<string> m_calls;
+};
+
+#undef RECORD_PROPS
+#undef RECORD
+
+const string replay(const IWORKOutputElements &elements)
+{
+  RecordingInterface recorder;
+  elements.write(&recorder);
+  return recorder.calls();
+}
+
+void addParagraph(IWORKOutputElements &elements, const char *const text)
+{
+  elements.addOpenParagraph(librevenge::RVNGPropertyList());
+  elements.addInsertText(text);
+  elements.addCloseParagraph();
+}
+
+}
+
+class IWORKOutputElementsTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(IWORKOutputElementsTest);
+  CPPUNIT_TEST(testWrite);
+  CPPUNIT_TEST(testAppend);
+  CPPUNIT_TEST(testCopy);
+  CPPUNIT_TEST(testShapesInSpreadsheet);
+  CPPUNIT_TEST(testDirect);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testWrite();
+  void testAppend();
+  void testCopy();
+  void testShapesInSpreadsheet();
+  void testDirect();
+};
+
+void IWORKOutputElementsTest::setUp()
+{
+}
+
+void IWORKOutputElementsTest::tearDown()
+{
+}
+
+void IWORKOutputElementsTest::testWrite()
+{
+  IWORKOutputElements elements;
+  CPPUNIT_ASSERT(elements.empty());
+  CPPUNIT_ASSERT_EQUAL(string(), replay(elements));
+
+  elements.addOpenParagraph(librevenge::RVNGPropertyList());
+  elements.addOpenSpan(librevenge::RVNGPropertyList());
+  elements.addInsertText("a");
+  elements.addInsertTab();
+  elements.addInsertText("b");
+  elements.addCloseSpan();
+  elements.addCloseParagraph();
+  CPPUNIT_ASSERT(!elements.empty());
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph openSpan insertText:a insertTab insertText:b closeSpan closeParagraph"), replay(elements));
+
+  // writing to nothing is allowed
+  elements.write(nullptr);
+
+  elements.clear();
+  CPPUNIT_ASSERT(elements.empty());
+  CPPUNIT_ASSERT_EQUAL(string(), replay(elements));
+}
+
+void IWORKOutputElementsTest::testAppend()
+{
+  IWORKOutputElements first;
+  addParagraph(first, "a");
+  IWORKOutputElements second;
+  addParagraph(second, "b");
+
+  first.append(second);
+  first.addInsertLineBreak();
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:a closeParagraph openParagraph insertText:b closeParagraph insertLineBreak"), replay(first));
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:b closeParagraph"), replay(second));
+
+  // the appended elements are not affected by changes of the source
+  second.addInsertTab();
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:a closeParagraph openParagraph insertText:b closeParagraph insertLineBreak"), replay(first));
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:b closeParagraph insertTab"), replay(second));
+
+  IWORKOutputElements self;
+  self.addInsertTab();
+  self.append(self);
+  CPPUNIT_ASSERT_EQUAL(string("insertTab insertTab"), replay(self));
+
+  IWORKOutputElements empty;
+  self.append(empty);
+  CPPUNIT_ASSERT_EQUAL(string("insertTab insertTab"), replay(self));
+}
+
+void IWORKOutputElementsTest::testCopy()
+{
+  IWORKOutputElements original;
+  addParagraph(original, "a");
+
+  IWORKOutputElements copy(original);
+  copy.addInsertTab();
+  original.addInsertSpace();
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:a closeParagraph insertSpace"), replay(original));
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:a closeParagraph insertTab"), replay(copy));
+
+  original.clear();
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:a closeParagraph insertTab"), replay(copy));
+}
+
+void IWORKOutputElementsTest::testShapesInSpreadsheet()
+{
+  IWORKOutputElements shapes;
+  shapes.addDrawPath(librevenge::RVNGPropertyList());
+
+  IWORKOutputElements empty;
+  empty.addShapesInSpreadsheet(shapes);
+  CPPUNIT_ASSERT(empty.empty());
+
+  IWORKOutputElements sheet;
+  sheet.addOpenTable(librevenge::RVNGPropertyList());
+  sheet.addCloseTable();
+  sheet.addShapesInSpreadsheet(shapes);
+  CPPUNIT_ASSERT_EQUAL(string("openTable drawPath closeTable"), replay(sheet));
+  sheet.addInsertTab();
+  CPPUNIT_ASSERT_EQUAL(string("openTable drawPath closeTable insertTab"), replay(sheet));
+
+  IWORKOutputElements single;
+  single.addOpenTable(librevenge::RVNGPropertyList());
+  single.addShapesInSpreadsheet(shapes);
+  CPPUNIT_ASSERT_EQUAL(string("openTable drawPath"), replay(single));
+}
+
+void IWORKOutputElementsTest::testDirect()
+{
+  RecordingInterface document;
+  unsigned prologues = 0;
+  IWORKOutputElements elements(&document, [&prologues, &document]()
+  {
+    ++prologues;
+    document.closePageSpan();
+  });
+  CPPUNIT_ASSERT(elements.isDirect());
+  CPPUNIT_ASSERT(elements.empty());
+  CPPUNIT_ASSERT_EQUAL(0u, prologues);
+
+  // appending nothing does not start the output
+  elements.append(IWORKOutputElements());
+  CPPUNIT_ASSERT(elements.empty());
+  CPPUNIT_ASSERT_EQUAL(0u, prologues);
+
+  addParagraph(elements, "a");
+  CPPUNIT_ASSERT(!elements.empty());
+  CPPUNIT_ASSERT_EQUAL(1u, prologues);
+  CPPUNIT_ASSERT_EQUAL(string("closePageSpan openParagraph insertText:a closeParagraph"), document.calls());
+
+  IWORKOutputElements buffered;
+  addParagraph(buffered, "b");
+  elements.append(buffered);
+  elements.addInsertTab();
+  CPPUNIT_ASSERT_EQUAL(1u, prologues);
+  CPPUNIT_ASSERT_EQUAL(string("closePageSpan openParagraph insertText:a closeParagraph openParagraph insertText:b closeParagraph insertTab"), document.calls());
+
+  // nothing is recorded
+  CPPUNIT_ASSERT_EQUAL(string(), replay(elements));
+  CPPUNIT_ASSERT(!IWORKOutputElements().isDirect());
+
+  // a copy does not write to the document
+  IWORKOutputElements copy(elements);
+  CPPUNIT_ASSERT(!copy.isDirect());
+  addParagraph(copy, "c");
+  IWORKOutputElements assigned;
+  assigned = elements;
+  CPPUNIT_ASSERT(!assigned.isDirect());
+  assigned.addInsertSpace();
+  CPPUNIT_ASSERT_EQUAL(1u, prologues);
+  CPPUNIT_ASSERT_EQUAL(string("closePageSpan openParagraph insertText:a closeParagraph openParagraph insertText:b closeParagraph insertTab"), document.calls());
+  CPPUNIT_ASSERT_EQUAL(string("openParagraph insertText:c closeParagraph"), replay(copy));
+
+  // but moving keeps the direct mode
+  IWORKOutputElements moved(std::move(elements));
+  CPPUNIT_ASSERT(moved.isDirect());
+  moved.addInsertSpace();
+  CPPUNIT_ASSERT_EQUAL(1u, prologues);
+  CPPUNIT_ASSERT_EQUAL(string("closePageSpan openParagraph insertText:a closeParagraph openParagraph insertText:b closeParagraph insertTab insertSpace"), document.calls());
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IWORKOutputElementsTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
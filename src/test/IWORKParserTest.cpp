@@ -0,0 +1,225 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "IWORKMemoryStream.h"
+#include "IWORKParser.h"
+#include "IWORKTokenizerBase.h"
+#include "IWORKXMLContext.h"
+
+namespace test
+{
+
+using libetonyek::IWORKMemoryStream;
+using libetonyek::IWORKParser;
+using libetonyek::IWORKTokenizer;
+using libetonyek::IWORKTokenizerBase;
+using libetonyek::IWORKXMLContext;
+using libetonyek::IWORKXMLContextPtr_t;
+using libetonyek::RVNGInputStreamPtr_t;
+
+using std::string;
+
+namespace
+{
+
+const int TOKEN_DOC = 1;
+const int TOKEN_P = 2;
+const int TOKEN_B = 3;
+const int TOKEN_ID = 4;
+const int TOKEN_NS = 1 << 8;
+
+class TestTokenizer : public IWORKTokenizerBase
+{
+private:
+  virtual int queryId(const char *name) const;
+};
+
+int TestTokenizer::queryId(const char *const name) const
+{
+  const string nameStr(name);
+
+  if ("doc" == nameStr)
+    return TOKEN_DOC;
+  else if ("p" == nameStr)
+    return TOKEN_P;
+  else if ("b" == nameStr)
+    return TOKEN_B;
+  else if ("id" == nameStr)
+    return TOKEN_ID;
+  else if ("urn:test" == nameStr)
+    return TOKEN_NS;
+
+  return 0;
+}
+
+/// Records all calls in a string.
+class RecordingContext : public IWORKXMLContext
+{
+public:
+  explicit RecordingContext(string &record);
+
+private:
+  virtual void startOfElement();
+  virtual void attribute(int name, const char *value);
+  virtual IWORKXMLContextPtr_t element(int name);
+  virtual void text(const char *value);
+  virtual void CDATA(const char *value);
+  virtual void endOfElement();
+
+private:
+  string &m_record;
+};
+
+RecordingContext::RecordingContext(string &record)
+  : m_record(record)
+{
+}
+
+void RecordingContext::startOfElement()
+{
+  m_record += "(";
+}
+
+void RecordingContext::attribute(const int name, const char *const value)
+{
+  m_record += "@" + std::to_string(name) + "=" + value + ";";
+}
+
+IWORKXMLContextPtr_t RecordingContext::element(const int name)
+{
+  m_record += std::to_string(name & ~TOKEN_NS);
+  return std::make_shared<RecordingContext>(m_record);
+}
+
+void RecordingContext::text(const char *const value)
+{
+  m_record += "[" + string(value) + "]";
+}
+
+void RecordingContext::CDATA(const char *const value)
+{
+  m_record += "{" + string(value) + "}";
+}
+
+void RecordingContext::endOfElement()
+{
+  m_record += ")";
+}
+
+class TestParser : public IWORKParser
+{
+public:
+  TestParser(const RVNGInputStreamPtr_t &input, string &record);
+
+private:
+  virtual const IWORKTokenizer &getTokenizer() const;
+  virtual IWORKXMLContextPtr_t createDocumentContext();
+  virtual IWORKXMLContextPtr_t createDiscardContext();
+
+private:
+  const TestTokenizer m_tokenizer;
+  string &m_record;
+};
+
+TestParser::TestParser(const RVNGInputStreamPtr_t &input, string &record)
+  : IWORKParser(input, RVNGInputStreamPtr_t())
+  , m_tokenizer()
+  , m_record(record)
+{
+}
+
+const IWORKTokenizer &TestParser::getTokenizer() const
+{
+  return m_tokenizer;
+}
+
+IWORKXMLContextPtr_t TestParser::createDocumentContext()
+{
+  return std::make_shared<RecordingContext>(m_record);
+}
+
+IWORKXMLContextPtr_t TestParser::createDiscardContext()
+{
+  return std::make_shared<RecordingContext>(m_record);
+}
+
+string parse(const string &body)
+{
+  const string document("<?xml version=\"1.0\"?>\n<doc xmlns=\"urn:test\">" + body + "</doc>");
+  const RVNGInputStreamPtr_t input(new IWORKMemoryStream(std::vector<unsigned char>(document.begin(), document.end())));
+  string record;
+  TestParser parser(input, record);
+  CPPUNIT_ASSERT(parser.parse());
+  return record;
+}
+
+}
+
+class IWORKParserTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(IWORKParserTest);
+  CPPUNIT_TEST(testText);
+  CPPUNIT_TEST(testLongText);
+  CPPUNIT_TEST(testMixedContent);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testText();
+  void testLongText();
+  void testMixedContent();
+};
+
+void IWORKParserTest::setUp()
+{
+}
+
+void IWORKParserTest::tearDown()
+{
+}
+
+void IWORKParserTest::testText()
+{
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2([a])2([ab])2([abcdefghijklmnopqrstuvwxyz])))"), parse("<p>a</p><p>ab</p><p>abcdefghijklmnopqrstuvwxyz</p>"));
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2([a & <b> \"c\" \xe2\x98\xba])))"), parse("<p>a &amp; &lt;b&gt; &quot;c&quot; &#x263A;</p>"));
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2(@4=a&b;[x])))"), parse("<p id=\"a&amp;b\">x</p>"));
+  // whitespace-only nodes are dropped
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2()2([ a ])))"), parse("<p>  </p>\n<p> a </p>"));
+}
+
+void IWORKParserTest::testLongText()
+{
+  string text;
+  for (unsigned i = 0; text.size() < 100000; ++i)
+    text += std::to_string(i) + ' ';
+  CPPUNIT_ASSERT_EQUAL("1(@0=urn:test;2([" + text + "])))", parse("<p>" + text + "</p>"));
+}
+
+void IWORKParserTest::testMixedContent()
+{
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2([a]3([b])[c]{<d>}[e])))"), parse("<p>a<b>b</b>c<![CDATA[<d>]]>e</p>"));
+  CPPUNIT_ASSERT_EQUAL(string("1(@0=urn:test;2([a]3()[b]3()[c])))"), parse("<p>a<b/>b<b></b>c</p>"));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IWORKParserTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
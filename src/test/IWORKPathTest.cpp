@@ -32,11 +32,15 @@ private:
   CPPUNIT_TEST_SUITE(IWORKPathTest);
   CPPUNIT_TEST(testConstruction);
   CPPUNIT_TEST(testConversion);
+  CPPUNIT_TEST(testTransformation);
+  CPPUNIT_TEST(testCopyOnWrite);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testConstruction();
   void testConversion();
+  void testTransformation();
+  void testCopyOnWrite();
 };
 
 void IWORKPathTest::setUp()
@@ -72,6 +76,34 @@ void  IWORKPathTest::testConstruction()
     CPPUNIT_ASSERT_NO_THROW((IWORKPath(src)));
     CPPUNIT_ASSERT_EQUAL(string("M 0 0 L 0 1 C 1 1 0.5 0.5 0 0 Z"), IWORKPath(src).str());
   }
+
+  {
+    const string src = "\tM0 .5L1-1 Q 2. 3e1 -4E-1 +5\n";
+    CPPUNIT_ASSERT_NO_THROW((IWORKPath(src)));
+    CPPUNIT_ASSERT_EQUAL(string("M 0 0.5 L 1 -1 Q 2 30 -0.4 5"), IWORKPath(src).str());
+  }
+
+  {
+    const string src = "M 0 0 L 1 1 M 2 2 Q 3 3 4 4 M 5 5 M 6 6";
+    CPPUNIT_ASSERT_NO_THROW((IWORKPath(src)));
+    CPPUNIT_ASSERT_EQUAL(string("M 0 0 L 1 1 M 2 2 Q 3 3 4 4"), IWORKPath(src).str());
+  }
+
+  {
+    const string src = "M 123456.7 -0.000123456789 L 1234567 0.1";
+    CPPUNIT_ASSERT_NO_THROW((IWORKPath(src)));
+    CPPUNIT_ASSERT_EQUAL(string("M 123457 -0.000123457 L 1.23457e+06 0.1"), IWORKPath(src).str());
+  }
+
+  CPPUNIT_ASSERT_THROW(IWORKPath(""), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("L 0 0 L 1 1"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0 M 1 1 L 2 2"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0 L 1"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0 L 1 1 Z L 2 2"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0 L 1 1 Z Z"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("M 0 0 L 1,1"), IWORKPath::InvalidException);
+  CPPUNIT_ASSERT_THROW(IWORKPath("m 0 0 l 1 1"), IWORKPath::InvalidException);
 }
 
 void  IWORKPathTest::testConversion()
@@ -127,6 +159,79 @@ void  IWORKPathTest::testConversion()
   }
 }
 
+void IWORKPathTest::testTransformation()
+{
+  {
+    IWORKPath path("M 0 0 L 1 0 C 1 1 0 1 0 0 Z");
+    path *= glm::dmat3(2, 0, 0, 0, 3, 0, 1, 1, 1);
+    CPPUNIT_ASSERT_EQUAL(string("M 1 1 L 3 1 C 3 4 1 4 1 1 Z"), path.str());
+  }
+
+  {
+    IWORKPath path("M 0 0 L 1 0 L 1 1 L 0 1 Z");
+    path *= glm::dmat3(0, 1, 0, -1, 0, 0, 0, 0, 1);
+    CPPUNIT_ASSERT_EQUAL(string("M 0 0 L 0 1 L -1 1 L -1 0 Z"), path.str());
+
+    double minX, minY, maxX, maxY;
+    path.computeBoundingBox(minX, minY, maxX, maxY);
+    CPPUNIT_ASSERT_EQUAL(-1., minX);
+    CPPUNIT_ASSERT_EQUAL(0., minY);
+    CPPUNIT_ASSERT_EQUAL(0., maxX);
+    CPPUNIT_ASSERT_EQUAL(1., maxY);
+  }
+
+  {
+    const IWORKPath path("M 0 0 L 2 0 C 2 1 3 1 3 0 L 4 -1 L 3.5 -0.5");
+    double minX, minY, maxX, maxY;
+    path.computeBoundingBox(minX, minY, maxX, maxY, 2);
+    CPPUNIT_ASSERT_EQUAL(0., minX);
+    CPPUNIT_ASSERT_EQUAL(-2., minY);
+    CPPUNIT_ASSERT_EQUAL(8., maxX);
+    CPPUNIT_ASSERT_EQUAL(1.5, maxY);
+  }
+}
+
+void IWORKPathTest::testCopyOnWrite()
+{
+  const string src = "M 0 0 L 1 0 L 1 1 L 0 0";
+  const IWORKPath path(src);
+
+  {
+    IWORKPath copy(path);
+    copy.appendMoveTo(2, 2);
+    copy.appendLineTo(3, 3);
+    CPPUNIT_ASSERT_EQUAL(string("M 0 0 L 1 0 L 1 1 L 0 0 M 2 2 L 3 3"), copy.str());
+    CPPUNIT_ASSERT_EQUAL(src, path.str());
+  }
+
+  {
+    IWORKPath copy;
+    copy = path;
+    copy *= glm::dmat3(2, 0, 0, 0, 2, 0, 0, 0, 1);
+    CPPUNIT_ASSERT_EQUAL(string("M 0 0 L 2 0 L 2 2 L 0 0"), copy.str());
+    CPPUNIT_ASSERT_EQUAL(src, path.str());
+  }
+
+  {
+    IWORKPath copy(path);
+    copy.closePath();
+    CPPUNIT_ASSERT_EQUAL(src + " Z", copy.str());
+    CPPUNIT_ASSERT_EQUAL(src, path.str());
+
+    // closing a closed path changes nothing
+    const IWORKPath closed(copy);
+    copy.closePath();
+    CPPUNIT_ASSERT(closed == copy);
+  }
+
+  {
+    IWORKPath copy(path);
+    copy.clear();
+    CPPUNIT_ASSERT(copy.empty());
+    CPPUNIT_ASSERT_EQUAL(src, path.str());
+  }
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKPathTest);
 
 }
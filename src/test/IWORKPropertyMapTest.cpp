@@ -22,6 +22,9 @@ using libetonyek::property::Answer;
 using libetonyek::property::Antwort;
 using libetonyek::IWORKPropertyInfo;
 using libetonyek::IWORKPropertyMap;
+using libetonyek::getPropertyName;
+
+using std::string;
 
 class IWORKPropertyMapTest : public CPPUNIT_NS::TestFixture
 {
@@ -33,11 +36,15 @@ private:
   CPPUNIT_TEST_SUITE(IWORKPropertyMapTest);
   CPPUNIT_TEST(testLookup);
   CPPUNIT_TEST(testLookupWithParent);
+  CPPUNIT_TEST(testIds);
+  CPPUNIT_TEST(testCopy);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testLookup();
   void testLookupWithParent();
+  void testIds();
+  void testCopy();
 };
 
 void IWORKPropertyMapTest::setUp()
@@ -135,6 +142,39 @@ void IWORKPropertyMapTest::testLookupWithParent()
   }
 }
 
+void IWORKPropertyMapTest::testIds()
+{
+  CPPUNIT_ASSERT(IWORKPropertyInfo<Answer>::id != 0);
+  CPPUNIT_ASSERT(IWORKPropertyInfo<Antwort>::id != 0);
+  CPPUNIT_ASSERT(IWORKPropertyInfo<Answer>::id != IWORKPropertyInfo<Antwort>::id);
+
+  CPPUNIT_ASSERT_EQUAL(string("Answer"), string(getPropertyName(IWORKPropertyInfo<Answer>::id)));
+  CPPUNIT_ASSERT_EQUAL(string("Antwort"), string(getPropertyName(IWORKPropertyInfo<Antwort>::id)));
+}
+
+void IWORKPropertyMapTest::testCopy()
+{
+  IWORKPropertyMap props;
+  props.put<Answer>(42);
+  props.clear<Antwort>();
+
+  IWORKPropertyMap copy(props);
+  CPPUNIT_ASSERT_EQUAL(42, copy.get<Answer>());
+  CPPUNIT_ASSERT(copy.clears<Antwort>());
+
+  // the maps are independent
+  copy.put<Answer>(1);
+  copy.put<Antwort>(2);
+  CPPUNIT_ASSERT_EQUAL(42, props.get<Answer>());
+  CPPUNIT_ASSERT(props.clears<Antwort>());
+  CPPUNIT_ASSERT_EQUAL(1, copy.get<Answer>());
+  CPPUNIT_ASSERT_EQUAL(2, copy.get<Antwort>());
+
+  props = copy;
+  CPPUNIT_ASSERT_EQUAL(1, props.get<Answer>());
+  CPPUNIT_ASSERT_EQUAL(2, props.get<Antwort>());
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKPropertyMapTest);
 
 }
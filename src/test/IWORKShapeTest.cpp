@@ -40,6 +40,7 @@ private:
   CPPUNIT_TEST(testMakeConnectionPath);
   CPPUNIT_TEST(testMakeCalloutPath);
   CPPUNIT_TEST(testMakeQuoteBubblePath);
+  CPPUNIT_TEST(testPathCache);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -51,6 +52,7 @@ private:
   void testMakeConnectionPath();
   void testMakeCalloutPath();
   void testMakeQuoteBubblePath();
+  void testPathCache();
 };
 
 void IWORKShapeTest::setUp()
@@ -156,6 +158,29 @@ void IWORKShapeTest::testMakeQuoteBubblePath()
   // TODO: implement me
 }
 
+void IWORKShapeTest::testPathCache()
+{
+  using libetonyek::IWORKShapePathCache;
+
+  IWORKShapePathCache cache;
+  const IWORKSize size(100, 50);
+
+  const IWORKPathPtr_t arrow = cache.makeArrowPath(size, 20, 0.25);
+  CPPUNIT_ASSERT(bool(arrow));
+  CPPUNIT_ASSERT(*libetonyek::makeArrowPath(size, 20, 0.25) == *arrow);
+
+  // the same shape shares the path
+  CPPUNIT_ASSERT(arrow == cache.makeArrowPath(size, 20, 0.25));
+
+  // different parameters, size or kind do not
+  CPPUNIT_ASSERT(arrow != cache.makeArrowPath(size, 20, 0.3));
+  CPPUNIT_ASSERT(arrow != cache.makeArrowPath(IWORKSize(100, 60), 20, 0.25));
+  CPPUNIT_ASSERT(arrow != cache.makeDoubleArrowPath(size, 20, 0.25));
+  CPPUNIT_ASSERT(cache.makeStarPath(size, 5, 0.5) != cache.makeStarPath(size, 6, 0.5));
+  CPPUNIT_ASSERT(cache.makeCalloutPath(size, 5, 10, 0, 60) == cache.makeCalloutPath(size, 5, 10, 0, 60));
+  CPPUNIT_ASSERT(cache.makeCalloutPath(size, 5, 10, 0, 60) != cache.makeQuoteBubblePath(size, 5, 10, 0, 60));
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKShapeTest);
 
 }
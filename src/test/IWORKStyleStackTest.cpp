@@ -51,10 +51,12 @@ public:
 private:
   CPPUNIT_TEST_SUITE(IWORKStyleStackTest);
   CPPUNIT_TEST(testLookup);
+  CPPUNIT_TEST(testCompare);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testLookup();
+  void testCompare();
 };
 
 void IWORKStyleStackTest::setUp()
@@ -122,6 +124,32 @@ void IWORKStyleStackTest::testLookup()
   CPPUNIT_ASSERT(!context.has<Answer>());
 }
 
+void IWORKStyleStackTest::testCompare()
+{
+  IWORKPropertyMap props;
+  props.put<Answer>(42);
+  const IWORKStylePtr_t style = makeStyle(props);
+  const IWORKStylePtr_t sameContent = makeStyle(props);
+
+  IWORKStyleStack context;
+  IWORKStyleStack other;
+  CPPUNIT_ASSERT(!(context < other) && !(other < context));
+
+  // stacks with the same styles are equivalent
+  context.push(style);
+  other.push(style);
+  CPPUNIT_ASSERT(!(context < other) && !(other < context));
+
+  // styles are compared by identity, not by content
+  other.set(sameContent);
+  CPPUNIT_ASSERT((context < other) || (other < context));
+
+  // and the depth of the stack matters
+  other.set(style);
+  other.push();
+  CPPUNIT_ASSERT((context < other) || (other < context));
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(IWORKStyleStackTest);
 
 }
@@ -69,13 +69,13 @@ public:
 private:
   CPPUNIT_TEST_SUITE(IWORKStyleTest);
   CPPUNIT_TEST(testLink);
-  CPPUNIT_TEST(testFlatten);
+  CPPUNIT_TEST(testFreeze);
   CPPUNIT_TEST(testLookup);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testLink();
-  void testFlatten();
+  void testFreeze();
   void testLookup();
 };
 
@@ -166,9 +166,45 @@ void IWORKStyleTest::testLink()
   }
 }
 
-void IWORKStyleTest::testFlatten()
+void IWORKStyleTest::testFreeze()
 {
-  // TODO: implement me
+  optional<ID_t> dummyIdent;
+
+  IWORKPropertyMap grandparentProps;
+  grandparentProps.put<Answer>(1);
+  grandparentProps.put<Antwort>(2);
+  const IWORKStylePtr_t grandparent = makeStyle(grandparentProps);
+
+  IWORKPropertyMap parentProps;
+  parentProps.put<Answer>(42);
+  const IWORKStylePtr_t parent(new IWORKStyle(parentProps, dummyIdent, grandparent));
+
+  IWORKPropertyMap props;
+  props.clear<Antwort>();
+  IWORKStyle style(props, dummyIdent, parent);
+
+  // the nearest value wins, cleared properties stay cleared
+  style.freeze();
+  CPPUNIT_ASSERT(style.has<Answer>());
+  CPPUNIT_ASSERT_EQUAL(42, style.get<Answer>());
+  CPPUNIT_ASSERT(!style.has<Antwort>());
+  CPPUNIT_ASSERT(style.getPropertyMap().clears<Antwort>(true));
+
+  // lookup without parents is not affected
+  CPPUNIT_ASSERT(!style.getPropertyMap().has<Answer>(false));
+
+  // a frozen parent is used by a child
+  parent->freeze();
+  IWORKStyle child(IWORKPropertyMap(), dummyIdent, parent);
+  child.freeze();
+  CPPUNIT_ASSERT_EQUAL(42, child.get<Answer>());
+  CPPUNIT_ASSERT_EQUAL(2, child.get<Antwort>());
+
+  // changing the style drops the snapshot
+  style.getPropertyMap().put<Answer>(3);
+  CPPUNIT_ASSERT_EQUAL(3, style.get<Answer>());
+  style.getPropertyMap().put<Antwort>(4);
+  CPPUNIT_ASSERT_EQUAL(4, style.get<Antwort>());
 }
 
 void IWORKStyleTest::testLookup()
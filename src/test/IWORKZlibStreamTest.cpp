@@ -0,0 +1,117 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <string>
+
+#include <memory>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "IWORKMemoryStream.h"
+#include "IWORKZlibStream.h"
+
+using namespace libetonyek;
+
+using std::string;
+
+namespace test
+{
+
+namespace
+{
+
+void assertInflated(const string &message, const unsigned char *const expected, const size_t expectedSize, const unsigned char *const compressed, const size_t compressedSize)
+{
+  const RVNGInputStreamPtr_t stream(new IWORKMemoryStream(compressed, unsigned(compressedSize)));
+  IWORKZlibStream inflatedStream(stream);
+  unsigned long inflatedSize = 0;
+  const unsigned char *const inflated = inflatedStream.read(expectedSize + 1, inflatedSize);
+  CPPUNIT_ASSERT_MESSAGE(message + ": data", inflated);
+  CPPUNIT_ASSERT_EQUAL_MESSAGE(message + ": size", expectedSize, size_t(inflatedSize));
+  CPPUNIT_ASSERT_MESSAGE(message + ": input exhausted", inflatedStream.isEnd());
+  CPPUNIT_ASSERT_MESSAGE(message + ": content", std::equal(expected, expected + expectedSize, inflated));
+}
+
+}
+
+class IWORKZlibStreamTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(IWORKZlibStreamTest);
+  CPPUNIT_TEST(testCompressed);
+  CPPUNIT_TEST(testStored);
+  CPPUNIT_TEST(testStoredSeek);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testCompressed();
+  void testStored();
+  void testStoredSeek();
+};
+
+void IWORKZlibStreamTest::setUp()
+{
+}
+
+void IWORKZlibStreamTest::tearDown()
+{
+}
+
+#define BYTES(b) (reinterpret_cast<const unsigned char *>(b)), (sizeof(b) - 1)
+
+void IWORKZlibStreamTest::testCompressed()
+{
+  assertInflated("gzip", BYTES("hello hello hello"), BYTES(
+                   "\x1f\x8b\x8\x0\x0\x0\x0\x0\x2\xff\xcb\x48\xcd\xc9\xc9\x57"
+                   "\xc8\x40\x90\x0\x80\x88\xf9\xe5\x11\x0\x0\x0"
+                 ));
+}
+
+void IWORKZlibStreamTest::testStored()
+{
+  assertInflated("stored gzip", BYTES("abc"), BYTES("\x1f\x8b\x0" "abc"));
+  assertInflated("stored zlib", BYTES("abc"), BYTES("\x78\x0" "abc"));
+}
+
+void IWORKZlibStreamTest::testStoredSeek()
+{
+  const RVNGInputStreamPtr_t stream(new IWORKMemoryStream(BYTES("\x1f\x8b\x0" "abcdef")));
+  IWORKZlibStream storedStream(stream);
+
+  CPPUNIT_ASSERT_EQUAL(0L, storedStream.tell());
+  CPPUNIT_ASSERT_EQUAL(0, storedStream.seek(0, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT_EQUAL(6L, storedStream.tell());
+  CPPUNIT_ASSERT(storedStream.isEnd());
+  CPPUNIT_ASSERT(0 != storedStream.seek(1, librevenge::RVNG_SEEK_CUR));
+  CPPUNIT_ASSERT_EQUAL(0, storedStream.seek(-2, librevenge::RVNG_SEEK_END));
+
+  // moving the underlying stream must not affect the view
+  stream->seek(0, librevenge::RVNG_SEEK_SET);
+
+  unsigned long readBytes = 0;
+  const unsigned char *const data = storedStream.read(10, readBytes);
+  CPPUNIT_ASSERT_EQUAL(2UL, readBytes);
+  CPPUNIT_ASSERT_EQUAL('e', char(data[0]));
+  CPPUNIT_ASSERT_EQUAL('f', char(data[1]));
+  CPPUNIT_ASSERT(storedStream.isEnd());
+}
+
+#undef BYTES
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IWORKZlibStreamTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
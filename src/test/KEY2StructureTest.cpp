@@ -0,0 +1,254 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "IWORKChainedTokenizer.h"
+#include "IWORKToken.h"
+#include "KEY2Structure.h"
+#include "KEY2Token.h"
+
+namespace test
+{
+
+using libetonyek::IWORKChainedTokenizer;
+using libetonyek::KEY2Structure;
+
+using std::string;
+
+namespace
+{
+
+const string VERSION_5("92008102400");
+
+string makeDocument(const string &slides, const string &rest = string(), const string &version = VERSION_5)
+{
+  return
+    "<?xml version=\"1.0\"?>\n"
+    "<key:presentation xmlns:sfa=\"http://developer.apple.com/namespaces/sfa\" "
+    "xmlns:sf=\"http://developer.apple.com/namespaces/sf\" "
+    "xmlns:key=\"http://developer.apple.com/namespaces/keynote2\" key:version=\"" + version + "\">\n"
+    "<key:theme-list><key:theme sfa:ID=\"theme\"/></key:theme-list>\n"
+    "<key:slide-list>" + slides + "</key:slide-list>\n"
+    + rest +
+    "</key:presentation>\n";
+}
+
+bool scan(const string &document, KEY2Structure &structure)
+{
+  static IWORKChainedTokenizer tokenizer(libetonyek::KEY2Token::getTokenizer(), libetonyek::IWORKToken::getTokenizer());
+  return structure.scan(reinterpret_cast<const unsigned char *>(document.data()), document.size(), tokenizer);
+}
+
+string getSlide(const string &document, const KEY2Structure &structure, const std::size_t slide)
+{
+  const KEY2Structure::Slide &s = structure.m_slides[slide];
+  return document.substr(s.m_begin, s.m_end - s.m_begin);
+}
+
+}
+
+class KEY2StructureTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(KEY2StructureTest);
+  CPPUNIT_TEST(testPositions);
+  CPPUNIT_TEST(testGroups);
+  CPPUNIT_TEST(testLayers);
+  CPPUNIT_TEST(testUnsupported);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testPositions();
+  void testGroups();
+  void testLayers();
+  void testUnsupported();
+};
+
+void KEY2StructureTest::setUp()
+{
+}
+
+void KEY2StructureTest::tearDown()
+{
+}
+
+void KEY2StructureTest::testPositions()
+{
+  const string slide0("<key:slide sfa:ID=\"slide-0\"><key:page><sf:layers/></key:page></key:slide>");
+  const string slide1("<key:slide sfa:ID=\"slide-1\"/>");
+  const string slide2("<key:slide\n  sfa:ID=\"slide-2\" ><key:notes>a &amp; b</key:notes></key:slide  >");
+  const string slides(slide0 + "\n  " + slide1 + slide2 + "\n");
+  const string document(makeDocument(slides));
+
+  KEY2Structure structure;
+  CPPUNIT_ASSERT(scan(document, structure));
+
+  CPPUNIT_ASSERT_EQUAL(string("key:presentation"), structure.m_rootName);
+  CPPUNIT_ASSERT_EQUAL(document.find("\">\n<key:theme-list>") + 2, structure.m_rootEnd);
+  CPPUNIT_ASSERT_EQUAL(slides, document.substr(structure.m_slideListBegin, structure.m_slideListEnd - structure.m_slideListBegin));
+
+  CPPUNIT_ASSERT_EQUAL(std::size_t(3), structure.m_slides.size());
+  CPPUNIT_ASSERT_EQUAL(slide0, getSlide(document, structure, 0));
+  CPPUNIT_ASSERT_EQUAL(slide1, getSlide(document, structure, 1));
+  CPPUNIT_ASSERT_EQUAL(slide2, getSlide(document, structure, 2));
+
+  // the ID of a slide is not a reference target
+  const string rest("<key:ui-state><key:slide-ref sfa:IDREF=\"slide-1\"/></key:ui-state>\n");
+  CPPUNIT_ASSERT(scan(makeDocument(slides, rest), structure));
+}
+
+void KEY2StructureTest::testGroups()
+{
+  {
+    // independent slides
+    const string slides(
+      "<key:slide><sf:data sfa:ID=\"data-0\"/></key:slide>"
+      "<key:slide><sf:data sfa:ID=\"data-1\"/><sf:data-ref sfa:IDREF=\"theme\"/></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), structure.m_slides.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+  }
+
+  {
+    // references to an earlier slide, chained
+    const string slides(
+      "<key:slide><sf:data sfa:ID=\"data-0\"/></key:slide>"
+      "<key:slide><sf:data sfa:ID=\"data-1\"/></key:slide>"
+      "<key:slide><sf:data-ref sfa:IDREF=\"data-1\"/><sf:data sfa:ID=\"data-2\"/></key:slide>"
+      "<key:slide/>"
+      "<key:slide><sf:data-ref sfa:IDREF=\"data-2\"/></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(5), structure.m_slides.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[2].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), structure.m_slides[3].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[4].m_group);
+  }
+
+  {
+    // a reference to a later slide
+    const string slides(
+      "<key:slide/>"
+      "<key:slide><sf:data-ref sfa:IDREF=\"data-2\"/></key:slide>"
+      "<key:slide><sf:data sfa:ID=\"data-2\"/></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[2].m_group);
+  }
+
+  {
+    // a style referred to by an attribute
+    const string slides(
+      "<key:slide><sf:paragraphstyle sfa:ID=\"style-0\"/></key:slide>"
+      "<key:slide/>"
+      "<key:slide><sf:p sf:style=\"style-0\">a</sf:p></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[2].m_group);
+  }
+
+  {
+    // redefinition of an ID
+    const string slides(
+      "<key:slide><sf:data sfa:ID=\"data\"/></key:slide>"
+      "<key:slide/>"
+      "<key:slide><sf:data sfa:ID=\"data\"/></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[2].m_group);
+  }
+
+  {
+    // a placeholder of a master used by two slides
+    const string slides(
+      "<key:slide><key:title-placeholder-ref sfa:IDREF=\"title\"/></key:slide>"
+      "<key:slide><key:body-placeholder-ref sfa:IDREF=\"body\"/></key:slide>"
+      "<key:slide><key:title-placeholder-ref sfa:IDREF=\"title\"/></key:slide>"
+    );
+    KEY2Structure structure;
+    CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[0].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), structure.m_slides[1].m_group);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), structure.m_slides[2].m_group);
+  }
+}
+
+void KEY2StructureTest::testLayers()
+{
+  const string slides(
+    "<key:slide>"
+    "<key:page><sf:layers><sf:layer/><sf:layer><sf:drawables><sf:layer/></sf:drawables></sf:layer></sf:layers></key:page>"
+    "</key:slide>"
+    "<key:slide><key:page><sf:layers/></key:page></key:slide>"
+    "<key:slide><sf:layers><sf:layer/></sf:layers></key:slide>"
+  );
+  KEY2Structure structure;
+  CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+  CPPUNIT_ASSERT_EQUAL(std::size_t(3), structure.m_slides.size());
+  CPPUNIT_ASSERT_EQUAL(2u, structure.m_slides[0].m_layerCount);
+  CPPUNIT_ASSERT_EQUAL(0u, structure.m_slides[1].m_layerCount);
+  CPPUNIT_ASSERT_EQUAL(0u, structure.m_slides[2].m_layerCount);
+}
+
+void KEY2StructureTest::testUnsupported()
+{
+  KEY2Structure structure;
+  const string slides("<key:slide><sf:data sfa:ID=\"data\"/></key:slide><key:slide/>");
+
+  CPPUNIT_ASSERT(scan(makeDocument(slides), structure));
+  // a reference to a slide from the rest of the document
+  CPPUNIT_ASSERT(!scan(makeDocument(slides, "<key:ui-state><sf:data-ref sfa:IDREF=\"data\"/></key:ui-state>"), structure));
+  CPPUNIT_ASSERT(!scan(makeDocument(slides, "<key:notes><sf:p sf:style=\"data\"/></key:notes>"), structure));
+  // version 2 slides have extra layers
+  CPPUNIT_ASSERT(!scan(makeDocument(slides, string(), "2004102100"), structure));
+  CPPUNIT_ASSERT(!scan(makeDocument(slides, string(), "1"), structure));
+  // something else than a slide in the slide list
+  CPPUNIT_ASSERT(!scan(makeDocument(slides + "<key:notes/>"), structure));
+  // no slides
+  CPPUNIT_ASSERT(!scan(makeDocument(string()), structure));
+  // a broken document
+  CPPUNIT_ASSERT(!scan(makeDocument(slides + "<key:slide>"), structure));
+  const string document(makeDocument(slides));
+  CPPUNIT_ASSERT(!scan(document.substr(0, document.size() - 10), structure));
+  CPPUNIT_ASSERT(!scan(string(), structure));
+
+  // a namespace declared by the slide list
+  string withNamespace(makeDocument(slides));
+  withNamespace.insert(withNamespace.find("<key:slide-list") + 15, " xmlns:x=\"urn:x\"");
+  CPPUNIT_ASSERT(!scan(withNamespace, structure));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(KEY2StructureTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <limits>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "KEYCollector.h"
+
+namespace test
+{
+
+using libetonyek::KEYCollector;
+
+namespace
+{
+
+const unsigned MAX = std::numeric_limits<unsigned>::max();
+
+}
+
+class KEYCollectorTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(KEYCollectorTest);
+  CPPUNIT_TEST(testSlideRange);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testSlideRange();
+};
+
+void KEYCollectorTest::setUp()
+{
+}
+
+void KEYCollectorTest::tearDown()
+{
+}
+
+void KEYCollectorTest::testSlideRange()
+{
+  KEYCollector collector(nullptr);
+
+  // all slides by default
+  CPPUNIT_ASSERT(collector.isSlideInRange(0));
+  CPPUNIT_ASSERT(collector.isSlideInRange(1000));
+  CPPUNIT_ASSERT(collector.isSlideInRange(MAX - 1));
+
+  collector.setSlideRange(2, 3);
+  CPPUNIT_ASSERT(!collector.isSlideInRange(0));
+  CPPUNIT_ASSERT(!collector.isSlideInRange(1));
+  CPPUNIT_ASSERT(collector.isSlideInRange(2));
+  CPPUNIT_ASSERT(collector.isSlideInRange(4));
+  CPPUNIT_ASSERT(!collector.isSlideInRange(5));
+  CPPUNIT_ASSERT(!collector.isSlideInRange(MAX));
+
+  collector.setSlideRange(1, 0);
+  CPPUNIT_ASSERT(!collector.isSlideInRange(0));
+  CPPUNIT_ASSERT(!collector.isSlideInRange(1));
+
+  // the rest of the presentation
+  collector.setSlideRange(5, MAX);
+  CPPUNIT_ASSERT(!collector.isSlideInRange(4));
+  CPPUNIT_ASSERT(collector.isSlideInRange(5));
+  CPPUNIT_ASSERT(collector.isSlideInRange(MAX - 1));
+  CPPUNIT_ASSERT(collector.isSlideInRange(MAX));
+
+  // the first slide is beyond the end of any presentation
+  collector.setSlideRange(MAX, MAX);
+  CPPUNIT_ASSERT(!collector.isSlideInRange(0));
+  CPPUNIT_ASSERT(!collector.isSlideInRange(MAX - 1));
+  CPPUNIT_ASSERT(collector.isSlideInRange(MAX));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(KEYCollectorTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libetonyek project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <limits>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "PAGCollector.h"
+
+namespace test
+{
+
+using libetonyek::PAGCollector;
+
+namespace
+{
+
+const unsigned MAX = std::numeric_limits<unsigned>::max();
+
+}
+
+class PAGCollectorTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(PAGCollectorTest);
+  CPPUNIT_TEST(testPageRange);
+  CPPUNIT_TEST(testSectionRange);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testPageRange();
+  void testSectionRange();
+};
+
+void PAGCollectorTest::setUp()
+{
+}
+
+void PAGCollectorTest::tearDown()
+{
+}
+
+void PAGCollectorTest::testPageRange()
+{
+  PAGCollector collector(nullptr);
+
+  // all pages by default; page groups count pages from 1
+  CPPUNIT_ASSERT(collector.isPageInRange(1));
+  CPPUNIT_ASSERT(collector.isPageInRange(std::numeric_limits<int>::max()));
+  // invalid page numbers are not dropped
+  CPPUNIT_ASSERT(collector.isPageInRange(0));
+  CPPUNIT_ASSERT(collector.isPageInRange(-1));
+
+  collector.setPageRange(1, 2);
+  CPPUNIT_ASSERT(!collector.isPageInRange(1));
+  CPPUNIT_ASSERT(collector.isPageInRange(2));
+  CPPUNIT_ASSERT(collector.isPageInRange(3));
+  CPPUNIT_ASSERT(!collector.isPageInRange(4));
+  CPPUNIT_ASSERT(collector.isPageInRange(0));
+
+  collector.setPageRange(0, 0);
+  CPPUNIT_ASSERT(!collector.isPageInRange(1));
+
+  collector.setPageRange(MAX, MAX);
+  CPPUNIT_ASSERT(!collector.isPageInRange(1));
+  CPPUNIT_ASSERT(!collector.isPageInRange(std::numeric_limits<int>::max()));
+}
+
+void PAGCollectorTest::testSectionRange()
+{
+  PAGCollector collector(nullptr);
+
+  CPPUNIT_ASSERT(collector.isSectionInRange(0));
+  CPPUNIT_ASSERT(collector.isSectionInRange(MAX - 1));
+
+  // a section that starts before the range can reach into it
+  collector.setPageRange(2, 3);
+  CPPUNIT_ASSERT(collector.isSectionInRange(0));
+  CPPUNIT_ASSERT(collector.isSectionInRange(4));
+  CPPUNIT_ASSERT(!collector.isSectionInRange(5));
+  CPPUNIT_ASSERT(!collector.isSectionInRange(MAX));
+
+  collector.setPageRange(0, 1);
+  CPPUNIT_ASSERT(collector.isSectionInRange(0));
+  CPPUNIT_ASSERT(!collector.isSectionInRange(1));
+
+  collector.setPageRange(0, 0);
+  CPPUNIT_ASSERT(!collector.isSectionInRange(0));
+
+  collector.setPageRange(MAX, MAX);
+  CPPUNIT_ASSERT(collector.isSectionInRange(0));
+  CPPUNIT_ASSERT(collector.isSectionInRange(MAX));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PAGCollectorTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -12,8 +12,8 @@
 namespace libetonyek
 {
 
-const IWORKPropertyID_t IWORKPropertyInfo<property::Answer>::id = "Answer";
-const IWORKPropertyID_t IWORKPropertyInfo<property::Antwort>::id = "Antwort";
+const IWORKPropertyID_t IWORKPropertyInfo<property::Answer>::id = registerProperty("Answer");
+const IWORKPropertyID_t IWORKPropertyInfo<property::Antwort>::id = registerProperty("Antwort");
 
 }
 